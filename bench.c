@@ -0,0 +1,2092 @@
+// ================================================
+// Benchmarks for the Pokedex data structures.
+// Build & run:
+//   gcc -O2 -std=c99 -pthread bench.c -o bench && ./bench
+// ex6.c is compiled in directly (without its main) so the benchmarks
+// exercise the exact same functions the program uses.
+// ./bench --suite [filter] runs the core-operation suite instead and prints
+// one CSV row per case (ns/op, allocations/op, peak RSS) for comparing builds.
+// ================================================
+
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE // syscall(), for perf_event_open
+#define EX6_NO_MAIN
+#include "ex6.c"
+
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+// Synthetic species with IDs 1..n, so trees can be much larger than the pokedex.
+// They are the species catalog (nodes hold catalog positions); the first 151 are the pokedex.
+static PokemonData *benchData = NULL;
+static int benchDataCount = 0;
+
+// Switch between benchData and the built-in 151 species (no tree may exist across the switch)
+static void useBenchSpecies(bool bench) {
+    if (!bench)
+        freeSpeciesCatalog();
+    else if (!useSpeciesRecords(benchData, benchDataCount))
+        exit(1);
+}
+
+static void initBenchData(int n) {
+    benchData = malloc(n * sizeof(PokemonData));
+    if (benchData == NULL) {
+        printf("Memory allocation failed.\n");
+        exit(1);
+    }
+    for (int i = 0; i < n; i++) {
+        // Reuse the real species stats so fights and types stay meaningful
+        benchData[i] = pokedex[i % (sizeof(pokedex) / sizeof(pokedex[0]))];
+        benchData[i].id = i + 1;
+    }
+    benchDataCount = n;
+    useBenchSpecies(true);
+}
+
+static void freeBenchData(void) {
+    freeSpeciesCatalog();
+    free(benchData);
+}
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// The pre-AVL insertion, kept iterative so a degenerate tree can't overflow the stack
+static PokemonNode *insertPlainBST(PokemonNode *root, PokemonNode *newNode) {
+    PokemonNode **link = &root;
+    while (*link) {
+        if (newNode->species < (*link)->species)
+            link = &(*link)->left;
+        else
+            link = &(*link)->right;
+    }
+    *link = newNode;
+    return root;
+}
+
+// Frees a tree of any shape without recursion (right spine is flattened as we go)
+static void freeTreeIterative(PokemonNode *root) {
+    while (root) {
+        if (root->left) {
+            PokemonNode *left = root->left;
+            root->left = left->right;
+            left->right = root;
+            root = left;
+        } else {
+            PokemonNode *next = root->right;
+            freePokemonNode(root);
+            root = next;
+        }
+    }
+}
+
+// --------------------------------------------------------------
+// Sorted-ID insertion: AVL vs the old plain BST
+// --------------------------------------------------------------
+static void benchSortedInsert(void) {
+    printf("== sorted insert ==\n");
+    for (int n = 1000; n <= 100000; n *= 10) {
+        double start = nowSeconds();
+        PokemonNode *avl = NULL;
+        for (int i = 0; i < n; i++)
+            avl = insertPokemonNode(avl, createPokemonNode(&benchData[i]));
+        double avlTime = nowSeconds() - start;
+
+        start = nowSeconds();
+        PokemonNode *plain = NULL;
+        for (int i = 0; i < n; i++)
+            plain = insertPlainBST(plain, createPokemonNode(&benchData[i]));
+        double plainTime = nowSeconds() - start;
+
+        printf("n=%-7d avl %8.1f ns/op (height %d)   plain BST %10.1f ns/op (height %d)\n",
+               n, avlTime * 1e9 / n, BFSTreeHeight(avl), plainTime * 1e9 / n, n);
+
+        freeTreeIterative(avl);
+        freeTreeIterative(plain);
+    }
+}
+
+// Small deterministic PRNG so every run queries the same IDs
+static unsigned int benchRandState = 12345u;
+
+static unsigned int benchRand(void) {
+    benchRandState ^= benchRandState << 13;
+    benchRandState ^= benchRandState >> 17;
+    benchRandState ^= benchRandState << 5;
+    return benchRandState;
+}
+
+// --------------------------------------------------------------
+// Lookup by ID: full BFS scan vs keyed BST descent
+// --------------------------------------------------------------
+static void benchSearch(void) {
+    printf("== search by id ==\n");
+    for (int n = 1000; n <= 1000000; n *= 10) {
+        PokemonNode *root = NULL;
+        for (int i = 0; i < n; i++)
+            root = insertPokemonNode(root, createPokemonNode(&benchData[i]));
+
+        // The scan is O(n), so it gets fewer queries on big trees
+        int scanQueries = 100000000 / n < 100 ? 100 : 100000000 / n;
+        int keyedQueries = 1000000;
+        volatile PokemonNode *sink;
+
+        double start = nowSeconds();
+        for (int q = 0; q < scanQueries; q++)
+            sink = searchPokemonBFS(root, (int) (benchRand() % n) + 1);
+        double scanTime = nowSeconds() - start;
+
+        start = nowSeconds();
+        for (int q = 0; q < keyedQueries; q++)
+            sink = searchPokemonBST(root, (int) (benchRand() % n) + 1);
+        double keyedTime = nowSeconds() - start;
+        (void) sink;
+
+        printf("n=%-7d searchPokemonBFS %12.1f ns/op   searchPokemonBST %8.1f ns/op\n",
+               n, scanTime * 1e9 / scanQueries, keyedTime * 1e9 / keyedQueries);
+        freePokemonTree(root);
+    }
+}
+
+// --------------------------------------------------------------
+// Level-order traversal: per-level re-descent vs ring-buffer queue
+// --------------------------------------------------------------
+static long benchVisited = 0;
+
+static void countVisit(PokemonNode *node) {
+    (void) node;
+    benchVisited++;
+}
+
+static void countLevel(PokemonNode **nodes, int count, int level) {
+    (void) nodes;
+    (void) level;
+    benchVisited += count;
+}
+
+// The pre-queue BFSGeneric: one descent from the root per level
+static void levelByLevelBFS(PokemonNode *root, int height) {
+    for (int i = 1; i <= height; i++)
+        visitPokemonByLevel(root, i, countVisit);
+}
+
+static void benchBFSCase(const char *shape, PokemonNode *root, int n, int height, NodeQueue *queue) {
+    double start = nowSeconds();
+    levelByLevelBFS(root, height);
+    double oldTime = nowSeconds() - start;
+
+    start = nowSeconds();
+    BFSGenericQueue(root, countVisit, queue);
+    double queueTime = nowSeconds() - start;
+
+    start = nowSeconds();
+    BFSLevelsGeneric(root, countLevel, queue);
+    double levelTime = nowSeconds() - start;
+
+    printf("%-10s n=%-7d re-descent %8.1f ns/node   queue %6.1f ns/node   batched %6.1f ns/node\n",
+           shape, n, oldTime * 1e9 / n, queueTime * 1e9 / n, levelTime * 1e9 / n);
+}
+
+static void benchBFS(void) {
+    printf("== level-order traversal ==\n");
+    NodeQueue queue;
+    initNodeQueue(&queue, 16);
+
+    for (int n = 1000; n <= 1000000; n *= 10) {
+        PokemonNode *root = NULL;
+        for (int i = 0; i < n; i++)
+            root = insertPokemonNode(root, createPokemonNode(&benchData[i]));
+        benchBFSCase("balanced", root, n, BFSTreeHeight(root), &queue);
+        freePokemonTree(root);
+    }
+
+    // A sorted plain BST is a list: the re-descent is O(n^2) there
+    for (int n = 1000; n <= 10000; n *= 10) {
+        PokemonNode *root = NULL;
+        for (int i = 0; i < n; i++)
+            root = insertPlainBST(root, createPokemonNode(&benchData[i]));
+        benchBFSCase("degenerate", root, n, n, &queue);
+        freeTreeIterative(root);
+    }
+
+    freeNodeQueue(&queue);
+}
+
+// --------------------------------------------------------------
+// Bitset Pokedex: memory per owner and operation cost
+// --------------------------------------------------------------
+static void benchBitsetPokedex(void) {
+    printf("== bitset pokedex ==\n");
+    int species = (int) (sizeof(pokedex) / sizeof(pokedex[0]));
+
+    // glibc rounds every malloc of a PokemonNode up to a 16-byte multiple plus an 8-byte header
+    size_t nodeBytes = (sizeof(PokemonNode) + 8 + 15) / 16 * 16;
+    printf("tree node: %zu bytes (%zu with malloc overhead), bitset: %zu bytes inline in OwnerNode\n",
+           sizeof(PokemonNode), nodeBytes, sizeof(PokedexBits));
+    int sizes[] = { 1, 10, 50, species };
+    for (int s = 0; s < 4; s++) {
+        int k = sizes[s];
+        size_t treeBytes = k * nodeBytes;
+        printf("%3d species/owner: tree %5zu bytes, bitset %2zu bytes -> saves %5zd bytes/owner, %8.1f MB per million owners\n",
+               k, treeBytes, sizeof(PokedexBits), (ssize_t) (treeBytes - sizeof(PokedexBits)),
+               (double) (treeBytes - sizeof(PokedexBits)) * 1e6 / (1024.0 * 1024.0));
+    }
+
+    // add/contains/remove of random species, both representations
+    int ops = 10000000;
+    OwnerNode treeOwner = { 0 };
+    OwnerNode bitsOwner = { 0 };
+    bool inserted;
+    volatile const PokemonData *sink;
+
+    double start = nowSeconds();
+    for (int i = 0; i < ops; i++) {
+        int id = (int) (benchRand() % species) + 1;
+        if (i & 1) {
+            ownerAddPokemon(&treeOwner, findSpecies(id), &inserted);
+        } else {
+            sink = findOwnerPokemon(&treeOwner, id);
+            ownerRemovePokemon(&treeOwner, id);
+        }
+    }
+    double treeTime = nowSeconds() - start;
+
+    bitsetPokedexMode = true;
+    start = nowSeconds();
+    for (int i = 0; i < ops; i++) {
+        int id = (int) (benchRand() % species) + 1;
+        if (i & 1) {
+            ownerAddPokemon(&bitsOwner, findSpecies(id), &inserted);
+        } else {
+            sink = findOwnerPokemon(&bitsOwner, id);
+            ownerRemovePokemon(&bitsOwner, id);
+        }
+    }
+    double bitsTime = nowSeconds() - start;
+    bitsetPokedexMode = false;
+    (void) sink;
+
+    printf("add/find/remove mix: tree %.1f ns/op, bitset %.1f ns/op\n",
+           treeTime * 1e9 / ops, bitsTime * 1e9 / ops);
+    freeOwnerPokedex(&treeOwner);
+}
+
+// --------------------------------------------------------------
+// Merging two owners: copy + insert each node vs flatten + rebuild
+// --------------------------------------------------------------
+static PokemonNode *buildBenchTree(int n, int stride, int offset) {
+    PokemonNode *root = NULL;
+    for (int i = 0; i < n; i++)
+        root = insertPokemonNode(root, createPokemonNode(&benchData[i * stride + offset]));
+    return root;
+}
+
+static void benchMerge(void) {
+    printf("== merge ==\n");
+
+    // Warm-up: the first big array allocations after the earlier benchmarks are slow
+    freePokemonTree(mergeBSTBalanced(buildBenchTree(1000, 2, 0), buildBenchTree(1000, 2, 1)));
+
+    for (int n = 1000; n <= 100000; n *= 10) {
+        // Interleaved IDs, so the merge has to weave the two trees together
+        PokemonNode *first = buildBenchTree(n, 2, 0);
+        PokemonNode *second = buildBenchTree(n, 2, 1);
+        double start = nowSeconds();
+        first = mergeBST(first, second);
+        freePokemonTree(second);
+        double oldTime = nowSeconds() - start;
+        int oldHeight = BFSTreeHeight(first);
+        freePokemonTree(first);
+
+        first = buildBenchTree(n, 2, 0);
+        second = buildBenchTree(n, 2, 1);
+        start = nowSeconds();
+        first = mergeBSTBalanced(first, second);
+        double newTime = nowSeconds() - start;
+        int newHeight = BFSTreeHeight(first);
+        freePokemonTree(first);
+
+        printf("n=%-7d+%-7d mergeBST %8.2f ms (height %d)   mergeBSTBalanced %7.2f ms (height %d)   %.1fx\n",
+               n, n, oldTime * 1e3, oldHeight, newTime * 1e3, newHeight, oldTime / newTime);
+    }
+}
+
+// --------------------------------------------------------------
+// Owner lookup by name: ring walk vs hash index
+// --------------------------------------------------------------
+
+// The pre-index findOwnerByName: strcmp against every owner in the ring
+static OwnerNode *findOwnerByNameScan(const char *name) {
+    if (ownerHead == NULL) return NULL;
+    OwnerNode *owner = ownerHead;
+    do {
+        if (strcmp(owner->ownerName, name) == 0) return owner;
+        owner = owner->next;
+    } while (owner != ownerHead);
+    return NULL;
+}
+
+static void benchOwnerLookup(void) {
+    printf("== owner lookup by name ==\n");
+    char name[32];
+    for (int n = 1000; n <= 1000000; n *= 10) {
+        // Creating n owners includes the duplicate-name check, as openPokedexMenu does
+        double start = nowSeconds();
+        for (int i = 0; i < n; i++) {
+            sprintf(name, "Trainer%d", i);
+            if (findOwnerByName(name) == NULL)
+                linkOwnerInCircularList(createOwner(myStrdup(name), NULL));
+        }
+        double createTime = nowSeconds() - start;
+
+        int scanQueries = 100000000 / n < 100 ? 100 : 100000000 / n;
+        int indexQueries = 1000000;
+        volatile OwnerNode *sink;
+
+        start = nowSeconds();
+        for (int q = 0; q < scanQueries; q++) {
+            sprintf(name, "Trainer%u", benchRand() % n);
+            sink = findOwnerByNameScan(name);
+        }
+        double scanTime = nowSeconds() - start;
+
+        start = nowSeconds();
+        for (int q = 0; q < indexQueries; q++) {
+            sprintf(name, "Trainer%u", benchRand() % n);
+            sink = findOwnerByName(name);
+        }
+        double indexTime = nowSeconds() - start;
+        (void) sink;
+
+        printf("owners=%-7d create %6.1f ns/owner   ring scan %12.1f ns/lookup   hash index %6.1f ns/lookup\n",
+               n, createTime * 1e9 / n, scanTime * 1e9 / scanQueries, indexTime * 1e9 / indexQueries);
+        freeAllOwners();
+    }
+}
+
+// --------------------------------------------------------------
+// Replaying menu scripts: node mallocs with and without slab pools
+// --------------------------------------------------------------
+
+// Write an input.txt-style session: owners, add/release/evolve churn, merges, sort
+static void writeChurnScript(const char *path, int owners, int opsPerOwner) {
+    FILE *script = fopen(path, "w");
+    if (script == NULL) {
+        printf("Cannot write %s\n", path);
+        exit(1);
+    }
+    for (int o = 0; o < owners; o++)
+        fprintf(script, "1\nTrainer%d\n%d\n", o, o % 3 + 1);
+    for (int o = 0; o < owners; o++) {
+        fprintf(script, "2\n%d\n", o + 1);
+        for (int i = 0; i < opsPerOwner; i++) {
+            int id = (int) (benchRand() % 151) + 1;
+            int action = (int) (benchRand() % 4);
+            // Adds twice as often as releases and evolves, so trees keep growing
+            fprintf(script, "%d\n%d\n", action < 2 ? 1 : (action == 2 ? 3 : 5), id);
+        }
+        fprintf(script, "6\n");
+    }
+    for (int o = 0; o + 1 < owners; o += 2)
+        fprintf(script, "4\nTrainer%d\nTrainer%d\n", o, o + 1);
+    fprintf(script, "5\n7\n");
+    fclose(script);
+}
+
+// The same session as batch commands (same benchRand sequence from the same seed)
+static void writeBatchChurnScript(const char *path, int owners, int opsPerOwner) {
+    FILE *script = fopen(path, "w");
+    if (script == NULL) {
+        printf("Cannot write %s\n", path);
+        exit(1);
+    }
+    static const char *actions[] = { "add", "add", "release", "evolve" };
+    for (int o = 0; o < owners; o++)
+        fprintf(script, "new Trainer%d %d\n", o, o % 3 + 1);
+    for (int o = 0; o < owners; o++) {
+        for (int i = 0; i < opsPerOwner; i++) {
+            int id = (int) (benchRand() % 151) + 1;
+            int action = (int) (benchRand() % 4);
+            fprintf(script, "%s Trainer%d %d\n", actions[action], o, id);
+        }
+    }
+    for (int o = 0; o + 1 < owners; o += 2)
+        fprintf(script, "merge Trainer%d Trainer%d\n", o, o + 1);
+    fprintf(script, "sort\n");
+    fclose(script);
+}
+
+// Run mainMenu (or the batch engine) on a script with its output sent to /dev/null
+static double replayScript(const char *path, bool batch) {
+    fflush(stdout);
+    int savedStdout = dup(STDOUT_FILENO);
+    int devNull = open("/dev/null", O_WRONLY);
+    int script = open(path, O_RDONLY);
+    if (script < 0 || savedStdout < 0 || devNull < 0) {
+        printf("Cannot replay %s\n", path);
+        exit(1);
+    }
+    dup2(script, STDIN_FILENO);
+    close(script);
+    resetInputReader(&stdinReader);
+    dup2(devNull, STDOUT_FILENO);
+
+    double start = nowSeconds();
+    if (batch)
+        runBatchCommands(&stdinReader);
+    else
+        mainMenu();
+    freeAllOwners();
+    double elapsed = nowSeconds() - start;
+
+    fflush(stdout);
+    resetInputReader(&stdinReader);
+    dup2(savedStdout, STDOUT_FILENO);
+    close(savedStdout);
+    close(devNull);
+    return elapsed;
+}
+
+static void benchReplayAllocations(void) {
+    printf("== replay: PokemonNode mallocs ==\n");
+    const char *churnPath = "/tmp/ex6_bench_churn.txt";
+    writeChurnScript(churnPath, 2000, 200);
+
+    const char *scripts[] = { "input.txt", churnPath };
+    for (int s = 0; s < 2; s++) {
+        for (int pooled = 0; pooled <= 1; pooled++) {
+            nodePoolsEnabled = pooled;
+            nodeMallocCount = 0;
+            double elapsed = replayScript(scripts[s], false);
+            printf("%-28s %-9s %8ld node mallocs   %8.2f ms\n",
+                   scripts[s], pooled ? "pools" : "no pools", nodeMallocCount, elapsed * 1e3);
+        }
+    }
+    nodePoolsEnabled = true;
+    remove(churnPath);
+}
+
+// Regression check: a freed 497-512 byte owner name comes back from the arena as a node
+// slab, and freeing a node finds its slab by masking the node's address
+static void checkArenaSlabReuse(void) {
+    printf("== arena: long names reused as slabs ==\n");
+    const char *path = "/tmp/ex6_bench_slab_reuse.txt";
+    char longName[501];
+    memset(longName, 'a', 500);
+    longName[500] = '\0';
+    FILE *script = fopen(path, "w");
+    if (script == NULL) {
+        printf("Cannot write %s\n", path);
+        exit(1);
+    }
+    fprintf(script, "new %s 1\nnew Bob 1\ndelete %s\nnew Carl 1\nnew Dave 1\n", longName, longName);
+    fprintf(script, "add Dave 2\nadd Dave 3\nrelease Dave 1\nrelease Dave 2\nadd Carl 5\nadd Dave 6\n");
+    fprintf(script, "display Dave in\ndisplay Carl in\nprint F 3\n");
+    fclose(script);
+    replayScript(path, true); // crashed before the largest size class was slab-aligned
+    remove(path);
+
+    // Every block of the largest class, freed as whatever, must come back slab-aligned
+    bool aligned = true;
+    for (size_t size = NODE_SLAB_BYTES - ARENA_GRANULE + 1; size <= NODE_SLAB_BYTES; size++) {
+        void *pad = arenaAlloc(&ownerArena, ARENA_GRANULE);
+        void *name = arenaAlloc(&ownerArena, size);
+        arenaFree(&ownerArena, name, size);
+        void *slab = arenaAlloc(&ownerArena, NODE_SLAB_BYTES);
+        aligned = aligned && ((uintptr_t) slab & (NODE_SLAB_BYTES - 1)) == 0;
+        arenaFree(&ownerArena, slab, NODE_SLAB_BYTES);
+        arenaFree(&ownerArena, pad, ARENA_GRANULE);
+    }
+    printf("script ran; slabs from recycled names %s\n", aligned ? "aligned" : "MISALIGNED");
+}
+
+// --------------------------------------------------------------
+// Input: the stdio readers vs the mapped input reader
+// --------------------------------------------------------------
+
+// The pre-reader readIntSafe (fgets + trim + strtol)
+static int readIntSafeStdio(const char *prompt) {
+    char buffer[INT_BUFFER];
+    while (true) {
+        printf("%s", prompt);
+        if (!fgets(buffer, sizeof(buffer), stdin)) {
+            clearerr(stdin);
+            continue;
+        }
+        size_t len = strlen(buffer);
+        if (len > 0 && (buffer[len - 1] == '\n' || buffer[len - 1] == '\r'))
+            buffer[--len] = '\0';
+        if (len > 0 && (buffer[len - 1] == '\r' || buffer[len - 1] == '\n'))
+            buffer[--len] = '\0';
+        if (len == 0) continue;
+        char *endptr;
+        int value = (int) strtol(buffer, &endptr, 10);
+        if (*endptr == '\0') return value;
+    }
+}
+
+// The pre-reader getDynamicInput (getchar into a doubling buffer)
+static char *getDynamicInputStdio(void) {
+    size_t size = 0, capacity = 1;
+    char *input = malloc(capacity);
+    int c;
+    while ((c = getchar()) != '\n' && c != EOF) {
+        if (size + 1 >= capacity) {
+            capacity *= 2;
+            input = realloc(input, capacity);
+        }
+        input[size++] = (char) c;
+    }
+    input[size] = '\0';
+    trimWhitespace(input);
+    return input;
+}
+
+// Read 'lines' alternating integer/name lines from path; returns seconds and a checksum
+static double readScriptLines(const char *path, int lines, bool reader, long *checksum) {
+    int script = open(path, O_RDONLY);
+    if (script < 0) {
+        printf("Cannot read %s\n", path);
+        exit(1);
+    }
+    dup2(script, STDIN_FILENO);
+    close(script);
+    if (reader) {
+        resetInputReader(&stdinReader);
+    } else {
+        clearerr(stdin);
+        fseek(stdin, 0, SEEK_SET);
+    }
+
+    *checksum = 0;
+    double start = nowSeconds();
+    for (int i = 0; i < lines; i += 2) {
+        *checksum += reader ? readIntSafe("") : readIntSafeStdio("");
+        char *name = reader ? getDynamicInput() : getDynamicInputStdio();
+        *checksum += (long) strlen(name) * 31 + name[0];
+        free(name);
+    }
+    double elapsed = nowSeconds() - start;
+    resetInputReader(&stdinReader);
+    return elapsed;
+}
+
+static void benchInputReader(void) {
+    printf("== input: stdio readers vs mapped reader ==\n");
+    const char *path = "/tmp/ex6_bench_input.txt";
+    int lines = 2000000;
+    FILE *script = fopen(path, "w");
+    if (script == NULL) {
+        printf("Cannot write %s\n", path);
+        exit(1);
+    }
+    // Numbers with CRLF endings and names with stray blanks, like pasted input
+    for (int i = 0; i < lines; i += 2)
+        fprintf(script, "%d\r\n  Trainer%u \t\r\n", (int) (benchRand() % 1000) - 10, benchRand() % 100000);
+    fclose(script);
+
+    long stdioSum, readerSum;
+    double stdioTime = readScriptLines(path, lines, false, &stdioSum);
+    double readerTime = readScriptLines(path, lines, true, &readerSum);
+    printf("%d lines   stdio %8.2f ms   reader %8.2f ms   %5.1fx   %s\n", lines, stdioTime * 1e3,
+           readerTime * 1e3, stdioTime / readerTime, stdioSum == readerSum ? "same values" : "DIFFERENT");
+    remove(path);
+}
+
+// --------------------------------------------------------------
+// Batch commands vs menu replay of the same session
+// --------------------------------------------------------------
+static void benchBatchCommands(void) {
+    printf("== batch commands vs menu replay ==\n");
+    const char *menuPath = "/tmp/ex6_bench_menu.txt";
+    const char *batchPath = "/tmp/ex6_bench_batch.txt";
+    for (int owners = 2000; owners <= 20000; owners *= 10) {
+        int opsPerOwner = 100;
+        long ops = (long) owners * (opsPerOwner + 1) + owners / 2 + 1;
+        benchRandState = 777u;
+        writeChurnScript(menuPath, owners, opsPerOwner);
+        benchRandState = 777u;
+        writeBatchChurnScript(batchPath, owners, opsPerOwner);
+
+        double batchTime = replayScript(batchPath, true);
+        printf("%8ld ops   batch %8.2f ms (%6.2f Mops/s)", ops, batchTime * 1e3, ops / batchTime / 1e6);
+
+        // Entering a Pokedex lists every owner, so the menu replay is quadratic: small runs only
+        if (owners <= 2000) {
+            double menuTime = replayScript(menuPath, false);
+            printf("   menu %8.2f ms (%6.2f Mops/s)", menuTime * 1e3, ops / menuTime / 1e6);
+        }
+        printf("\n");
+    }
+    remove(menuPath);
+    remove(batchPath);
+}
+
+// --------------------------------------------------------------
+// Full-pokedex dumps: printf per node vs the output sink
+// --------------------------------------------------------------
+
+// The pre-sink printPokemonNode
+static void printPokemonNodePrintf(PokemonNode *node) {
+    printf("ID: %d, Name: %s, Type: %s, HP: %d, Attack: %d, Can Evolve: %s\n",
+           nodeData(node)->id,
+           nodeData(node)->name,
+           getTypeName(nodeData(node)->TYPE),
+           nodeData(node)->hp,
+           nodeData(node)->attack,
+           (nodeData(node)->CAN_EVOLVE == CAN_EVOLVE) ? "Yes" : "No");
+}
+
+// In-order dump of every tree (repeats times) into path with stdout redirected there; returns seconds
+static double dumpTreesTo(const char *path, PokemonNode **roots, int trees, int repeats, bool sink) {
+    fflush(stdout);
+    int savedStdout = dup(STDOUT_FILENO);
+    int target = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (savedStdout < 0 || target < 0) {
+        printf("Cannot write %s\n", path);
+        exit(1);
+    }
+    dup2(target, STDOUT_FILENO);
+
+    double start = nowSeconds();
+    for (int r = 0; r < repeats; r++) {
+        for (int t = 0; t < trees; t++) {
+            if (sink)
+                inOrderTraversal(roots[t]);
+            else
+                inOrderGeneric(roots[t], printPokemonNodePrintf);
+        }
+    }
+    fflush(stdout);
+    double elapsed = nowSeconds() - start;
+
+    dup2(savedStdout, STDOUT_FILENO);
+    close(savedStdout);
+    close(target);
+    return elapsed;
+}
+
+static bool sameFileContents(const char *firstPath, const char *secondPath) {
+    FILE *first = fopen(firstPath, "rb");
+    FILE *second = fopen(secondPath, "rb");
+    bool same = first != NULL && second != NULL;
+    while (same) {
+        int a = getc(first), b = getc(second);
+        if (a != b) same = false;
+        if (a == EOF) break;
+    }
+    if (first) fclose(first);
+    if (second) fclose(second);
+    return same;
+}
+
+// Time both dumps on /dev/null after checking their output matches byte for byte
+static void compareDumps(const char *label, PokemonNode **roots, int trees, int repeats) {
+    const char *printfPath = "/tmp/ex6_bench_printf.txt";
+    const char *sinkPath = "/tmp/ex6_bench_sink.txt";
+    dumpTreesTo(printfPath, roots, trees, 1, false);
+    dumpTreesTo(sinkPath, roots, trees, 1, true);
+    bool same = sameFileContents(printfPath, sinkPath);
+    remove(printfPath);
+    remove(sinkPath);
+
+    double printfTime = dumpTreesTo("/dev/null", roots, trees, repeats, false);
+    double sinkTime = dumpTreesTo("/dev/null", roots, trees, repeats, true);
+    printf("%-34s printf %8.2f ms   sink %8.2f ms   %5.1fx   output %s\n",
+           label, printfTime * 1e3, sinkTime * 1e3, printfTime / sinkTime, same ? "identical" : "DIFFERENT");
+}
+
+static void benchOutputSink(void) {
+    printf("== full pokedex dump (in-order) ==\n");
+
+    // A complete Pokedex (all 151 species), dumped 10^4 times
+    PokemonNode *full = NULL;
+    for (int i = 0; i < 151; i++)
+        full = insertPokemonNode(full, createPokemonNode(findSpecies(i + 1)));
+    compareDumps("151 species x 10000 dumps", &full, 1, 10000);
+    freePokemonTree(full);
+
+    // One huge synthetic tree (IDs up to 10^6, so wider numbers)
+    for (int n = 10000; n <= 1000000; n *= 10) {
+        char label[64];
+        sprintf(label, "synthetic tree n=%d", n);
+        PokemonNode *root = buildBenchTree(n, 1, 0);
+        compareDumps(label, &root, 1, 1);
+        freePokemonTree(root);
+    }
+}
+
+// --------------------------------------------------------------
+// Exit teardown: owner-by-owner frees vs dropping the arena
+// --------------------------------------------------------------
+static void buildBenchRegistry(int owners, int pokemonPerOwner) {
+    char name[32];
+    bool inserted;
+    for (int o = 0; o < owners; o++) {
+        sprintf(name, "Trainer%d", o);
+        OwnerNode *owner = createOwner(myStrdup(name), NULL);
+        for (int i = 0; i < pokemonPerOwner; i++)
+            ownerAddPokemon(owner, findSpecies((int) (benchRand() % 151) + 1), &inserted);
+        linkOwnerInCircularList(owner);
+    }
+}
+
+static void benchTeardown(void) {
+    printf("== exit teardown ==\n");
+    for (int owners = 10000; owners <= 1000000; owners *= 10) {
+        buildBenchRegistry(owners, 10);
+        double start = nowSeconds();
+        freeAllOwners();
+        double pieceTime = nowSeconds() - start;
+
+        buildBenchRegistry(owners, 10);
+        start = nowSeconds();
+        fastExitOwners();
+        double fastTime = nowSeconds() - start;
+
+        printf("owners=%-7d x10 pokemon   freeAllOwners %9.2f ms   fastExitOwners %7.2f ms\n",
+               owners, pieceTime * 1e3, fastTime * 1e3);
+    }
+}
+
+// --------------------------------------------------------------
+// Snapshots: rebuild by inserting vs save + mmap load
+// --------------------------------------------------------------
+static void benchSnapshot(void) {
+    printf("== snapshot save/load ==\n");
+    const char *path = "/tmp/ex6_bench_snapshot.bin";
+    for (int owners = 10000; owners <= 1000000; owners *= 10) {
+        double start = nowSeconds();
+        buildBenchRegistry(owners, 10);
+        double buildTime = nowSeconds() - start;
+
+        start = nowSeconds();
+        saveOwners(path);
+        double saveTime = nowSeconds() - start;
+        freeAllOwners();
+
+        start = nowSeconds();
+        int loaded = loadOwners(path);
+        double loadTime = nowSeconds() - start;
+
+        FILE *file = fopen(path, "rb");
+        long bytes = 0;
+        if (file != NULL) {
+            fseek(file, 0, SEEK_END);
+            bytes = ftell(file);
+            fclose(file);
+        }
+        printf("owners=%-7d x10 pokemon   insert %9.2f ms   save %8.2f ms   load %8.2f ms   %6.1f MB   %s\n",
+               owners, buildTime * 1e3, saveTime * 1e3, loadTime * 1e3, bytes / 1e6,
+               loaded == owners ? "all loaded" : "MISSING OWNERS");
+        freeAllOwners();
+    }
+    remove(path);
+}
+
+// --------------------------------------------------------------
+// Journal: per-change cost of each sync policy, and recovery time
+// --------------------------------------------------------------
+
+// Add or release a random Pokemon of a random owner, logging it like the menus do
+static double journalChurn(OwnerNode **owners, int ownerTotal, int ops) {
+    bool inserted;
+    double start = nowSeconds();
+    for (int i = 0; i < ops; i++) {
+        OwnerNode *owner = owners[benchRand() % ownerTotal];
+        int id = benchRand() % 151 + 1;
+        if (findOwnerPokemon(owner, id) != NULL) {
+            ownerRemovePokemon(owner, id);
+            journalRecord(JOURNAL_RELEASE, owner->ownerName, NULL, id);
+        } else {
+            ownerAddPokemon(owner, findSpecies(id), &inserted);
+            journalRecord(JOURNAL_ADD, owner->ownerName, NULL, id);
+        }
+    }
+    return nowSeconds() - start;
+}
+
+static void benchJournal(void) {
+    printf("== journal ==\n");
+    const char *path = "/tmp/ex6_bench_journal";
+    const char *snapshotPath = "/tmp/ex6_bench_journal.snap";
+    const int ownerTotal = 10000;
+    const struct { const char *label; int syncMs; int ops; } policies[] = {
+        { "no journal", 0, 1000000 },
+        { "never fsync (-1)", -1, 1000000 },
+        { "group commit 5 ms", 5, 1000000 },
+        { "fsync every change (0)", 0, 2000 },
+    };
+
+    for (size_t p = 0; p < sizeof(policies) / sizeof(policies[0]); p++) {
+        remove(path);
+        remove(snapshotPath);
+        buildBenchRegistry(ownerTotal, 10);
+        OwnerNode **owners = malloc(ownerTotal * sizeof(OwnerNode *));
+        if (owners == NULL) {
+            printf("Memory allocation failed.\n");
+            exit(1);
+        }
+        OwnerNode *current = ownerHead;
+        for (int o = 0; o < ownerTotal; o++, current = current->next)
+            owners[o] = current;
+
+        // Start from a checkpoint of the registry, then log only the churn
+        bool journaled = p > 0;
+        journal.syncMs = policies[p].syncMs;
+        journal.checkpointEvery = 0;
+        if (journaled) {
+            openJournal(path);
+            checkpointJournal();
+        }
+        double elapsed = journalChurn(owners, ownerTotal, policies[p].ops);
+        if (journaled) closeJournal();
+        free(owners);
+        printf("%-24s %8d changes   %9.1f ns/change\n", policies[p].label, policies[p].ops,
+               elapsed * 1e9 / policies[p].ops);
+
+        // Recovery = load the checkpoint + replay every logged change
+        freeAllOwners();
+        if (journaled) {
+            double start = nowSeconds();
+            openJournal(path);
+            double recoverTime = nowSeconds() - start;
+            closeJournal();
+            printf("%-24s recovery (checkpoint + %d records) %9.2f ms\n", "", policies[p].ops, recoverTime * 1e3);
+            freeAllOwners();
+        }
+    }
+    journal.syncMs = 5;
+    journal.checkpointEvery = 100000;
+    remove(path);
+    remove(snapshotPath);
+}
+
+// --------------------------------------------------------------
+// Threads sharing the owners: ring lock + per-owner locks
+// --------------------------------------------------------------
+#define STRESS_OWNERS 4096
+#define STRESS_OWN_MAX 64
+
+static char stressNames[STRESS_OWNERS][16];
+
+typedef struct
+{
+    int thread;
+    long ops;
+    unsigned int seed;
+} StressWorker;
+
+static unsigned int stressRand(unsigned int *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+// 96% Pokedex changes on one owner, 2% two-owner moves, 2% new/deleted owners
+static void *stressWorker(void *arg) {
+    StressWorker *worker = arg;
+    unsigned int state = worker->seed;
+    OwnerNode *mine[STRESS_OWN_MAX];
+    int mineCount = 0, created = 0;
+    char name[32];
+    bool inserted;
+
+    for (long i = 0; i < worker->ops; i++) {
+        unsigned int kind = stressRand(&state) % 100;
+        int id = stressRand(&state) % 151 + 1;
+        if (kind < 2) {
+            // Ring changes: this thread's own owners, so only it ever retires them
+            if (mineCount < STRESS_OWN_MAX && (kind == 0 || mineCount == 0)) {
+                sprintf(name, "Stress%d_%d", worker->thread, created++);
+                OwnerNode *owner = createOwnerWithName(name, strlen(name));
+                if (owner == NULL) continue;
+                ownerAddPokemon(owner, findSpecies(id), &inserted);
+                linkOwnerInCircularList(owner);
+                mine[mineCount++] = owner;
+            } else {
+                OwnerNode *owner = mine[--mineCount];
+                if (retireOwner(owner))
+                    removeOwnerFromCircularList(owner);
+            }
+        } else if (kind < 4) {
+            // Move a Pokemon between two owners: both locked, in address order
+            readLockOwners();
+            OwnerNode *from = findOwnerByName(stressNames[stressRand(&state) % STRESS_OWNERS]);
+            OwnerNode *to = findOwnerByName(stressNames[stressRand(&state) % STRESS_OWNERS]);
+            lockOwnerPair(from, to);
+            if (from != to && findOwnerPokemon(from, id) != NULL) {
+                ownerRemovePokemon(from, id);
+                ownerAddPokemon(to, findSpecies(id), &inserted);
+            }
+            unlockOwnerPair(from, to);
+            unlockOwners();
+        } else {
+            // Add or release on one owner
+            readLockOwners();
+            OwnerNode *owner = findOwnerByName(stressNames[stressRand(&state) % STRESS_OWNERS]);
+            lockOwner(owner);
+            if (findOwnerPokemon(owner, id) != NULL)
+                ownerRemovePokemon(owner, id);
+            else
+                ownerAddPokemon(owner, findSpecies(id), &inserted);
+            unlockOwner(owner);
+            unlockOwners();
+        }
+    }
+
+    while (mineCount > 0) {
+        OwnerNode *owner = mine[--mineCount];
+        if (retireOwner(owner))
+            removeOwnerFromCircularList(owner);
+    }
+    return NULL;
+}
+
+// Ring, registry and name index all agree on the STRESS_OWNERS owners left
+static bool stressRegistryIntact(void) {
+    int ringCount = 0;
+    OwnerNode *current = ownerHead;
+    do {
+        ringCount++;
+        if (current->next->prev != current) return false;
+        current = current->next;
+    } while (current != ownerHead);
+    if (ringCount != STRESS_OWNERS || ownerCount() != STRESS_OWNERS) return false;
+    for (int o = 0; o < STRESS_OWNERS; o++) {
+        if (findOwnerByName(stressNames[o]) == NULL) return false;
+    }
+    return true;
+}
+
+static void benchConcurrentOwners(void) {
+    printf("== threads sharing the owners (%ld cores online) ==\n", sysconf(_SC_NPROCESSORS_ONLN));
+    const long totalOps = 4000000;
+    for (int o = 0; o < STRESS_OWNERS; o++)
+        sprintf(stressNames[o], "Trainer%d", o);
+
+    double baseRate = 0.0;
+    for (int threads = 1; threads <= 32; threads *= 2) {
+        buildBenchRegistry(STRESS_OWNERS, 10);
+        pthread_t ids[32];
+        StressWorker workers[32];
+        double start = nowSeconds();
+        for (int t = 0; t < threads; t++) {
+            workers[t].thread = t;
+            workers[t].ops = totalOps / threads;
+            workers[t].seed = 2463534242u + 7919u * (unsigned int) t;
+            pthread_create(&ids[t], NULL, stressWorker, &workers[t]);
+        }
+        for (int t = 0; t < threads; t++)
+            pthread_join(ids[t], NULL);
+        double elapsed = nowSeconds() - start;
+
+        double rate = totalOps / elapsed;
+        if (threads == 1) baseRate = rate;
+        printf("threads=%-3d %8.2f M ops/s   x%5.2f   %s\n", threads, rate / 1e6, rate / baseRate,
+               stressRegistryIntact() ? "registry intact" : "REGISTRY CORRUPTED");
+        freeAllOwners();
+    }
+}
+
+// --------------------------------------------------------------
+// Epoch reads: lock-free readers vs locked readers, under writers
+// --------------------------------------------------------------
+#define EPOCH_BENCH_OWNERS 4096
+
+static int epochBenchStop = 0;
+static __thread long readerVisited = 0;
+
+typedef struct
+{
+    unsigned int seed;
+    long ops;
+    long checksum;
+} EpochBenchThread;
+
+static void countReaderVisit(PokemonNode *node) {
+    readerVisited += nodeId(node);
+}
+
+// One read of one owner: a full in-order walk, a BST lookup, a DFS search or a fight's two lookups
+static long epochBenchRead(OwnerNode *owner, unsigned int kind, int id) {
+    PokemonNode *root = __atomic_load_n(&owner->pokedexRoot, __ATOMIC_ACQUIRE);
+    switch (kind % 4) {
+        case 0:
+            readerVisited = 0;
+            inOrderGeneric(root, countReaderVisit);
+            return readerVisited;
+        case 1:
+            return findOwnerPokemon(owner, id) != NULL;
+        case 2:
+            return searchPokemonBFS(root, id) != NULL;
+        default: {
+            const PokemonData *first = findOwnerPokemon(owner, id);
+            const PokemonData *second = findOwnerPokemon(owner, id % 151 + 1);
+            if (first == NULL || second == NULL) return 0;
+            return first->attack * 3 + first->hp * 2 > second->attack * 3 + second->hp * 2;
+        }
+    }
+}
+
+static void *epochBenchReader(void *arg) {
+    EpochBenchThread *reader = arg;
+    unsigned int state = reader->seed;
+    while (!__atomic_load_n(&epochBenchStop, __ATOMIC_RELAXED)) {
+        const char *name = stressNames[stressRand(&state) % EPOCH_BENCH_OWNERS];
+        unsigned int kind = stressRand(&state);
+        int id = stressRand(&state) % 151 + 1;
+        if (epochReadsMode) {
+            epochEnter();
+            OwnerNode *owner = findOwnerByNameEpoch(name);
+            reader->checksum += epochBenchRead(owner, kind, id);
+            epochExit();
+        } else {
+            readLockOwners();
+            OwnerNode *owner = findOwnerByName(name);
+            lockOwner(owner);
+            reader->checksum += epochBenchRead(owner, kind, id);
+            unlockOwner(owner);
+            unlockOwners();
+        }
+        reader->ops++;
+    }
+    return NULL;
+}
+
+// Add or release on one owner, as fast as the locks allow
+static void *epochBenchWriter(void *arg) {
+    EpochBenchThread *writer = arg;
+    unsigned int state = writer->seed;
+    bool inserted;
+    while (!__atomic_load_n(&epochBenchStop, __ATOMIC_RELAXED)) {
+        int id = stressRand(&state) % 151 + 1;
+        readLockOwners();
+        OwnerNode *owner = findOwnerByName(stressNames[stressRand(&state) % EPOCH_BENCH_OWNERS]);
+        lockOwner(owner);
+        if (findOwnerPokemon(owner, id) != NULL)
+            ownerRemovePokemon(owner, id);
+        else
+            ownerAddPokemon(owner, findSpecies(id), &inserted);
+        unlockOwner(owner);
+        unlockOwners();
+        writer->ops++;
+    }
+    return NULL;
+}
+
+// Reads and writes per second over a fixed window
+static void epochBenchRun(int readers, int writers, double *readRate, double *writeRate) {
+    pthread_t ids[64];
+    EpochBenchThread threads[64];
+    int total = readers + writers;
+    __atomic_store_n(&epochBenchStop, 0, __ATOMIC_RELAXED);
+    for (int t = 0; t < total; t++) {
+        threads[t] = (EpochBenchThread) { 2463534242u + 7919u * (unsigned int) t, 0, 0 };
+        pthread_create(&ids[t], NULL, t < readers ? epochBenchReader : epochBenchWriter, &threads[t]);
+    }
+    double start = nowSeconds();
+    struct timespec window = { 0, 500 * 1000 * 1000 };
+    nanosleep(&window, NULL);
+    __atomic_store_n(&epochBenchStop, 1, __ATOMIC_RELAXED);
+    for (int t = 0; t < total; t++)
+        pthread_join(ids[t], NULL);
+    double elapsed = nowSeconds() - start;
+
+    long reads = 0, writes = 0;
+    for (int t = 0; t < total; t++) {
+        if (t < readers)
+            reads += threads[t].ops;
+        else
+            writes += threads[t].ops;
+    }
+    *readRate = reads / elapsed;
+    *writeRate = writes / elapsed;
+}
+
+static void benchEpochReads(void) {
+    printf("== lock-free epoch readers vs locked readers (%ld cores online) ==\n", sysconf(_SC_NPROCESSORS_ONLN));
+    for (int o = 0; o < EPOCH_BENCH_OWNERS; o++)
+        sprintf(stressNames[o], "Trainer%d", o);
+
+    const int writerCounts[] = { 0, 1, 4 };
+    for (int w = 0; w < 3; w++) {
+        for (int readers = 1; readers <= 32; readers *= 4) {
+            double rates[2][2];
+            for (int mode = 0; mode < 2; mode++) {
+                epochReadsMode = mode == 1;
+                buildBenchRegistry(EPOCH_BENCH_OWNERS, 60);
+                epochBenchRun(readers, writerCounts[w], &rates[mode][0], &rates[mode][1]);
+                freeAllOwners();
+            }
+            printf("readers=%-3d writers=%d   locked %7.2f M reads/s %6.2f M writes/s   "
+                   "epoch %7.2f M reads/s %6.2f M writes/s   reads x%5.2f\n",
+                   readers, writerCounts[w], rates[0][0] / 1e6, rates[0][1] / 1e6,
+                   rates[1][0] / 1e6, rates[1][1] / 1e6, rates[1][0] / rates[0][0]);
+        }
+    }
+    epochReadsMode = false;
+}
+
+// --------------------------------------------------------------
+// Batch fights: one pair at a time vs score table + vector kernel
+// --------------------------------------------------------------
+static const char *fightKernelName(void) {
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(__SSE2__)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+// pokemonFight's work for one pair, minus the printing
+static int fightOnePair(OwnerNode *owner, int firstId, int secondId) {
+    const PokemonData *first = findOwnerPokemon(owner, firstId);
+    const PokemonData *second = findOwnerPokemon(owner, secondId);
+    double firstScore = first->attack * 1.5 + first->hp * 1.2;
+    double secondScore = second->attack * 1.5 + second->hp * 1.2;
+    return (firstScore > secondScore) - (firstScore < secondScore);
+}
+
+static void benchFightScores(void) {
+    printf("== batch fights (%s kernel) ==\n", fightKernelName());
+
+    // Every pair of a full 151-species Pokedex
+    OwnerNode *owner = createOwner(myStrdup("Fighter"), NULL);
+    bool inserted;
+    for (int id = 1; id <= 151; id++)
+        ownerAddPokemon(owner, findSpecies(id), &inserted);
+    const int rounds = 200;
+    long pairs = 151L * 150 / 2 * rounds, pairSum = 0, tableSum = 0;
+
+    double start = nowSeconds();
+    for (int r = 0; r < rounds; r++) {
+        for (int first = 1; first <= 151; first++) {
+            for (int second = first + 1; second <= 151; second++)
+                pairSum += fightOnePair(owner, first, second);
+        }
+    }
+    double pairTime = nowSeconds() - start;
+
+    signed char outcomes[151];
+    start = nowSeconds();
+    for (int r = 0; r < rounds; r++) {
+        FightTable table;
+        buildFightTable(owner, &table);
+        for (int i = 0; i < table.count; i++) {
+            compareFightScores(table.scores, table.count, i, outcomes);
+            for (int j = i + 1; j < table.count; j++)
+                tableSum += outcomes[j];
+        }
+        freeFightTable(&table);
+    }
+    double tableTime = nowSeconds() - start;
+    printf("all pairs of 151     one at a time %6.2f ns/pair   table+kernel %6.2f ns/pair   x%5.1f   %s\n",
+           pairTime / pairs * 1e9, tableTime / pairs * 1e9, pairTime / tableTime,
+           pairSum == tableSum ? "same outcomes" : "OUTCOMES DIFFER");
+
+    FightMatchup top[10];
+    start = nowSeconds();
+    FightTable table;
+    buildFightTable(owner, &table);
+    int found = topFightMatchups(&table, 10, top);
+    printf("top-10 of 11325      %8.1f us   widest gap %.2f\n", (nowSeconds() - start) * 1e6,
+           found > 0 ? top[0].margin : 0.0);
+    freeFightTable(&table);
+    freeOwnerNode(owner);
+
+    // The score kernel alone over a million synthetic species
+    const int n = 1000000;
+    int32_t *attack = malloc(n * sizeof(int32_t));
+    int32_t *hp = malloc(n * sizeof(int32_t));
+    double *scores = malloc(n * sizeof(double));
+    for (int i = 0; i < n; i++) {
+        attack[i] = benchData[i].attack;
+        hp[i] = benchData[i].hp;
+        scores[i] = 0.0;
+    }
+    start = nowSeconds();
+    for (int i = 0; i < n; i++)
+        scores[i] = benchData[i].attack * 1.5 + benchData[i].hp * 1.2;
+    double scalarTime = nowSeconds() - start;
+    double check = scores[n - 1];
+    start = nowSeconds();
+    computeFightScores(attack, hp, scores, n);
+    double kernelTime = nowSeconds() - start;
+    printf("scores for 10^6      from structs %6.2f ns/score   kernel %6.2f ns/score   %s\n",
+           scalarTime / n * 1e9, kernelTime / n * 1e9, check == scores[n - 1] ? "same scores" : "SCORES DIFFER");
+    free(attack);
+    free(hp);
+    free(scores);
+}
+
+// --------------------------------------------------------------
+// Depth-first traversal: recursion vs TreeCursor, balanced and degenerate
+// --------------------------------------------------------------
+// The pre-cursor inOrderGeneric: one C stack frame per level
+static void recursiveInOrder(PokemonNode *root, VisitNodeFunc visit) {
+    if (!root) return;
+    recursiveInOrder(root->left, visit);
+    visit(root);
+    recursiveInOrder(root->right, visit);
+}
+
+// Links benchData[0..n) into a list: every node hangs off the previous one's left (or right)
+static PokemonNode *buildChainTree(int n, bool leftSpine) {
+    PokemonNode *root = NULL;
+    for (int i = 0; i < n; i++) {
+        PokemonNode *node = createPokemonNode(&benchData[leftSpine ? i : n - 1 - i]);
+        if (leftSpine) node->left = root;
+        else node->right = root;
+        root = node;
+    }
+    return root;
+}
+
+static bool countUntil(PokemonNode *node, void *ctx) {
+    long *remaining = ctx;
+    (void) node;
+    return --*remaining > 0;
+}
+
+static double cursorWalk(PokemonNode *root, TraversalOrder order) {
+    double start = nowSeconds();
+    TreeCursor cursor;
+    treeCursorInit(&cursor, root, order);
+    while (treeCursorNext(&cursor) != NULL) benchVisited++;
+    treeCursorFree(&cursor);
+    return nowSeconds() - start;
+}
+
+static void benchTraversalCase(const char *shape, PokemonNode *root, int n, bool recursive) {
+    // Untimed warm-up: the first big stack growth after freeing the previous tree
+    // pays for glibc consolidating its freed chunks
+    cursorWalk(root, TRAVERSE_IN);
+
+    double recursiveTime = 0;
+    if (recursive) {
+        double start = nowSeconds();
+        recursiveInOrder(root, countVisit);
+        recursiveTime = nowSeconds() - start;
+    }
+    double preTime = cursorWalk(root, TRAVERSE_PRE);
+    double inTime = cursorWalk(root, TRAVERSE_IN);
+    double postTime = cursorWalk(root, TRAVERSE_POST);
+
+    // Early exit: the visitor stops the walk halfway
+    long remaining = n / 2;
+    double start = nowSeconds();
+    traverseTree(root, TRAVERSE_IN, countUntil, &remaining);
+    double halfTime = nowSeconds() - start;
+
+    if (recursive)
+        printf("%-11s n=%-7d recursive in %5.1f ns/node", shape, n, recursiveTime * 1e9 / n);
+    else
+        printf("%-11s n=%-7d recursive in   (n/a)     ", shape, n);
+    printf("   cursor pre %5.1f  in %5.1f  post %5.1f ns/node   half-walk %6.2f ms\n",
+           preTime * 1e9 / n, inTime * 1e9 / n, postTime * 1e9 / n, halfTime * 1e3);
+}
+
+static void benchTraversal(void) {
+    printf("== depth-first traversal ==\n");
+    int n = 1000000;
+    PokemonNode *root = buildBenchTree(n, 1, 0);
+    benchTraversalCase("balanced", root, n, true);
+    freePokemonTree(root);
+
+    // A 10^6-deep list overflows an 8 MB C stack when walked recursively; only
+    // the shallower lists get the recursive comparison
+    for (int depth = 10000; depth <= n; depth *= 10) {
+        bool recursive = depth <= 10000;
+        root = buildChainTree(depth, true);
+        benchTraversalCase("left-list", root, depth, recursive);
+        freePokemonTree(root);
+        root = buildChainTree(depth, false);
+        benchTraversalCase("right-list", root, depth, recursive);
+        freePokemonTree(root);
+    }
+}
+
+// --------------------------------------------------------------
+// Alphabetical display: per-call qsort vs the precomputed name ranks
+// --------------------------------------------------------------
+// The pre-rank displayAlphabetical: gather into a NodeArray sized to the height, qsort by strcmp
+static void displayAlphabeticalQsort(PokemonNode *root) {
+    if (!root) return;
+    NodeArray array;
+    initNodeArray(&array, BFSTreeHeight(root));
+    collectAll(root, &array);
+    qsort(array.nodes, array.size, sizeof(PokemonNode *), compareByNameNode);
+    for (int i = 0; i < array.size; i++)
+        printPokemonNode(array.nodes[i]);
+    flushOutputSink();
+    free(array.nodes);
+}
+
+enum { ALPHA_QSORT, ALPHA_RANKS, ALPHA_RANK_BITS };
+
+// Alphabetical display (repeats times) with stdout redirected to path; returns seconds
+static double alphabeticalTo(const char *path, PokemonNode *root, const PokedexBits *bits, int kind, int repeats) {
+    fflush(stdout);
+    int savedStdout = dup(STDOUT_FILENO);
+    int target = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (savedStdout < 0 || target < 0) {
+        printf("Cannot write %s\n", path);
+        exit(1);
+    }
+    dup2(target, STDOUT_FILENO);
+
+    double start = nowSeconds();
+    for (int r = 0; r < repeats; r++) {
+        if (kind == ALPHA_QSORT)
+            displayAlphabeticalQsort(root);
+        else if (kind == ALPHA_RANKS)
+            displayAlphabetical(root);
+        else
+            displayAlphabeticalBits(bits);
+    }
+    fflush(stdout);
+    double elapsed = nowSeconds() - start;
+
+    dup2(savedStdout, STDOUT_FILENO);
+    close(savedStdout);
+    close(target);
+    return elapsed;
+}
+
+static void benchAlphabetical(void) {
+    printf("== alphabetical display ==\n");
+    const char *qsortPath = "/tmp/ex6_bench_qsort.txt";
+    const char *rankPath = "/tmp/ex6_bench_rank.txt";
+    const char *bitsPath = "/tmp/ex6_bench_bits.txt";
+    int repeats = 20000;
+
+    int sizes[] = { 10, 40, SPECIES_COUNT };
+    for (int s = 0; s < 3; s++) {
+        int size = sizes[s];
+        // A random Pokedex of size species, as a tree and as a bitset
+        PokemonNode *root = NULL;
+        PokedexBits bits = {{0}};
+        while (pokedexBitsCount(&bits) < size) {
+            int id = (int) (benchRand() % SPECIES_COUNT) + 1;
+            if (pokedexBitsAdd(&bits, id))
+                root = insertPokemonNode(root, createPokemonNode(findSpecies(id)));
+        }
+
+        alphabeticalTo(qsortPath, root, &bits, ALPHA_QSORT, 1);
+        alphabeticalTo(rankPath, root, &bits, ALPHA_RANKS, 1);
+        alphabeticalTo(bitsPath, root, &bits, ALPHA_RANK_BITS, 1);
+        bool same = sameFileContents(qsortPath, rankPath) && sameFileContents(qsortPath, bitsPath);
+        remove(qsortPath);
+        remove(rankPath);
+        remove(bitsPath);
+
+        double qsortTime = alphabeticalTo("/dev/null", root, &bits, ALPHA_QSORT, repeats);
+        double rankTime = alphabeticalTo("/dev/null", root, &bits, ALPHA_RANKS, repeats);
+        double bitsTime = alphabeticalTo("/dev/null", root, &bits, ALPHA_RANK_BITS, repeats);
+        printf("%3d species  qsort %7.0f ns   ranks %7.0f ns   ranks (bitset) %7.0f ns   %4.1fx   output %s\n",
+               size, qsortTime * 1e9 / repeats, rankTime * 1e9 / repeats, bitsTime * 1e9 / repeats,
+               qsortTime / rankTime, same ? "identical" : "DIFFERENT");
+        freePokemonTree(root);
+    }
+}
+
+// --------------------------------------------------------------
+// Species catalog: loading a big CSV and looking IDs up by index
+// --------------------------------------------------------------
+
+// Write count species, IDs first, first + stride, ...; names repeat every 1000 species
+static void writeSpeciesCatalog(const char *path, int count, int first, int stride) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) return;
+    for (int i = 0; i < count; i++)
+        fprintf(file, "%d,Species%d,%s,%d,%d,%d\n", first + i * stride, i % 1000, getTypeName((PokemonType) (i % 15)),
+                40 + i % 60, 30 + i % 90, i % 2);
+    fclose(file);
+}
+
+// Look up lookups IDs, half of real species and half anywhere in the catalog's range
+// (mostly misses when the IDs are sparse); returns ns per lookup, counts hits
+static double timeSpeciesLookups(int lookups, long *hits) {
+    int span = speciesCatalog.lastId - speciesCatalog.firstId + 1;
+    int *ids = malloc(lookups * sizeof(int));
+    if (ids == NULL) return 0;
+    for (int i = 0; i < lookups; i++) {
+        if (i % 2 == 0)
+            ids[i] = speciesCatalog.species[benchRand() % (unsigned int) speciesCatalog.count].id;
+        else
+            ids[i] = speciesCatalog.firstId + (int) (benchRand() % (unsigned int) span);
+    }
+    *hits = 0;
+    double start = nowSeconds();
+    for (int i = 0; i < lookups; i++)
+        *hits += findSpecies(ids[i]) != NULL;
+    double seconds = nowSeconds() - start;
+    free(ids);
+    return seconds * 1e9 / lookups;
+}
+
+static void benchSpeciesCatalog(void) {
+    printf("== species catalog ==\n");
+    const char *path = "/tmp/ex6_bench_species.csv";
+    int lookups = 4000000;
+    long hits;
+    printf("built-in (%d, contiguous)      lookup %5.1f ns\n", speciesCatalog.count, timeSpeciesLookups(lookups, &hits));
+
+    // Stride 3 keeps the direct-mapped index, stride 9973 needs the hash table
+    int strides[] = { 3, 9973 };
+    for (int s = 0; s < 2; s++) {
+        int count = 200000;
+        writeSpeciesCatalog(path, count, 1, strides[s]);
+        double start = nowSeconds();
+        bool loaded = loadSpeciesCatalog(path);
+        double loadSeconds = nowSeconds() - start;
+        if (!loaded) break;
+        double lookupNs = timeSpeciesLookups(lookups, &hits);
+        printf("%d species, stride %-5d %s  load %6.1f ms  lookup %5.1f ns  hits %.1f%%\n", count, strides[s],
+               speciesCatalog.direct != NULL ? "direct" : "hashed", loadSeconds * 1e3, lookupNs,
+               100.0 * hits / lookups);
+        freeSpeciesCatalog();
+    }
+    remove(path);
+}
+
+// --------------------------------------------------------------
+// Core-operation suite (--suite): CSV rows for comparing builds
+// --------------------------------------------------------------
+// Each case runs until it has done at least this many operations (or one pass at large n)
+#define SUITE_MIN_OPS 200000
+// Linear-time operations (BFS search, BFS walk) stop at about this many node visits per case
+#define SUITE_NODE_VISITS 20000000
+// Owner names looked up per findOwnerByName case, generated before timing
+#define SUITE_QUERIES (1 << 16)
+#define SUITE_NAME_BYTES 64
+#define SUITE_MAX_N 1000000
+
+typedef enum { SUITE_SORTED, SUITE_RANDOM, SUITE_ADVERSARIAL } SuiteOrder;
+
+static const char *suiteOrderNames[] = { "sorted", "random", "adversarial" };
+
+// Timed sections of one case; time and allocations outside suiteResume/suitePause don't count
+typedef struct SuiteCase
+{
+    const char *benchmark;
+    SuiteOrder order;
+    int n;
+    long ops;
+    double seconds;
+    uint64_t allocations;
+    double resumedAt;
+    uint64_t allocationsAtResume; // threadAllocations (0 in an EX6_NO_STATS build)
+} SuiteCase;
+
+static const char *suiteFilter = NULL;
+
+static bool suiteSelected(const char *benchmark) {
+    return suiteFilter == NULL || strstr(benchmark, suiteFilter) != NULL;
+}
+
+// Peak resident set in kB: VmHWM, which suiteStart resets per case when the kernel allows it
+static long peakRssKb(void) {
+    FILE *status = fopen("/proc/self/status", "r");
+    char line[128];
+    long peak = -1;
+    while (status != NULL && fgets(line, sizeof(line), status) != NULL) {
+        if (strncmp(line, "VmHWM:", 6) == 0) {
+            peak = strtol(line + 6, NULL, 10);
+            break;
+        }
+    }
+    if (status) fclose(status);
+    if (peak < 0) {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        peak = usage.ru_maxrss;
+    }
+    return peak;
+}
+
+static void suiteStart(SuiteCase *run, const char *benchmark, SuiteOrder order, int n) {
+    memset(run, 0, sizeof(*run));
+    run->benchmark = benchmark;
+    run->order = order;
+    run->n = n;
+
+    // "5" resets the peak RSS to the current RSS (Linux 4.0+); otherwise it stays process-wide
+    FILE *clearRefs = fopen("/proc/self/clear_refs", "w");
+    if (clearRefs != NULL) {
+        fputs("5", clearRefs);
+        fclose(clearRefs);
+    }
+}
+
+static inline void suiteResume(SuiteCase *run) {
+    run->allocationsAtResume = threadAllocations;
+    run->resumedAt = nowSeconds();
+}
+
+static inline void suitePause(SuiteCase *run, long ops) {
+    run->seconds += nowSeconds() - run->resumedAt;
+    run->allocations += threadAllocations - run->allocationsAtResume;
+    run->ops += ops;
+}
+
+static void suiteReport(const SuiteCase *run) {
+    printf("%s,%s,%d,%ld,%.1f,%.3f,%ld\n", run->benchmark, suiteOrderNames[run->order], run->n, run->ops,
+           run->seconds * 1e9 / run->ops, (double) run->allocations / run->ops, peakRssKb());
+    fflush(stdout);
+}
+
+// Repetitions of an n-operation pass that reach SUITE_MIN_OPS
+static int suiteRepeats(int n) {
+    return n >= SUITE_MIN_OPS ? 1 : (SUITE_MIN_OPS + n - 1) / n;
+}
+
+// IDs 1..n in the case's insert order. Adversarial is outside-in (1, n, 2, n-1, ...):
+// every insert lands at alternating ends of the tree, forcing double rotations
+static void fillSuiteIds(int *ids, int n, SuiteOrder order) {
+    for (int i = 0; i < n; i++)
+        ids[i] = i + 1;
+    if (order == SUITE_RANDOM) {
+        for (int i = n - 1; i > 0; i--) {
+            int j = (int) (benchRand() % (unsigned int) (i + 1));
+            int swap = ids[i];
+            ids[i] = ids[j];
+            ids[j] = swap;
+        }
+    } else if (order == SUITE_ADVERSARIAL) {
+        for (int i = 0, low = 1, high = n; i < n; i++)
+            ids[i] = i % 2 == 0 ? low++ : high--;
+    }
+}
+
+static PokemonNode *buildSuiteTree(const int *ids, int n) {
+    PokemonNode *root = NULL;
+    for (int i = 0; i < n; i++)
+        root = insertPokemonNode(root, createPokemonNode(&benchData[ids[i] - 1]));
+    return root;
+}
+
+static void suiteInsert(const int *ids, int n, SuiteOrder order) {
+    SuiteCase run;
+    suiteStart(&run, "insertPokemonNode", order, n);
+    for (int r = suiteRepeats(n); r > 0; r--) {
+        PokemonNode *root = NULL;
+        suiteResume(&run);
+        for (int i = 0; i < n; i++)
+            root = insertPokemonNode(root, createPokemonNode(&benchData[ids[i] - 1]));
+        suitePause(&run, n);
+        freePokemonTree(root);
+    }
+    suiteReport(&run);
+}
+
+static void suiteSearchBFS(const int *ids, int n, SuiteOrder order) {
+    SuiteCase run;
+    suiteStart(&run, "searchPokemonBFS", order, n);
+    PokemonNode *root = buildSuiteTree(ids, n);
+    int queries = SUITE_NODE_VISITS / n < 16 ? 16 : SUITE_NODE_VISITS / n;
+    volatile PokemonNode *found;
+    suiteResume(&run);
+    for (int q = 0; q < queries; q++)
+        found = searchPokemonBFS(root, (int) (benchRand() % (unsigned int) n) + 1);
+    suitePause(&run, queries);
+    (void) found;
+    freePokemonTree(root);
+    suiteReport(&run);
+}
+
+static void suiteRemove(const int *ids, int n, SuiteOrder order) {
+    SuiteCase run;
+    suiteStart(&run, "removeNodeBST", order, n);
+    for (int r = suiteRepeats(n); r > 0; r--) {
+        // Removed in the order they were inserted
+        PokemonNode *root = buildSuiteTree(ids, n);
+        suiteResume(&run);
+        for (int i = 0; i < n; i++)
+            root = removeNodeBST(root, ids[i]);
+        suitePause(&run, n);
+        freePokemonTree(root);
+    }
+    suiteReport(&run);
+}
+
+// balanced: mergeBSTBalanced (what merging owners runs); otherwise mergeBST, which copies
+// every node of the second tree into the first one insert at a time
+static void suiteMerge(const int *ids, int n, SuiteOrder order, bool balanced) {
+    SuiteCase run;
+    suiteStart(&run, balanced ? "mergeBSTBalanced" : "mergeBST", order, n);
+    // One op merges two trees of n/2 species each, taken alternately from the insert order
+    int repeats = SUITE_MIN_OPS / n < 1 ? 1 : SUITE_MIN_OPS / n;
+    for (int r = 0; r < repeats; r++) {
+        PokemonNode *first = NULL, *second = NULL;
+        for (int i = 0; i < n; i++) {
+            PokemonNode *node = createPokemonNode(&benchData[ids[i] - 1]);
+            if (i % 2 == 0)
+                first = insertPokemonNode(first, node);
+            else
+                second = insertPokemonNode(second, node);
+        }
+        suiteResume(&run);
+        PokemonNode *merged = balanced ? mergeBSTBalanced(first, second) : mergeBST(first, second);
+        suitePause(&run, 1);
+        freePokemonTree(merged);
+        // mergeBST leaves the second tree as it was
+        if (!balanced) freePokemonTree(second);
+    }
+    suiteReport(&run);
+}
+
+static void suiteBFSGeneric(const int *ids, int n, SuiteOrder order) {
+    SuiteCase run;
+    suiteStart(&run, "BFSGeneric", order, n);
+    PokemonNode *root = buildSuiteTree(ids, n);
+    int walks = SUITE_NODE_VISITS / n < 1 ? 1 : SUITE_NODE_VISITS / n;
+    suiteResume(&run);
+    for (int w = 0; w < walks; w++)
+        BFSGeneric(root, countVisit);
+    suitePause(&run, walks);
+    freePokemonTree(root);
+    suiteReport(&run);
+}
+
+// Send stdout to /dev/null for the duration of a timed display; returns the saved descriptor
+static int silenceStdout(void) {
+    fflush(stdout);
+    int savedStdout = dup(STDOUT_FILENO);
+    int devNull = open("/dev/null", O_WRONLY);
+    if (savedStdout < 0 || devNull < 0) {
+        printf("Cannot open /dev/null\n");
+        exit(1);
+    }
+    dup2(devNull, STDOUT_FILENO);
+    close(devNull);
+    return savedStdout;
+}
+
+static void restoreStdout(int savedStdout) {
+    fflush(stdout);
+    dup2(savedStdout, STDOUT_FILENO);
+    close(savedStdout);
+}
+
+static void suiteAlphabetical(SuiteOrder order) {
+    // A Pokedex holds each species once, so trees stop at the 151 real species
+    int sizes[] = { 100, SPECIES_COUNT };
+    int ids[SPECIES_COUNT];
+    for (int s = 0; s < 2; s++) {
+        int n = sizes[s];
+        fillSuiteIds(ids, n, order);
+        PokemonNode *root = NULL;
+        for (int i = 0; i < n; i++)
+            root = insertPokemonNode(root, createPokemonNode(findSpecies(ids[i])));
+
+        SuiteCase run;
+        suiteStart(&run, "displayAlphabetical", order, n);
+        int repeats = 20000;
+        int savedStdout = silenceStdout();
+        suiteResume(&run);
+        for (int r = 0; r < repeats; r++)
+            displayAlphabetical(root);
+        suitePause(&run, repeats);
+        restoreStdout(savedStdout);
+        freePokemonTree(root);
+        suiteReport(&run);
+    }
+}
+
+// Owner names for a case. Adversarial names share a 48-character prefix and are created
+// in reverse order, so every strcmp and hash runs over the whole name
+static void suiteOwnerName(char *name, int index, int n, SuiteOrder order) {
+    if (order == SUITE_ADVERSARIAL)
+        snprintf(name, SUITE_NAME_BYTES, "TrainerTrainerTrainerTrainerTrainerTrainerTrain%07d", n - 1 - index);
+    else
+        snprintf(name, SUITE_NAME_BYTES, "Trainer%07d", index);
+}
+
+static void buildSuiteRegistry(const int *ids, int n, SuiteOrder order) {
+    char name[SUITE_NAME_BYTES];
+    for (int i = 0; i < n; i++) {
+        suiteOwnerName(name, ids[i] - 1, n, order);
+        linkOwnerInCircularList(createOwner(myStrdup(name), NULL));
+    }
+}
+
+static void suiteFindOwner(const int *ids, int n, SuiteOrder order) {
+    SuiteCase run;
+    suiteStart(&run, "findOwnerByName", order, n);
+    buildSuiteRegistry(ids, n, order);
+    char (*queries)[SUITE_NAME_BYTES] = malloc(SUITE_QUERIES * sizeof(*queries));
+    if (queries == NULL) {
+        printf("Memory allocation failed.\n");
+        exit(1);
+    }
+    for (int q = 0; q < SUITE_QUERIES; q++)
+        suiteOwnerName(queries[q], (int) (benchRand() % (unsigned int) n), n, order);
+
+    volatile OwnerNode *found;
+    int rounds = SUITE_MIN_OPS * 5 / SUITE_QUERIES;
+    suiteResume(&run);
+    for (int r = 0; r < rounds; r++) {
+        for (int q = 0; q < SUITE_QUERIES; q++)
+            found = findOwnerByName(queries[q]);
+    }
+    suitePause(&run, (long) rounds * SUITE_QUERIES);
+    (void) found;
+    free(queries);
+    freeAllOwners();
+    suiteReport(&run);
+}
+
+static void suiteSortOwners(const int *ids, int n, SuiteOrder order) {
+    SuiteCase run;
+    suiteStart(&run, "sortOwners", order, n);
+    // One op sorts a freshly built registry (an already sorted ring is the "sorted" case)
+    int repeats = SUITE_MIN_OPS / 2 / n < 1 ? 1 : SUITE_MIN_OPS / 2 / n;
+    for (int r = 0; r < repeats; r++) {
+        buildSuiteRegistry(ids, n, order);
+        int savedStdout = silenceStdout();
+        suiteResume(&run);
+        sortOwners();
+        suitePause(&run, 1);
+        restoreStdout(savedStdout);
+        freeAllOwners();
+    }
+    suiteReport(&run);
+}
+
+static void runSuite(void) {
+    int *ids = malloc(SUITE_MAX_N * sizeof(int));
+    if (ids == NULL) {
+        printf("Memory allocation failed.\n");
+        exit(1);
+    }
+    printf("benchmark,order,n,ops,ns_per_op,allocs_per_op,peak_rss_kb\n");
+    for (int order = SUITE_SORTED; order <= SUITE_ADVERSARIAL; order++) {
+        for (int n = 100; n <= SUITE_MAX_N; n *= 10) {
+            fillSuiteIds(ids, n, order);
+            if (suiteSelected("insertPokemonNode")) suiteInsert(ids, n, order);
+            if (suiteSelected("searchPokemonBFS")) suiteSearchBFS(ids, n, order);
+            if (suiteSelected("removeNodeBST")) suiteRemove(ids, n, order);
+            if (suiteSelected("mergeBST")) suiteMerge(ids, n, order, false);
+            if (suiteSelected("mergeBSTBalanced")) suiteMerge(ids, n, order, true);
+            if (suiteSelected("BFSGeneric")) suiteBFSGeneric(ids, n, order);
+            if (suiteSelected("findOwnerByName")) suiteFindOwner(ids, n, order);
+            if (suiteSelected("sortOwners")) suiteSortOwners(ids, n, order);
+        }
+        if (suiteSelected("displayAlphabetical")) {
+            // Name ranks are a table only for catalogs of at most RANK_SLOTS_MAX species
+            useBenchSpecies(false);
+            suiteAlphabetical(order);
+            useBenchSpecies(true);
+        }
+    }
+    free(ids);
+}
+
+// --------------------------------------------------------------
+// Full-registry scan: species records vs species columns
+// --------------------------------------------------------------
+// Hardware cache-miss counter for this thread, or -1 where perf events are unavailable
+static int openCacheMissCounter(void) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+enum { SCAN_NODES, SCAN_RECORDS, SCAN_COLUMNS };
+
+// Sum of attack over every Pokemon of every owner (SCAN_NODES sums species positions only)
+static long scanRegistry(int kind) {
+    long sum = 0;
+    OwnerNode *owner = ownerHead;
+    if (owner == NULL) return 0;
+    do {
+        TreeCursor cursor;
+        treeCursorInit(&cursor, owner->pokedexRoot, TRAVERSE_PRE);
+        PokemonNode *node;
+        while ((node = treeCursorNext(&cursor)) != NULL) {
+            if (kind == SCAN_RECORDS)
+                sum += speciesCatalog.species[node->species].attack; // a node->data layout: one record per node
+            else if (kind == SCAN_COLUMNS)
+                sum += speciesCatalog.attack[node->species];
+            else
+                sum += node->species;
+        }
+        treeCursorFree(&cursor);
+        owner = owner->next;
+    } while (owner != ownerHead);
+    return sum;
+}
+
+static void benchSpeciesScan(void) {
+    printf("== full-registry scan (%d species, %zu-byte nodes, %d per slab) ==\n", speciesCatalog.count,
+           sizeof(PokemonNode), (int) NODES_PER_SLAB);
+    int owners = 2000, perOwner = 500;
+    char name[32];
+    for (int o = 0; o < owners; o++) {
+        snprintf(name, sizeof(name), "Scan%05d", o);
+        OwnerNode *owner = createOwner(myStrdup(name), NULL);
+        linkOwnerInCircularList(owner);
+        bool inserted;
+        for (int i = 0; i < perOwner; i++)
+            ownerAddPokemon(owner, &benchData[benchRand() % (unsigned int) benchDataCount], &inserted);
+    }
+    long nodes = 0;
+    OwnerNode *owner = ownerHead;
+    do {
+        nodes += countPokemonNodes(owner->pokedexRoot);
+        owner = owner->next;
+    } while (owner != ownerHead);
+
+    int counter = openCacheMissCounter();
+    const char *labels[] = { "nodes only", "records", "columns" };
+    int repeats = 5;
+    for (int kind = SCAN_NODES; kind <= SCAN_COLUMNS; kind++) {
+        volatile long sum = scanRegistry(kind); // warm up
+        if (counter >= 0) {
+            ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+            ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+        }
+        double start = nowSeconds();
+        for (int r = 0; r < repeats; r++)
+            sum = scanRegistry(kind);
+        double seconds = nowSeconds() - start;
+        long long misses = 0;
+        if (counter >= 0) {
+            ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(counter, &misses, sizeof(misses)) != (ssize_t) sizeof(misses)) misses = -1;
+        }
+        (void) sum;
+        printf("%-10s  %ld nodes  %5.2f ns/node", labels[kind], nodes, seconds * 1e9 / ((double) nodes * repeats));
+        if (counter >= 0 && misses >= 0)
+            printf("  cache misses/node %.3f\n", (double) misses / ((double) nodes * repeats));
+        else
+            printf("  cache misses n/a\n");
+    }
+    if (counter >= 0) close(counter);
+    freeAllOwners();
+}
+
+// --------------------------------------------------------------
+// Cross-owner queries: hand walk vs column scan, one thread vs many
+// --------------------------------------------------------------
+static const PokemonFilter *walkFilter;
+static long walkMatches;
+
+static void countFilterMatch(PokemonNode *node) {
+    walkMatches += pokemonMatchesFilter(walkFilter, nodeData(node));
+}
+
+// The pre-query way: walk every owner with preOrderGeneric and a global-state visitor
+static long handWalkQuery(const PokemonFilter *filter) {
+    walkFilter = filter;
+    walkMatches = 0;
+    OwnerNode *owner = ownerHead;
+    do {
+        preOrderGeneric(owner->pokedexRoot, countFilterMatch);
+        owner = owner->next;
+    } while (owner != ownerHead);
+    return walkMatches;
+}
+
+static void benchQuery(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("== cross-owner query (%d species, %ld cores online) ==\n", speciesCatalog.count, cores);
+
+    // Species filter alone: the column kernel vs a loop over the records
+    PokemonFilter filter;
+    initPokemonFilter(&filter);
+    filter.type = FIRE;
+    filter.attackMin = 91;
+    uint8_t *bitmap = malloc((size_t) (speciesCatalog.count + 7) / 8);
+    if (bitmap == NULL) {
+        printf("Memory allocation failed.\n");
+        exit(1);
+    }
+    int repeats = 20, columnMatches = 0, recordMatches = 0;
+    double start = nowSeconds();
+    for (int r = 0; r < repeats; r++)
+        columnMatches = markMatchingSpecies(&filter, bitmap);
+    double columnSeconds = nowSeconds() - start;
+    start = nowSeconds();
+    for (int r = 0; r < repeats; r++) {
+        recordMatches = 0;
+        for (int i = 0; i < speciesCatalog.count; i++)
+            recordMatches += pokemonMatchesFilter(&filter, &speciesCatalog.species[i]);
+    }
+    double recordSeconds = nowSeconds() - start;
+    printf("species filter  records %5.2f ns/species  columns %5.2f ns/species  (%d match%s)\n",
+           recordSeconds * 1e9 / ((double) speciesCatalog.count * repeats),
+           columnSeconds * 1e9 / ((double) speciesCatalog.count * repeats), columnMatches,
+           columnMatches == recordMatches ? "" : ", MISMATCH");
+    free(bitmap);
+
+    // 4000 owners of 250 random species each, 10^6 Pokemon
+    int owners = 4000, perOwner = 250;
+    char name[32];
+    for (int o = 0; o < owners; o++) {
+        snprintf(name, sizeof(name), "Query%05d", o);
+        OwnerNode *owner = createOwner(myStrdup(name), NULL);
+        linkOwnerInCircularList(owner);
+        bool inserted;
+        for (int i = 0; i < perOwner; i++)
+            ownerAddPokemon(owner, &benchData[benchRand() % (unsigned int) benchDataCount], &inserted);
+    }
+    long pokemon = 0;
+    OwnerNode *owner = ownerHead;
+    do {
+        pokemon += countPokemonNodes(owner->pokedexRoot);
+        owner = owner->next;
+    } while (owner != ownerHead);
+
+    int rounds = 5;
+    long walked = 0;
+    start = nowSeconds();
+    for (int r = 0; r < rounds; r++)
+        walked = handWalkQuery(&filter);
+    double walkSeconds = nowSeconds() - start;
+    printf("%ld Pokemon, FIRE with attack > 90: %ld\n", pokemon, walked);
+    printf("hand walk (preOrderGeneric)  %6.2f ms\n", walkSeconds * 1e3 / rounds);
+
+    int savedThreads = queryThreads;
+    int threadCounts[] = { 1, 2, 4, (int) cores };
+    QueryMode modes[] = { QUERY_COUNT, QUERY_LIST };
+    const char *modeNames[] = { "count", "list" };
+    for (int m = 0; m < 2; m++) {
+        for (int t = 0; t < 4; t++) {
+            if (threadCounts[t] < 1 || (t == 3 && cores <= 4)) continue;
+            queryThreads = threadCounts[t];
+            QueryResult result;
+            start = nowSeconds();
+            for (int r = 0; r < rounds; r++) {
+                queryPokemon(&filter, modes[m], &result);
+                if (r + 1 < rounds) freeQueryResult(&result);
+            }
+            double seconds = nowSeconds() - start;
+            printf("queryPokemon %-5s %2d thread%s %6.2f ms%s\n", modeNames[m], queryThreads,
+                   queryThreads == 1 ? " " : "s", seconds * 1e3 / rounds, result.count == walked ? "" : "  MISMATCH");
+            freeQueryResult(&result);
+        }
+    }
+    queryThreads = savedThreads;
+    freeAllOwners();
+}
+
+// --------------------------------------------------------------
+// Subtree summaries: O(1) stats and O(log n) selection vs walking the tree
+// --------------------------------------------------------------
+static PokedexSummary walkSummary;
+
+static void addToWalkSummary(PokemonNode *node) {
+    const PokemonData *data = nodeData(node);
+    walkSummary.count++;
+    walkSummary.hpSum += data->hp;
+    walkSummary.attackSum += data->attack;
+    if (data->attack > walkSummary.maxAttack) walkSummary.maxAttack = data->attack;
+    walkSummary.typeMask |= (uint16_t) (1u << data->TYPE);
+}
+
+static void benchSubtreeSummaries(void) {
+    printf("== subtree summaries (%zu-byte nodes) ==\n", sizeof(PokemonNode));
+    for (int n = 1000; n <= 1000000; n *= 10) {
+        PokemonNode *root = buildBenchTree(n, 1, 0);
+
+        // Whole-tree stats: a pre-order walk vs the root's fields
+        int repeats = 10000000 / n;
+        PokedexSummary summary;
+        double start = nowSeconds();
+        for (int r = 0; r < repeats; r++) {
+            memset(&walkSummary, 0, sizeof(walkSummary));
+            preOrderGeneric(root, addToWalkSummary);
+        }
+        double walkSeconds = nowSeconds() - start;
+        start = nowSeconds();
+        for (int r = 0; r < repeats; r++)
+            summarizePokedex(root, &summary);
+        double rootSeconds = nowSeconds() - start;
+        bool same = summary.count == walkSummary.count && summary.hpSum == walkSummary.hpSum &&
+                    summary.attackSum == walkSummary.attackSum && summary.maxAttack == walkSummary.maxAttack &&
+                    summary.typeMask == walkSummary.typeMask;
+
+        // k-th smallest ID: an in-order cursor that stops at k vs a size-guided descent
+        int picks = 2000;
+        volatile PokemonNode *picked = NULL;
+        start = nowSeconds();
+        for (int p = 0; p < picks; p++) {
+            int k = (int) (benchRand() % (unsigned int) n);
+            TreeCursor cursor;
+            treeCursorInit(&cursor, root, TRAVERSE_IN);
+            for (int i = 0; i <= k; i++)
+                picked = treeCursorNext(&cursor);
+            treeCursorFree(&cursor);
+        }
+        double cursorSeconds = nowSeconds() - start;
+        start = nowSeconds();
+        for (int p = 0; p < picks * 100; p++)
+            picked = selectPokemonByRank(root, (int) (benchRand() % (unsigned int) n));
+        double selectSeconds = nowSeconds() - start;
+        (void) picked;
+
+        printf("n=%-8d stats: walk %10.1f ns  root %5.1f ns%s   k-th: cursor %10.1f ns  select %6.1f ns\n", n,
+               walkSeconds * 1e9 / repeats, rootSeconds * 1e9 / repeats, same ? "" : " MISMATCH",
+               cursorSeconds * 1e9 / picks, selectSeconds * 1e9 / (picks * 100.0));
+        freePokemonTree(root);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    initBenchData(1000000);
+    if (argc >= 2 && strcmp(argv[1], "--suite") == 0) {
+        suiteFilter = argc >= 3 ? argv[2] : NULL;
+        runSuite();
+        freeBenchData();
+        return 0;
+    }
+    benchSortedInsert();
+    benchSearch();
+    benchBFS();
+    benchBitsetPokedex();
+    benchMerge();
+    benchOwnerLookup();
+    benchReplayAllocations();
+    checkArenaSlabReuse();
+    benchInputReader();
+    benchBatchCommands();
+    benchOutputSink();
+    benchTeardown();
+    benchSnapshot();
+    benchJournal();
+    benchConcurrentOwners();
+    benchEpochReads();
+    benchFightScores();
+    benchTraversal();
+    benchSpeciesScan();
+    benchQuery();
+    benchSubtreeSummaries();
+    useBenchSpecies(false);
+    benchAlphabetical();
+    benchSpeciesCatalog();
+    freeBenchData();
+    return 0;
+}
@@ -1,28 +1,77 @@
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
 #include "ex6.h"
 #include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 # define INT_BUFFER 128
 
+#ifndef EX6_NO_STATS
+// Every allocation below goes through these, so the stats can charge allocations to operations
+static inline void *countedMalloc(size_t size) {
+    threadAllocations++;
+    return malloc(size);
+}
+
+static inline void *countedCalloc(size_t count, size_t size) {
+    threadAllocations++;
+    return calloc(count, size);
+}
+
+static inline void *countedRealloc(void *block, size_t size) {
+    threadAllocations++;
+    return realloc(block, size);
+}
+
+static inline int countedPosixMemalign(void **block, size_t alignment, size_t size) {
+    threadAllocations++;
+    return posix_memalign(block, alignment, size);
+}
+
+#define malloc(size) countedMalloc(size)
+#define calloc(count, size) countedCalloc(count, size)
+#define realloc(block, size) countedRealloc(block, size)
+#define posix_memalign(block, alignment, size) countedPosixMemalign(block, alignment, size)
+#endif
+
 // ================================================
 // Basic struct definitions from ex6.h assumed:
 //   PokemonData { int id; char *name; PokemonType TYPE; int hp; int attack; EvolutionStatus CAN_EVOLVE; }
-//   PokemonNode { PokemonData* data; PokemonNode* left, *right; }
-//   OwnerNode   { char* ownerName; PokemonNode* pokedexRoot; OwnerNode *next, *prev; }
+//   PokemonNode { PokemonNode* left, *right; int64_t hpSum, attackSum; uint32_t species, size; int32_t maxAttack; uint16_t typeMask; uint8_t height; bool pooled; }
+//   OwnerNode   { char* ownerName; PokemonNode* pokedexRoot; PokedexBits pokedexBits; NodePool nodePool; OwnerNode *next, *prev; pthread_mutex_t lock; bool retired; RetiredNodes retiredNodes; }
 //   OwnerNode* ownerHead;
-//   const PokemonData pokedex[];
+//   bool bitsetPokedexMode;
+//   SpeciesCatalog speciesCatalog; (pokedex[] unless --species loaded a catalog)
 // ================================================
 
 // --------------------------------------------------------------
 // 1) Safe integer reading
 // --------------------------------------------------------------
 
+// The characters trimWhitespace (and trimInputView) strip from both ends
+static bool isTrimmedChar(char chr) {
+    return chr == ' ' || chr == '\t' || chr == '\r';
+}
+
 void trimWhitespace(char *str) {
     // Remove leading spaces/tabs/\r
     int start = 0;
-    while (str[start] == ' ' || str[start] == '\t' || str[start] == '\r')
+    while (isTrimmedChar(str[start]))
         start++;
 
     if (start > 0) {
@@ -34,11 +83,21 @@ void trimWhitespace(char *str) {
 
     // Remove trailing spaces/tabs/\r
     int len = (int) strlen(str);
-    while (len > 0 && (str[len - 1] == ' ' || str[len - 1] == '\t' || str[len - 1] == '\r')) {
+    while (len > 0 && isTrimmedChar(str[len - 1])) {
         str[--len] = '\0';
     }
 }
 
+void trimInputView(InputView *view) {
+    // Same rule as trimWhitespace, moving the view's ends instead of the bytes
+    while (view->length > 0 && isTrimmedChar(view->text[0])) {
+        view->text++;
+        view->length--;
+    }
+    while (view->length > 0 && isTrimmedChar(view->text[view->length - 1]))
+        view->length--;
+}
+
 char *myStrdup(const char *src) {
     if (!src)
         return NULL;
@@ -52,28 +111,200 @@ char *myStrdup(const char *src) {
     return dest;
 }
 
+// Index of the first '\n' in text[0..length), or length if there is none
+static size_t findNewline(const char *text, size_t length) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    // 32 bytes per compare; the mask has one bit per matching byte
+    const __m256i newlines = _mm256_set1_epi8('\n');
+    for (; i + 32 <= length; i += 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *) (text + i));
+        unsigned int mask = (unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newlines));
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+#elif defined(__SSE2__)
+    const __m128i newlines = _mm_set1_epi8('\n');
+    for (; i + 16 <= length; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *) (text + i));
+        unsigned int mask = (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newlines));
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+#endif
+    // The tail (or everything, without SIMD) one byte at a time
+    for (; i < length; i++) {
+        if (text[i] == '\n')
+            return i;
+    }
+    return length;
+}
+
+// First use: map a regular file whole, otherwise set up the chunk buffer
+static void openInputReader(InputReader *reader) {
+    reader->opened = true;
+    struct stat info;
+    if (fstat(reader->fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        off_t offset = lseek(reader->fd, 0, SEEK_CUR);
+        void *mapping = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, reader->fd, 0);
+        if (mapping != MAP_FAILED && offset >= 0 && offset <= info.st_size) {
+            reader->data = mapping;
+            reader->size = (size_t) info.st_size;
+            reader->pos = (size_t) offset;
+            reader->mapped = true;
+            return;
+        }
+        if (mapping != MAP_FAILED)
+            munmap(mapping, (size_t) info.st_size);
+    }
+    // Pipes, terminals and empty files are read a chunk at a time
+    reader->data = NULL;
+    reader->size = reader->pos = reader->capacity = 0;
+    reader->mapped = false;
+}
+
+// Read more input behind the unread bytes; false at end of input (or on error)
+static bool fillInputReader(InputReader *reader) {
+    if (reader->mapped) return false;
+
+    // Move the unread bytes to the front, growing the buffer only for a line longer than it
+    size_t unread = reader->size - reader->pos;
+    if (reader->pos > 0) {
+        memmove(reader->data, reader->data + reader->pos, unread);
+        reader->size = unread;
+        reader->pos = 0;
+    }
+    if (reader->size == reader->capacity) {
+        size_t capacity = reader->capacity ? reader->capacity * 2 : INPUT_CHUNK_BYTES;
+        char *grown = realloc(reader->data, capacity);
+        if (grown == NULL) {
+            printf("Memory allocation failed.\n");
+            return false;
+        }
+        reader->data = grown;
+        reader->capacity = capacity;
+    }
+
+    // A prompt must be on screen before we block waiting for its answer
+    flushOutputSink();
+    fflush(stdout);
+    ssize_t got;
+    do {
+        got = read(reader->fd, reader->data + reader->size, reader->capacity - reader->size);
+    } while (got < 0 && errno == EINTR);
+    if (got <= 0) return false;
+    reader->size += (size_t) got;
+    return true;
+}
+
+bool readInputSpan(InputReader *reader, size_t limit, InputView *span, bool *sawNewline) {
+    if (!reader->opened)
+        openInputReader(reader);
+
+    // 'scanned' bytes after pos are known to hold no newline (it survives refills)
+    size_t scanned = 0;
+    while (true) {
+        size_t unread = reader->size - reader->pos;
+        size_t window = unread < limit ? unread : limit;
+        const char *start = reader->data + reader->pos;
+        size_t newline = window > scanned ? scanned + findNewline(start + scanned, window - scanned) : window;
+        if (newline < window) {
+            // A whole line: the view stops before '\n', which is consumed
+            span->text = start;
+            span->length = newline;
+            *sawNewline = true;
+            reader->pos += newline + 1;
+            return true;
+        }
+        if (unread >= limit || !fillInputReader(reader)) {
+            // Limit reached, or the last line has no '\n'
+            if (window == 0) return false;
+            span->text = reader->data + reader->pos;
+            span->length = window;
+            *sawNewline = false;
+            reader->pos += window;
+            return true;
+        }
+        scanned = window;
+    }
+}
+
+bool readInputLine(InputReader *reader, InputView *line) {
+    bool sawNewline;
+    return readInputSpan(reader, SIZE_MAX, line, &sawNewline);
+}
+
+void resetInputReader(InputReader *reader) {
+    if (reader->mapped)
+        munmap(reader->data, reader->size);
+    else
+        free(reader->data);
+    reader->data = NULL;
+    reader->size = reader->pos = reader->capacity = 0;
+    reader->mapped = false;
+    reader->opened = false;
+}
+
+// Length up to the first '\0', as strlen would see the text
+static size_t viewStringLength(const InputView *view) {
+    const char *nul = memchr(view->text, '\0', view->length);
+    return nul ? (size_t) (nul - view->text) : view->length;
+}
+
+bool parseIntView(const char *text, size_t length, int *value) {
+    // strtol(text, &end, 10) followed by the "*end == '\0'" check, without the copy
+    const char *p = text, *end = text + length;
+    while (p < end && isspace((unsigned char) *p))
+        p++;
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-'))
+        negative = (*p++ == '-');
+    if (p == end || !isdigit((unsigned char) *p))
+        return false;
+
+    // Accumulate like strtol: out-of-range values clamp to LONG_MIN/LONG_MAX
+    unsigned long limit = negative ? (unsigned long) LONG_MAX + 1 : (unsigned long) LONG_MAX;
+    unsigned long magnitude = 0;
+    bool overflow = false;
+    for (; p < end && isdigit((unsigned char) *p); p++) {
+        unsigned int digit = (unsigned int) (*p - '0');
+        if (magnitude > (limit - digit) / 10)
+            overflow = true;
+        else
+            magnitude = magnitude * 10 + digit;
+    }
+    long result;
+    if (overflow)
+        result = negative ? LONG_MIN : LONG_MAX;
+    else if (negative)
+        result = magnitude == (unsigned long) LONG_MAX + 1 ? LONG_MIN : -(long) magnitude;
+    else
+        result = (long) magnitude;
+    *value = (int) result;
+    return p == end;
+}
+
 int readIntSafe(const char *prompt) {
-    char buffer[INT_BUFFER];
     int value;
     int success = 0;
 
     while (!success) {
-        printf("%s", prompt);
+        fputs(prompt, stdout);
 
-        // If we fail to read, treat it as invalid
-        if (!fgets(buffer, sizeof(buffer), stdin)) {
+        // Read like fgets into a buffer of INT_BUFFER chars; if we fail to read, treat it as invalid
+        InputView line;
+        bool sawNewline;
+        if (!readInputSpan(&stdinReader, INT_BUFFER - 1, &line, &sawNewline)) {
             printf("Invalid input.\n");
-            clearerr(stdin);
             continue;
         }
 
-        // 1) Strip any trailing \r or \n
-        //    so "123\r\n" becomes "123"
-        size_t len = strlen(buffer);
-        if (len > 0 && (buffer[len - 1] == '\n' || buffer[len - 1] == '\r'))
-            buffer[--len] = '\0';
-        if (len > 0 && (buffer[len - 1] == '\r' || buffer[len - 1] == '\n'))
-            buffer[--len] = '\0';
+        // 1) Strip any trailing \r or \n (two at most, the consumed '\n' counts as one)
+        //    so "123\r\n" becomes "123"; a '\0' ends the text, as it would for strlen
+        size_t len = viewStringLength(&line);
+        int strips = (sawNewline && len == line.length) ? 1 : 2;
+        while (strips-- > 0 && len > 0 && (line.text[len - 1] == '\n' || line.text[len - 1] == '\r'))
+            len--;
 
         // 2) Check if empty after stripping
         if (len == 0) {
@@ -81,13 +312,8 @@ int readIntSafe(const char *prompt) {
             continue;
         }
 
-        // 3) Attempt to parse integer with strtol
-        char *endptr;
-        value = (int) strtol(buffer, &endptr, 10);
-
-        // If endptr didn't point to the end => leftover chars => invalid
-        // or if buffer was something non-numeric
-        if (*endptr != '\0') {
+        // 3) Attempt to parse the integer (strtol rules, no leftover chars allowed)
+        if (!parseIntView(line.text, len, &value)) {
             printf("Invalid input.\n");
         } else {
             // We got a valid integer
@@ -100,74 +326,488 @@ int readIntSafe(const char *prompt) {
 // --------------------------------------------------------------
 // 2) Utility: Get type name from enum
 // --------------------------------------------------------------
-const char *getTypeName(PokemonType type) {
-    switch (type) {
-        case GRASS:
-            return "GRASS";
-        case FIRE:
-            return "FIRE";
-        case WATER:
-            return "WATER";
-        case BUG:
-            return "BUG";
-        case NORMAL:
-            return "NORMAL";
-        case POISON:
-            return "POISON";
-        case ELECTRIC:
-            return "ELECTRIC";
-        case GROUND:
-            return "GROUND";
-        case FAIRY:
-            return "FAIRY";
-        case FIGHTING:
-            return "FIGHTING";
-        case PSYCHIC:
-            return "PSYCHIC";
-        case ROCK:
-            return "ROCK";
-        case GHOST:
-            return "GHOST";
-        case DRAGON:
-            return "DRAGON";
-        case ICE:
-            return "ICE";
-        default:
-            return "UNKNOWN";
+// Type names with their lengths, in PokemonType order
+#define TYPE_NAME(text) { text, sizeof(text) - 1 }
+static const struct {
+    const char *name;
+    size_t length;
+} typeNames[] = {
+    TYPE_NAME("GRASS"), TYPE_NAME("FIRE"), TYPE_NAME("WATER"), TYPE_NAME("BUG"), TYPE_NAME("NORMAL"),
+    TYPE_NAME("POISON"), TYPE_NAME("ELECTRIC"), TYPE_NAME("GROUND"), TYPE_NAME("FAIRY"),
+    TYPE_NAME("FIGHTING"), TYPE_NAME("PSYCHIC"), TYPE_NAME("ROCK"), TYPE_NAME("GHOST"),
+    TYPE_NAME("DRAGON"), TYPE_NAME("ICE")
+};
+static const size_t typeNameCount = sizeof(typeNames) / sizeof(typeNames[0]);
+
+// Index of the type printed as text[0..length), or -1 if no type has that name
+static int findTypeByName(const char *text, size_t length) {
+    for (size_t type = 0; type < typeNameCount; type++) {
+        if (typeNames[type].length == length && memcmp(typeNames[type].name, text, length) == 0)
+            return (int) type;
     }
+    return -1;
+}
+
+const char *getTypeName(PokemonType type) {
+    // One table lookup instead of a switch
+    if ((size_t) type >= typeNameCount)
+        return "UNKNOWN";
+    return typeNames[type].name;
 }
 
 // --------------------------------------------------------------
-// Utility: getDynamicInput (for reading a line into malloc'd memory)
+// Species catalog (ID index, interned names, CSV loading)
 // --------------------------------------------------------------
-char *getDynamicInput() {
-    char *input = NULL;
-    size_t size = 0, capacity = 1;
-    input = (char *) malloc(capacity);
-    if (!input) {
+
+// Position of a species record in the catalog (what a node stores)
+static inline uint32_t speciesPosition(const PokemonData *data) {
+    return (uint32_t) (data - speciesCatalog.species);
+}
+
+// A node's species: the hot fields from the columns, the whole record when a name is needed
+static inline int nodeId(const PokemonNode *node) {
+    return speciesCatalog.ids[node->species];
+}
+
+static inline const PokemonData *nodeData(const PokemonNode *node) {
+    return &speciesCatalog.species[node->species];
+}
+
+// First slot of an ID in the sparse index (multiplicative hash, top bits)
+static inline uint32_t speciesSlot(const SpeciesCatalog *catalog, int id) {
+    return ((uint32_t) id * 2654435761u) >> catalog->slotShift;
+}
+
+int findSpeciesPosition(int id) {
+    const SpeciesCatalog *catalog = &speciesCatalog;
+    if (id < catalog->firstId || id > catalog->lastId) return -1;
+    uint32_t offset = (uint32_t) (id - catalog->firstId);
+
+    // Contiguous IDs: the offset is the position
+    if (catalog->direct == NULL && catalog->slots == NULL)
+        return (int) offset;
+    if (catalog->direct != NULL)
+        return catalog->direct[offset];
+
+    // Sparse IDs: probe from the hashed slot until the ID or an empty slot
+    uint32_t mask = UINT32_MAX >> catalog->slotShift;
+    for (uint32_t slot = speciesSlot(catalog, id);; slot = (slot + 1) & mask) {
+        uint32_t entry = catalog->slots[slot];
+        if (entry == 0) return -1;
+        if (catalog->ids[entry - 1] == id) return (int) entry - 1;
+    }
+}
+
+const PokemonData *findSpecies(int id) {
+    int position = findSpeciesPosition(id);
+    return position >= 0 ? &speciesCatalog.species[position] : NULL;
+}
+
+const PokemonData *starterSpecies(int choice) {
+    if (choice < 1 || choice > 3) return NULL;
+    int position = (choice - 1) * 3;
+    return position < speciesCatalog.count ? &speciesCatalog.species[position] : NULL;
+}
+
+// Build the ID index of a catalog whose species are sorted by ID
+static bool buildSpeciesIndex(SpeciesCatalog *catalog) {
+    uint64_t spread = (uint64_t) catalog->lastId - (uint64_t) catalog->firstId + 1;
+    if (spread == (uint64_t) catalog->count) return true;
+
+    // Dense enough: one array slot per ID in the range
+    if (spread <= (uint64_t) catalog->count * SPECIES_DIRECT_SPREAD) {
+        catalog->direct = malloc(spread * sizeof(int32_t));
+        if (catalog->direct == NULL) {
+            printf("Memory allocation failed.\n");
+            return false;
+        }
+        memset(catalog->direct, 0xff, spread * sizeof(int32_t));
+        for (int i = 0; i < catalog->count; i++)
+            catalog->direct[catalog->ids[i] - catalog->firstId] = i;
+        return true;
+    }
+
+    // Sparse: a hash table at most half full
+    uint32_t bits = 1;
+    while (((uint64_t) 1 << bits) < (uint64_t) catalog->count * 2)
+        bits++;
+    catalog->slots = calloc((size_t) 1 << bits, sizeof(uint32_t));
+    if (catalog->slots == NULL) {
         printf("Memory allocation failed.\n");
-        return NULL;
+        return false;
+    }
+    catalog->slotShift = 32 - bits;
+    uint32_t mask = UINT32_MAX >> catalog->slotShift;
+    for (int i = 0; i < catalog->count; i++) {
+        uint32_t slot = speciesSlot(catalog, catalog->ids[i]);
+        while (catalog->slots[slot] != 0)
+            slot = (slot + 1) & mask;
+        catalog->slots[slot] = (uint32_t) i + 1;
+    }
+    return true;
+}
+
+// Copy the hot fields of the records into columns, all in one block
+static bool buildSpeciesColumns(SpeciesCatalog *catalog) {
+    size_t count = (size_t) catalog->count;
+    char *block = malloc(count * (3 * sizeof(int32_t) + 2 * sizeof(uint8_t)));
+    if (block == NULL) {
+        printf("Memory allocation failed.\n");
+        return false;
+    }
+    int32_t *ids = (int32_t *) block, *hp = ids + count, *attack = hp + count;
+    uint8_t *types = (uint8_t *) (attack + count), *canEvolve = types + count;
+    for (size_t i = 0; i < count; i++) {
+        const PokemonData *data = &catalog->species[i];
+        ids[i] = data->id;
+        hp[i] = data->hp;
+        attack[i] = data->attack;
+        types[i] = (uint8_t) data->TYPE;
+        canEvolve[i] = (uint8_t) data->CAN_EVOLVE;
+    }
+    catalog->columns = block;
+    catalog->ids = ids;
+    catalog->hp = hp;
+    catalog->attack = attack;
+    catalog->types = types;
+    catalog->canEvolve = canEvolve;
+    return true;
+}
+
+// Make records sorted by distinct IDs the catalog; the new catalog owns loaded and namePool
+static bool installSpeciesCatalog(const PokemonData *species, int count, PokemonData *loaded, char *namePool) {
+    SpeciesCatalog catalog = { NULL, NULL, NULL, NULL, NULL, species, count, species[0].id, species[count - 1].id,
+                               NULL, NULL, 0, NULL, NULL, loaded, namePool, NULL };
+    if (!buildSpeciesColumns(&catalog) || !buildSpeciesIndex(&catalog)) {
+        free(catalog.columns);
+        free(catalog.direct);
+        return false;
+    }
+
+    // Drop the current catalog (and its name ranks) and switch over
+    freeSpeciesCatalog();
+    speciesCatalog = catalog;
+    return true;
+}
+
+bool useSpeciesRecords(const PokemonData *species, int count) {
+    for (int i = 1; i < count; i++) {
+        if (species[i].id <= species[i - 1].id) {
+            printf("Species records must be sorted by distinct IDs.\n");
+            return false;
+        }
+    }
+    return count > 0 && installSpeciesCatalog(species, count, NULL, NULL);
+}
+
+// Double the name set and re-place every name in it
+static bool growSpeciesNameSlots(SpeciesNamePool *pool) {
+    uint32_t capacity = pool->slots ? (pool->mask + 1) * 2 : 1024;
+    uint32_t *slots = calloc(capacity, sizeof(uint32_t));
+    if (slots == NULL) return false;
+    for (uint32_t i = 0; pool->slots != NULL && i <= pool->mask; i++) {
+        if (pool->slots[i] == 0) continue;
+        uint32_t slot = hashOwnerName(pool->text + pool->slots[i] - 1) & (capacity - 1);
+        while (slots[slot] != 0)
+            slot = (slot + 1) & (capacity - 1);
+        slots[slot] = pool->slots[i];
+    }
+    free(pool->slots);
+    pool->slots = slots;
+    pool->mask = capacity - 1;
+    return true;
+}
+
+// Offset of name in the pool, appending it only if no species used the same name before
+static bool internSpeciesName(SpeciesNamePool *pool, InputView name, uint32_t *offset) {
+    if (pool->used * 2 >= (pool->slots ? pool->mask + 1 : 0) && !growSpeciesNameSlots(pool)) {
+        printf("Memory allocation failed.\n");
+        return false;
     }
 
-    int c;
-    while ((c = getchar()) != '\n' && c != EOF) {
-        if (size + 1 >= capacity) {
+    // Append it tentatively, so it can be hashed and compared as a string
+    if (pool->size + name.length + 1 > pool->capacity) {
+        size_t capacity = pool->capacity ? pool->capacity * 2 : INPUT_CHUNK_BYTES;
+        while (capacity < pool->size + name.length + 1)
             capacity *= 2;
-            char *temp = (char *) realloc(input, capacity);
-            if (!temp) {
-                printf("Memory reallocation failed.\n");
-                free(input);
-                return NULL;
+        // Offsets are uint32_t, so the pool stays under 4 GiB
+        char *text = capacity <= UINT32_MAX ? realloc(pool->text, capacity) : NULL;
+        if (text == NULL) {
+            printf("Memory allocation failed.\n");
+            return false;
+        }
+        pool->text = text;
+        pool->capacity = capacity;
+    }
+    char *copy = pool->text + pool->size;
+    memcpy(copy, name.text, name.length);
+    copy[name.length] = '\0';
+
+    uint32_t slot = hashOwnerName(copy) & pool->mask;
+    for (; pool->slots[slot] != 0; slot = (slot + 1) & pool->mask) {
+        if (strcmp(pool->text + pool->slots[slot] - 1, copy) == 0) {
+            // Seen before: share that copy and drop this one
+            *offset = pool->slots[slot] - 1;
+            return true;
+        }
+    }
+    *offset = (uint32_t) pool->size;
+    pool->slots[slot] = *offset + 1;
+    pool->used++;
+    pool->size += name.length + 1;
+    return true;
+}
+
+// Parse "id,name,TYPE,hp,attack,canEvolve" into species (name left out) and name
+static bool parseSpeciesLine(InputView line, PokemonData *species, InputView *name) {
+    InputView fields[6];
+    int count = 0;
+    const char *p = line.text, *end = line.text + line.length;
+    while (true) {
+        const char *comma = memchr(p, ',', (size_t) (end - p));
+        const char *stop = comma ? comma : end;
+        if (count == 6) return false;
+        fields[count].text = p;
+        fields[count].length = (size_t) (stop - p);
+        trimInputView(&fields[count++]);
+        if (comma == NULL) break;
+        p = comma + 1;
+    }
+    if (count != 6) return false;
+
+    // IDs stay below INT_MAX so "the next ID" (evolution) always exists as an int
+    int canEvolve;
+    if (!parseIntView(fields[0].text, fields[0].length, &species->id) || species->id < 1 || species->id == INT_MAX ||
+        !parseIntView(fields[3].text, fields[3].length, &species->hp) ||
+        !parseIntView(fields[4].text, fields[4].length, &species->attack) ||
+        !parseIntView(fields[5].text, fields[5].length, &canEvolve) || (canEvolve != 0 && canEvolve != 1))
+        return false;
+    species->CAN_EVOLVE = canEvolve ? CAN_EVOLVE : CANNOT_EVOLVE;
+
+    // The type is one of the printed names
+    int type = findTypeByName(fields[2].text, fields[2].length);
+    if (type < 0) return false;
+    species->TYPE = (PokemonType) type;
+
+    *name = fields[1];
+    return name->length > 0 && name->length <= SPECIES_NAME_MAX && memchr(name->text, '\0', name->length) == NULL;
+}
+
+static int compareSpeciesIds(const void *a, const void *b) {
+    int first = ((const PokemonData *) a)->id, second = ((const PokemonData *) b)->id;
+    return (first > second) - (first < second);
+}
+
+// Read every line of a catalog file into species[] and its name pool
+static int readSpeciesFile(int fd, PokemonData **species, SpeciesNamePool *names) {
+    InputReader reader = { fd, NULL, 0, 0, 0, false, false };
+    uint32_t *nameOffsets = NULL;
+    int count = 0, capacity = 0;
+    size_t lineNumber = 0;
+    bool ok = true;
+    InputView line;
+    while (ok && readInputLine(&reader, &line)) {
+        lineNumber++;
+        trimInputView(&line);
+        if (line.length == 0 || line.text[0] == '#') continue;
+
+        if (count == capacity) {
+            int grown = capacity ? capacity * 2 : 256;
+            PokemonData *moreSpecies = grown < (1 << 30) ? realloc(*species, grown * sizeof(PokemonData)) : NULL;
+            if (moreSpecies != NULL) *species = moreSpecies;
+            uint32_t *moreOffsets = moreSpecies ? realloc(nameOffsets, grown * sizeof(uint32_t)) : NULL;
+            if (moreOffsets == NULL) {
+                printf("Memory allocation failed.\n");
+                ok = false;
+                break;
+            }
+            nameOffsets = moreOffsets;
+            capacity = grown;
+        }
+
+        InputView name;
+        if (!parseSpeciesLine(line, &(*species)[count], &name)) {
+            printf("Invalid species catalog line %zu.\n", lineNumber);
+            ok = false;
+        } else {
+            ok = internSpeciesName(names, name, &nameOffsets[count]);
+            count++;
+        }
+    }
+    resetInputReader(&reader);
+
+    // The pool no longer moves: turn the offsets into name pointers
+    for (int i = 0; ok && i < count; i++)
+        (*species)[i].name = names->text + nameOffsets[i];
+    free(nameOffsets);
+    return ok ? count : -1;
+}
+
+bool loadSpeciesCatalog(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Cannot open %s.\n", path);
+        return false;
+    }
+    PokemonData *species = NULL;
+    SpeciesNamePool names = { NULL, 0, 0, NULL, 0, 0 };
+    int count = readSpeciesFile(fd, &species, &names);
+    close(fd);
+    free(names.slots);
+    if (count == 0)
+        printf("Species catalog %s is empty.\n", path);
+
+    // Sort by ID: the index maps IDs to positions, and positions order the trees like IDs
+    bool ok = count > 0;
+    if (ok) {
+        qsort(species, (size_t) count, sizeof(PokemonData), compareSpeciesIds);
+        for (int i = 1; ok && i < count; i++) {
+            if (species[i].id == species[i - 1].id) {
+                printf("Duplicate species ID %d in the catalog.\n", species[i].id);
+                ok = false;
             }
-            input = temp;
         }
-        input[size++] = (char) c;
     }
-    input[size] = '\0';
+    if (!ok || !installSpeciesCatalog(species, count, species, names.text)) {
+        free(species);
+        free(names.text);
+        return false;
+    }
+    return true;
+}
+
+void freeSpeciesCatalog(void) {
+    free(speciesCatalog.columns);
+    free(speciesCatalog.direct);
+    free(speciesCatalog.slots);
+    free(speciesCatalog.nameRanks);
+    free(speciesCatalog.byNameRank);
+    free(speciesCatalog.loaded);
+    free(speciesCatalog.namePool);
+    speciesCatalog = (SpeciesCatalog) BUILTIN_SPECIES_CATALOG;
+
+    // No display can be running (there are no owners), so the ranks may be sorted again
+    pthread_once_t fresh = PTHREAD_ONCE_INIT;
+    speciesNameRanksOnce = fresh;
+}
+
+// --------------------------------------------------------------
+// Output sink (one big buffer, flushed with write)
+// --------------------------------------------------------------
+void flushOutputSink(void) {
+    if (outputSink.size == 0) return;
+
+    // Anything printf already buffered was printed first, so it goes out first
+    fflush(stdout);
+    size_t written = 0;
+    while (written < outputSink.size) {
+        ssize_t result = write(STDOUT_FILENO, outputSink.buffer + written, outputSink.size - written);
+        if (result <= 0) break;
+        written += (size_t) result;
+    }
+    outputSink.size = 0;
+}
+
+char *reserveOutputSink(size_t length) {
+    // Make room by flushing; a record bigger than the whole buffer doesn't fit
+    if (length > OUTPUT_SINK_BYTES - outputSink.size)
+        flushOutputSink();
+    if (length > OUTPUT_SINK_BYTES)
+        return NULL;
+    return outputSink.buffer + outputSink.size;
+}
+
+void commitOutputSink(const char *end) {
+    outputSink.size = (size_t) (end - outputSink.buffer);
+}
+
+// Copy length bytes to out, return the position after them
+static char *appendText(char *out, const char *text, size_t length) {
+    memcpy(out, text, length);
+    return out + length;
+}
+
+// Two-digit strings "00".."99", so numbers are written two digits per division
+static const char digitPairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Write value in decimal like printf's %d (at most 11 chars), return the position after it
+static char *appendInt(char *out, int value) {
+    unsigned int magnitude = value < 0 ? 0u - (unsigned int) value : (unsigned int) value;
+    if (value < 0)
+        *out++ = '-';
+
+    // HP, attack and species IDs are short: handle up to three digits directly
+    if (magnitude < 10) {
+        *out = (char) ('0' + magnitude);
+        return out + 1;
+    }
+    if (magnitude < 100) {
+        memcpy(out, digitPairs + magnitude * 2, 2);
+        return out + 2;
+    }
+    if (magnitude < 1000) {
+        *out = (char) ('0' + magnitude / 100);
+        memcpy(out + 1, digitPairs + (magnitude % 100) * 2, 2);
+        return out + 3;
+    }
+
+    // Count the digits, then fill them in from the end two at a time
+    int length = 1;
+    for (unsigned int rest = magnitude; rest >= 10; rest /= 10)
+        length++;
+    char *end = out + length;
+    while (magnitude >= 100) {
+        end -= 2;
+        memcpy(end, digitPairs + (magnitude % 100) * 2, 2);
+        magnitude /= 100;
+    }
+    if (magnitude >= 10) {
+        end -= 2;
+        memcpy(end, digitPairs + magnitude * 2, 2);
+    } else {
+        *--end = (char) ('0' + magnitude);
+    }
+    return out + length;
+}
 
-    // Trim any leading/trailing whitespace or carriage returns
-    trimWhitespace(input);
+// Print "<open><number><close><name>\n" (owner lists), through the sink when it fits
+static void printNumberedName(const char *open, int number, const char *close, const char *name) {
+    size_t openLength = strlen(open), closeLength = strlen(close), nameLength = strlen(name);
+    char *out = reserveOutputSink(openLength + 11 + closeLength + nameLength + 1);
+    if (out == NULL) {
+        // Too long for the buffer (which is now flushed): plain printf
+        printf("%s%d%s%s\n", open, number, close, name);
+        return;
+    }
+    out = appendText(out, open, openLength);
+    out = appendInt(out, number);
+    out = appendText(out, close, closeLength);
+    out = appendText(out, name, nameLength);
+    *out++ = '\n';
+    commitOutputSink(out);
+}
 
+// --------------------------------------------------------------
+// Utility: getDynamicInput (for reading a line into malloc'd memory)
+// --------------------------------------------------------------
+char *getDynamicInput() {
+    // The rest of the line (empty at end of input), cut at a '\0' and trimmed in place
+    InputView line = { "", 0 };
+    readInputLine(&stdinReader, &line);
+    line.length = viewStringLength(&line);
+    trimInputView(&line);
+
+    // One exact-size copy instead of growing a buffer char by char
+    char *input = (char *) malloc(line.length + 1);
+    if (!input) {
+        printf("Memory allocation failed.\n");
+        return NULL;
+    }
+    memcpy(input, line.text, line.length);
+    input[line.length] = '\0';
     return input;
 }
 
@@ -175,30 +815,44 @@ char *getDynamicInput() {
 void printPokemonNode(PokemonNode *node) {
     if (!node)
         return;
+
+    // The fixed text, four numbers and the type fit in 96 bytes; the name is extra
+    const PokemonData *data = nodeData(node);
+    size_t nameLength = strlen(data->name);
+    char *out = (size_t) data->TYPE < typeNameCount ? reserveOutputSink(96 + nameLength) : NULL;
+    if (out != NULL) {
+        out = appendText(out, "ID: ", 4);
+        out = appendInt(out, data->id);
+        out = appendText(out, ", Name: ", 8);
+        out = appendText(out, data->name, nameLength);
+        out = appendText(out, ", Type: ", 8);
+        out = appendText(out, typeNames[data->TYPE].name, typeNames[data->TYPE].length);
+        out = appendText(out, ", HP: ", 6);
+        out = appendInt(out, data->hp);
+        out = appendText(out, ", Attack: ", 10);
+        out = appendInt(out, data->attack);
+        if (data->CAN_EVOLVE == CAN_EVOLVE)
+            out = appendText(out, ", Can Evolve: Yes\n", 18);
+        else
+            out = appendText(out, ", Can Evolve: No\n", 17);
+        commitOutputSink(out);
+        return;
+    }
+
+    // Unknown type or a huge name: plain printf, after whatever the sink still holds
+    flushOutputSink();
     printf("ID: %d, Name: %s, Type: %s, HP: %d, Attack: %d, Can Evolve: %s\n",
-           node->data->id,
-           node->data->name,
-           getTypeName(node->data->TYPE),
-           node->data->hp,
-           node->data->attack,
-           (node->data->CAN_EVOLVE == CAN_EVOLVE) ? "Yes" : "No");
+           data->id,
+           data->name,
+           getTypeName(data->TYPE),
+           data->hp,
+           data->attack,
+           (data->CAN_EVOLVE == CAN_EVOLVE) ? "Yes" : "No");
 }
 
 int BFSTreeHeight(PokemonNode *root) {
-    // Base case: if the tree is empty, its height is 0
-    if (root == NULL)
-        return 0;
-
-    // Recursively find the height of the left subtree
-    int left = BFSTreeHeight(root->left);
-
-    // Recursively find the height of the right subtree
-    int right = BFSTreeHeight(root->right);
-
-    // The height of the tree is the greater of the two subtree heights plus one for the root
-    if (left > right)
-        return left + 1;
-    return right + 1;
+    // The AVL tree keeps every subtree height up to date, so no walk is needed
+    return nodeHeight(root);
 }
 
 void visitPokemonByLevel(PokemonNode *root, int level, VisitNodeFunc visit) {
@@ -215,35 +869,250 @@ void visitPokemonByLevel(PokemonNode *root, int level, VisitNodeFunc visit) {
     }
 }
 
-void BFSGeneric(PokemonNode *root, VisitNodeFunc visit) {
+void initNodeQueue(NodeQueue *queue, int cap) {
+    // Round the capacity up to a power of two so wrapping is a mask
+    int capacity = 1;
+    while (capacity < cap)
+        capacity *= 2;
+
+    queue->items = malloc(capacity * sizeof(PokemonNode *));
+    queue->head = 0;
+    queue->count = 0;
+    queue->capacity = queue->items ? capacity : 0;
+    if (queue->items == NULL) {
+        printf("Memory allocation failed.\n");
+    }
+}
+
+bool enqueueNode(NodeQueue *queue, PokemonNode *node) {
+    // Full ring: copy it in order into one twice as big
+    if (queue->count == queue->capacity) {
+        int newCapacity = queue->capacity ? queue->capacity * 2 : 16;
+        PokemonNode **items = malloc(newCapacity * sizeof(PokemonNode *));
+        if (items == NULL) {
+            printf("Memory allocation failed.\n");
+            return false;
+        }
+        for (int i = 0; i < queue->count; i++)
+            items[i] = queue->items[(queue->head + i) & (queue->capacity - 1)];
+        free(queue->items);
+        queue->items = items;
+        queue->head = 0;
+        queue->capacity = newCapacity;
+    }
+
+    queue->items[(queue->head + queue->count) & (queue->capacity - 1)] = node;
+    queue->count++;
+    return true;
+}
+
+PokemonNode *dequeueNode(NodeQueue *queue) {
+    PokemonNode *node = queue->items[queue->head];
+    queue->head = (queue->head + 1) & (queue->capacity - 1);
+    queue->count--;
+    return node;
+}
+
+// Reverse items[from..to) in place
+static void reverseNodes(PokemonNode **items, int from, int to) {
+    for (to--; from < to; from++, to--) {
+        PokemonNode *temp = items[from];
+        items[from] = items[to];
+        items[to] = temp;
+    }
+}
+
+PokemonNode **linearizeNodeQueue(NodeQueue *queue) {
+    // Only a run that wraps past the end of the ring needs moving
+    if (queue->head + queue->count > queue->capacity) {
+        // Rotating the whole ring left by head puts the oldest node at index 0
+        reverseNodes(queue->items, 0, queue->head);
+        reverseNodes(queue->items, queue->head, queue->capacity);
+        reverseNodes(queue->items, 0, queue->capacity);
+        queue->head = 0;
+    }
+    return queue->items + queue->head;
+}
+
+void freeNodeQueue(NodeQueue *queue) {
+    free(queue->items);
+    queue->items = NULL;
+    queue->head = queue->count = queue->capacity = 0;
+}
+
+void BFSGenericQueue(PokemonNode *root, VisitNodeFunc visit, NodeQueue *queue) {
+    // Base case: if the tree is empty, return
+    if (!root) return;
+
+    // Start from an empty queue holding only the root
+    queue->head = queue->count = 0;
+    if (!enqueueNode(queue, root)) return;
+
+    // Pop a node, visit it, then queue its children for the next levels
+    while (queue->count > 0) {
+        PokemonNode *node = dequeueNode(queue);
+        STAT_NODES(1);
+        visit(node);
+        if (node->left && !enqueueNode(queue, node->left)) return;
+        if (node->right && !enqueueNode(queue, node->right)) return;
+    }
+}
+
+void BFSLevelsGeneric(PokemonNode *root, VisitLevelFunc visit, NodeQueue *queue) {
     // Base case: if the tree is empty, return
     if (!root) return;
 
-    // Iterate through each level and visit nodes
-    for (int i = 1, height = BFSTreeHeight(root); i <= height; i++) {
-        visitPokemonByLevel(root, i, visit);
+    queue->head = queue->count = 0;
+    if (!enqueueNode(queue, root)) return;
+
+    // The queue holds exactly one level at the top of each iteration
+    for (int level = 1; queue->count > 0; level++) {
+        int levelSize = queue->count;
+        visit(linearizeNodeQueue(queue), levelSize, level);
+
+        for (int i = 0; i < levelSize; i++) {
+            PokemonNode *node = dequeueNode(queue);
+            if (node->left && !enqueueNode(queue, node->left)) return;
+            if (node->right && !enqueueNode(queue, node->right)) return;
+        }
     }
 }
 
+void BFSGeneric(PokemonNode *root, VisitNodeFunc visit) {
+    // Base case: if the tree is empty, return
+    if (!root) return;
+
+    STAT_BEGIN(STAT_BFS, span);
+
+    // A balanced tree's widest level is about half its nodes, 2^(height-1)
+    NodeQueue queue;
+    int height = BFSTreeHeight(root);
+    initNodeQueue(&queue, height < 16 ? 1 << (height - 1) : 1 << 15);
+    BFSGenericQueue(root, visit, &queue);
+    freeNodeQueue(&queue);
+    STAT_END(STAT_BFS, span);
+}
+
 void displayBFS(PokemonNode *root) {
     // Base case: if the tree is empty, return
     if (!root) return;
 
     // Perform BFS traversal and print each node
     BFSGeneric(root, printPokemonNode);
+    flushOutputSink();
 }
 
 
-void preOrderGeneric(PokemonNode *root, VisitNodeFunc visit) {
-    // Base case: if the tree is empty, return
-    if (!root) return;
+// Move the cursor's path to a heap stack twice the size (the inline one is outgrown)
+static bool growCursor(TreeCursor *cursor) {
+    int capacity = cursor->capacity * 2;
+    PokemonNode **stack = cursor->stack == cursor->inlineStack ? NULL : cursor->stack;
+    stack = realloc(stack, capacity * sizeof(PokemonNode *));
+    if (stack == NULL) {
+        printf("Memory allocation failed.\n");
+        cursor->failed = true;
+        return false;
+    }
+    if (cursor->stack == cursor->inlineStack)
+        memcpy(stack, cursor->inlineStack, cursor->depth * sizeof(PokemonNode *));
+    cursor->stack = stack;
+    cursor->capacity = capacity;
+    return true;
+}
+
+static inline bool pushCursor(TreeCursor *cursor, PokemonNode *node) {
+    if (cursor->depth == cursor->capacity && !growCursor(cursor)) return false;
+    cursor->stack[cursor->depth++] = node;
+    return true;
+}
+
+void treeCursorInit(TreeCursor *cursor, PokemonNode *root, TraversalOrder order) {
+    cursor->order = order;
+    cursor->stack = cursor->inlineStack;
+    cursor->depth = 0;
+    cursor->capacity = CURSOR_INLINE_DEPTH;
+    cursor->last = NULL;
+    cursor->failed = false;
+
+    // Pre-order starts from the root on the stack; the others descend into it first
+    cursor->current = order == TRAVERSE_PRE ? NULL : root;
+    if (order == TRAVERSE_PRE && root != NULL)
+        pushCursor(cursor, root);
+}
+
+PokemonNode *treeCursorNext(TreeCursor *cursor) {
+    if (cursor->failed) return NULL;
+
+    if (cursor->order == TRAVERSE_PRE) {
+        // Pop the node, then queue its right subtree under its left one
+        if (cursor->depth == 0) return NULL;
+        PokemonNode *node = cursor->stack[--cursor->depth];
+        if (node->right != NULL && !pushCursor(cursor, node->right)) return NULL;
+        if (node->left != NULL && !pushCursor(cursor, node->left)) return NULL;
+        return node;
+    }
+
+    for (;;) {
+        // Go down the left spine of the pending subtree
+        while (cursor->current != NULL) {
+            if (!pushCursor(cursor, cursor->current)) return NULL;
+            cursor->current = cursor->current->left;
+        }
+        if (cursor->depth == 0) return NULL;
+
+        PokemonNode *top = cursor->stack[cursor->depth - 1];
+        if (cursor->order == TRAVERSE_IN) {
+            // Left subtree done: the node, then its right subtree
+            cursor->depth--;
+            cursor->current = top->right;
+            return top;
+        }
+
+        // Post-order: finish the right subtree first, unless we just came back from it
+        if (top->right != NULL && top->right != cursor->last) {
+            cursor->current = top->right;
+            continue;
+        }
+        cursor->depth--;
+        cursor->last = top;
+        return top;
+    }
+}
+
+void treeCursorFree(TreeCursor *cursor) {
+    if (cursor->stack != cursor->inlineStack)
+        free(cursor->stack);
+    cursor->stack = cursor->inlineStack;
+    cursor->capacity = CURSOR_INLINE_DEPTH;
+    cursor->depth = 0;
+}
+
+bool traverseTree(PokemonNode *root, TraversalOrder order, VisitNodeCtxFunc visit, void *ctx) {
+    TreeCursor cursor;
+    treeCursorInit(&cursor, root, order);
+    bool finished = true;
+    for (PokemonNode *node = treeCursorNext(&cursor); node != NULL; node = treeCursorNext(&cursor)) {
+        if (!visit(node, ctx)) {
+            finished = false;
+            break;
+        }
+    }
+    finished = finished && !cursor.failed;
+    treeCursorFree(&cursor);
+    return finished;
+}
+
+// The context-free traversals: a cursor walk calling visit on every node
+static void visitEveryNode(PokemonNode *root, TraversalOrder order, VisitNodeFunc visit) {
+    TreeCursor cursor;
+    treeCursorInit(&cursor, root, order);
+    for (PokemonNode *node = treeCursorNext(&cursor); node != NULL; node = treeCursorNext(&cursor))
+        visit(node);
+    treeCursorFree(&cursor);
+}
 
-    // Visit the current node
-    visit(root);
-    // Recursively visit the left subtree
-    preOrderGeneric(root->left, visit);
-    // Recursively visit the right subtree
-    preOrderGeneric(root->right, visit);
+void preOrderGeneric(PokemonNode *root, VisitNodeFunc visit) {
+    visitEveryNode(root, TRAVERSE_PRE, visit);
 }
 
 void preOrderTraversal(PokemonNode *root) {
@@ -252,18 +1121,11 @@ void preOrderTraversal(PokemonNode *root) {
 
     // Perform pre-order traversal and print each node
     preOrderGeneric(root, printPokemonNode);
+    flushOutputSink();
 }
 
 void inOrderGeneric(PokemonNode *root, VisitNodeFunc visit) {
-    // Base case: if the tree is empty, return
-    if (!root) return;
-
-    // Recursively visit the left subtree
-    inOrderGeneric(root->left, visit);
-    // Visit the current node
-    visit(root);
-    // Recursively visit the right subtree
-    inOrderGeneric(root->right, visit);
+    visitEveryNode(root, TRAVERSE_IN, visit);
 }
 
 void inOrderTraversal(PokemonNode *root) {
@@ -271,19 +1133,13 @@ void inOrderTraversal(PokemonNode *root) {
     if (!root) return;
 
     // Perform in-order traversal and print each node
-    inOrderGeneric(root, printPokemonNode);}
+    inOrderGeneric(root, printPokemonNode);
+    flushOutputSink();
+}
 
 
 void postOrderGeneric(PokemonNode *root, VisitNodeFunc visit) {
-    // Base case: if the tree is empty, return
-    if (!root) return;
-
-    // Recursively visit the left subtree
-    postOrderGeneric(root->left, visit);
-    // Recursively visit the right subtree
-    postOrderGeneric(root->right, visit);
-    // Visit the current node
-    visit(root);
+    visitEveryNode(root, TRAVERSE_POST, visit);
 }
 
 void postOrderTraversal(PokemonNode *root) {
@@ -292,6 +1148,7 @@ void postOrderTraversal(PokemonNode *root) {
 
     // Perform post-order traversal and print each node
     postOrderGeneric(root, printPokemonNode);
+    flushOutputSink();
 }
 
 void initNodeArray(NodeArray *na, int cap) {
@@ -309,33 +1166,48 @@ void initNodeArray(NodeArray *na, int cap) {
 }
 
 void collectAll(PokemonNode *root, NodeArray *na) {
-    // Base case: if the tree is empty, return
-    if (!root) return;
+    // Pre-order walk, appending every node to the array
+    TreeCursor cursor;
+    treeCursorInit(&cursor, root, TRAVERSE_PRE);
+    for (PokemonNode *node = treeCursorNext(&cursor); node != NULL; node = treeCursorNext(&cursor))
+        addNode(na, node);
+    treeCursorFree(&cursor);
+}
 
+void addNode(NodeArray *na, PokemonNode *node) {
     // Check if the array needs to be resized
     if (na->size >= na->capacity) {
-        na->capacity *= 2;
-        na->nodes = realloc(na->nodes, na->capacity * sizeof(PokemonNode *));
-        if (na->nodes == NULL) {
-            // If memory reallocation fails, print an error message and return
+        int newCapacity = na->capacity ? na->capacity * 2 : 16;
+        PokemonNode **nodes = realloc(na->nodes, newCapacity * sizeof(PokemonNode *));
+        if (nodes == NULL) {
             printf("Memory reallocation failed.\n");
             return;
         }
+        na->nodes = nodes;
+        na->capacity = newCapacity;
     }
 
-    // Add the current node to the array
-    na->nodes[na->size++] = root;
+    // Add the node at the end of the array
+    na->nodes[na->size++] = node;
+}
 
-    // Recursively collect nodes from the left subtree
-    collectAll(root->left, na);
+int countPokemonNodes(PokemonNode *root) {
+    // Every node knows its subtree's size
+    return root ? (int) root->size : 0;
+}
 
-    // Recursively collect nodes from the right subtree
-    collectAll(root->right, na);
+void collectInOrder(PokemonNode *root, NodeArray *na) {
+    // Left subtree, then the node, then the right subtree => ascending IDs
+    TreeCursor cursor;
+    treeCursorInit(&cursor, root, TRAVERSE_IN);
+    for (PokemonNode *node = treeCursorNext(&cursor); node != NULL; node = treeCursorNext(&cursor))
+        addNode(na, node);
+    treeCursorFree(&cursor);
 }
 
 // Function to compare two PokemonNode pointers by the name of the Pokemon
 int compareByNameNode(const void *a, const void *b) {
-    return strcmp((*(PokemonNode **)a)->data->name, (*(PokemonNode **)b)->data->name);
+    return strcmp(nodeData(*(PokemonNode **)a)->name, nodeData(*(PokemonNode **)b)->name);
 }
 
 // Function to compare two OwnerNode pointers by the owner's name
@@ -343,39 +1215,88 @@ int compareOwnerNames(const void *a, const void *b) {
     return strcmp((*(OwnerNode **)a)->ownerName, (*(OwnerNode **)b)->ownerName);
 }
 
-void displayAlphabetical(PokemonNode *root) {
-    // Base case: if the tree is empty, return
-    if (!root) return;
+// Sort species positions by name (once: the catalog's names never change); equal names,
+// which share one interned copy, keep their ID order
+static int compareSpeciesNames(const void *a, const void *b) {
+    uint32_t first = *(const uint32_t *) a, second = *(const uint32_t *) b;
+    const char *firstName = speciesCatalog.species[first].name, *secondName = speciesCatalog.species[second].name;
+    int order = firstName == secondName ? 0 : strcmp(firstName, secondName);
+    return order != 0 ? order : (first > second) - (first < second);
+}
 
-    // Allocate memory for NodeArray
-    NodeArray *array = (NodeArray *) malloc(sizeof(NodeArray));
-    if (array == NULL) {
+static void buildSpeciesNameRanks(void) {
+    SpeciesCatalog *catalog = &speciesCatalog;
+    uint32_t *byRank = malloc((size_t) catalog->count * sizeof(uint32_t));
+    uint32_t *ranks = malloc((size_t) catalog->count * sizeof(uint32_t));
+    if (byRank == NULL || ranks == NULL) {
+        // Displays fall back to sorting by name
         printf("Memory allocation failed.\n");
+        free(byRank);
+        free(ranks);
         return;
     }
+    for (int i = 0; i < catalog->count; i++)
+        byRank[i] = (uint32_t) i;
+    qsort(byRank, (size_t) catalog->count, sizeof(uint32_t), compareSpeciesNames);
+
+    // Invert: the position of each species in the sorted list is its rank
+    for (int rank = 0; rank < catalog->count; rank++)
+        ranks[byRank[rank]] = (uint32_t) rank;
+    catalog->byNameRank = byRank;
+    catalog->nameRanks = ranks;
+}
 
-    // Initialize NodeArray and collect all nodes
-    initNodeArray(array, BFSTreeHeight(root));
-    collectAll(root, array);
+void initSpeciesNameRanks(void) {
+    // Concurrent readers may get here together, only one of them sorts
+    pthread_once(&speciesNameRanksOnce, buildSpeciesNameRanks);
+}
 
-    // Sort nodes alphabetically by name
-    qsort(array->nodes, array->size, sizeof(PokemonNode *), compareByNameNode);
+static int compareNodeNameRanks(const void *a, const void *b) {
+    uint32_t first = speciesCatalog.nameRanks[(*(PokemonNode **) a)->species];
+    uint32_t second = speciesCatalog.nameRanks[(*(PokemonNode **) b)->species];
+    return (first > second) - (first < second);
+}
 
-    // Print the sorted nodes
-    for (int i = 0; i < array->size; i++) {
-        printPokemonNode(array->nodes[i]);
+void displayAlphabetical(PokemonNode *root) {
+    // Base case: if the tree is empty, return
+    if (!root) return;
+    initSpeciesNameRanks();
+    const SpeciesCatalog *catalog = &speciesCatalog;
+
+    if (catalog->nameRanks != NULL && catalog->count <= RANK_SLOTS_MAX) {
+        // A Pokedex holds each species once: drop every node into its name rank's slot
+        PokemonNode *byRank[RANK_SLOTS_MAX];
+        memset(byRank, 0, (size_t) catalog->count * sizeof(PokemonNode *));
+        TreeCursor cursor;
+        treeCursorInit(&cursor, root, TRAVERSE_PRE);
+        for (PokemonNode *node = treeCursorNext(&cursor); node != NULL; node = treeCursorNext(&cursor))
+            byRank[catalog->nameRanks[node->species]] = node;
+        treeCursorFree(&cursor);
+
+        // Filled slots in rank order are the nodes sorted by name
+        for (int rank = 0; rank < catalog->count; rank++) {
+            if (byRank[rank] != NULL)
+                printPokemonNode(byRank[rank]);
+        }
+    } else {
+        // Too many species for the slots: sort this Pokedex's nodes by rank (or name)
+        NodeArray nodes;
+        initNodeArray(&nodes, countPokemonNodes(root));
+        collectAll(root, &nodes);
+        qsort(nodes.nodes, (size_t) nodes.size, sizeof(PokemonNode *),
+              catalog->nameRanks != NULL ? compareNodeNameRanks : compareByNameNode);
+        for (int i = 0; i < nodes.size; i++)
+            printPokemonNode(nodes.nodes[i]);
+        free(nodes.nodes);
     }
-
-    // Free allocated memory
-    free(array->nodes);
-    free(array);
+    flushOutputSink();
 }
 
 // --------------------------------------------------------------
 // Display Menu
 // --------------------------------------------------------------
 void displayMenu(OwnerNode *owner) {
-    if (owner->pokedexRoot == NULL) {
+    if (isPokedexEmpty(owner)) {
         printf("Pokedex is empty.\n");
         return;
     }
@@ -387,42 +1308,106 @@ void displayMenu(OwnerNode *owner) {
     printf("4. Post-Order\n");
     printf("5. Alphabetical (by name)\n");
 
-    int choice = readIntSafe("Your choice: ");
+    displayPokedexOrder(owner, readIntSafe("Your choice: "));
+}
+
+static void displayPokedexOrderLocked(OwnerNode *owner, int choice) {
+    if (isPokedexEmpty(owner)) {
+        printf("Pokedex is empty.\n");
+        return;
+    }
+
+    // A bitset Pokedex has no tree: in-order and alphabetical read the bits
+    // directly, the other orders walk a temporary balanced tree of the same IDs
+    PokemonNode *root = __atomic_load_n(&owner->pokedexRoot, __ATOMIC_ACQUIRE);
+    bool temporaryTree = bitsetPokedexMode && choice != 3 && choice != 5;
+    if (temporaryTree)
+        root = pokedexBitsToTree(&owner->pokedexBits);
 
     switch (choice) {
         case 1:
-            displayBFS(owner->pokedexRoot);
+            displayBFS(root);
             break;
         case 2:
-            preOrderTraversal(owner->pokedexRoot);
+            preOrderTraversal(root);
             break;
         case 3:
-            inOrderTraversal(owner->pokedexRoot);
+            if (bitsetPokedexMode) {
+                inOrderBitsGeneric(&owner->pokedexBits, printPokemonNode);
+                flushOutputSink();
+            } else
+                inOrderTraversal(root);
             break;
         case 4:
-            postOrderTraversal(owner->pokedexRoot);
+            postOrderTraversal(root);
             break;
         case 5:
-            displayAlphabetical(owner->pokedexRoot);
+            if (bitsetPokedexMode)
+                displayAlphabeticalBits(&owner->pokedexBits);
+            else
+                displayAlphabetical(root);
             break;
         default:
             printf("Invalid choice.\n");
     }
+
+    if (temporaryTree)
+        freePokemonTree(root);
 }
 
-PokemonNode *searchPokemonBFS(PokemonNode *root, int id) {
-    // Base case: if the tree is empty, return NULL
-    if (root == NULL) return NULL;
+// Start a read of one owner: an epoch section, or its lock, so no change lands halfway through
+static bool beginOwnerRead(OwnerNode *owner) {
+    if (!epochReadsMode) return lockLiveOwner(owner);
+
+    epochEnter();
+    if (!__atomic_load_n(&owner->retired, __ATOMIC_ACQUIRE)) return true;
+    epochExit();
+    printf("Owner '%s' not found.\n", owner->ownerName);
+    return false;
+}
+
+static void endOwnerRead(OwnerNode *owner) {
+    if (epochReadsMode)
+        epochExit();
+    else
+        unlockOwner(owner);
+}
+
+void displayPokedexOrder(OwnerNode *owner, int choice) {
+    if (!beginOwnerRead(owner)) return;
+    displayPokedexOrderLocked(owner, choice);
+    endOwnerRead(owner);
+}
 
-    // If the current node's ID matches the search ID, return the current node
-    if (root->data->id == id) return root;
+PokemonNode *searchPokemonBFS(PokemonNode *root, int id) {
+    STAT_BEGIN(STAT_SEARCH_BFS, span);
+
+    // Pre-order walk that stops at the first node of the species (an unknown ID matches none)
+    uint32_t species = (uint32_t) findSpeciesPosition(id);
+    TreeCursor cursor;
+    treeCursorInit(&cursor, root, TRAVERSE_PRE);
+    PokemonNode *node = treeCursorNext(&cursor);
+    int visited = node != NULL;
+    while (node != NULL && node->species != species) {
+        node = treeCursorNext(&cursor);
+        visited++;
+    }
+    treeCursorFree(&cursor);
 
-    // Recursively search the left subtree
-    PokemonNode *leftResult = searchPokemonBFS(root->left, id);
-    if (leftResult) return leftResult;
+    STAT_NODES(visited);
+    STAT_END(STAT_SEARCH_BFS, span);
+    return node;
+}
 
-    // Recursively search the right subtree
-    return searchPokemonBFS(root->right, id);
+PokemonNode *searchPokemonBST(PokemonNode *root, int id) {
+    // Positions order the tree like IDs: turn the ID into one, then walk down one path
+    int species = findSpeciesPosition(id);
+    if (species < 0) return NULL;
+    while (root != NULL && root->species != (uint32_t) species) {
+        STAT_NODES(1);
+        root = ((uint32_t) species < root->species) ? root->left : root->right;
+    }
+    return root;
 }
 
 void pokemonFight(OwnerNode *owner) {
@@ -430,25 +1415,32 @@ void pokemonFight(OwnerNode *owner) {
     if (owner == NULL) return;
 
     // Check if the Pokedex is empty
-    if (owner->pokedexRoot == NULL) {
+    if (isPokedexEmpty(owner)) {
         printf("Pokedex is empty.\n");
         return;
     }
 
     // Prompt user to enter the IDs of the two Pokemon to fight
-    PokemonNode *firstPokemonNode = searchPokemonBFS(owner->pokedexRoot, readIntSafe("Enter ID of the first Pokemon: "));
-    PokemonNode *secondPokemonNode = searchPokemonBFS(owner->pokedexRoot, readIntSafe("Enter ID of the second Pokemon: "));
+    int firstId = readIntSafe("Enter ID of the first Pokemon: ");
+    int secondId = readIntSafe("Enter ID of the second Pokemon: ");
+    fightPokemonById(owner, firstId, secondId);
+}
+
+static void fightPokemonByIdLocked(OwnerNode *owner, int firstId, int secondId) {
+    if (isPokedexEmpty(owner)) {
+        printf("Pokedex is empty.\n");
+        return;
+    }
+
+    const PokemonData *firstPokemonData = findOwnerPokemon(owner, firstId);
+    const PokemonData *secondPokemonData = findOwnerPokemon(owner, secondId);
 
     // Check if both Pokemon IDs are found
-    if (firstPokemonNode == NULL || secondPokemonNode == NULL) {
+    if (firstPokemonData == NULL || secondPokemonData == NULL) {
         printf("One or both Pokemon IDs not found.\n");
         return;
     }
 
-    // Retrieve the data for both Pokemon
-    const PokemonData *firstPokemonData = firstPokemonNode->data;
-    const PokemonData *secondPokemonData = secondPokemonNode->data;
-
     // Calculate the scores for both Pokemon based on their attack and HP
     double firstScore = firstPokemonData->attack * 1.5 + firstPokemonData->hp * 1.2;
     double secondScore = secondPokemonData->attack * 1.5 + secondPokemonData->hp * 1.2;
@@ -463,40 +1455,259 @@ void pokemonFight(OwnerNode *owner) {
     printf("%s wins!\n", firstScore > secondScore ? firstPokemonData->name : secondPokemonData->name);
 }
 
-PokemonNode *insertPokemonNode(PokemonNode *root, PokemonNode *newNode) {
+void fightPokemonById(OwnerNode *owner, int firstId, int secondId) {
+    // Both lookups see the same Pokedex
+    if (!beginOwnerRead(owner)) return;
+    fightPokemonByIdLocked(owner, firstId, secondId);
+    endOwnerRead(owner);
+}
+
+int nodeHeight(const PokemonNode *node) {
+    // An empty subtree has height 0
+    return node ? node->height : 0;
+}
+
+// A node alone: its own species' figures, as a leaf
+static inline void initNodeSummary(PokemonNode *node) {
+    const SpeciesCatalog *catalog = &speciesCatalog;
+    node->height = 1;
+    node->size = 1;
+    node->hpSum = catalog->hp[node->species];
+    node->attackSum = catalog->attack[node->species];
+    node->maxAttack = catalog->attack[node->species];
+    node->typeMask = (uint16_t) (1u << catalog->types[node->species]);
+}
+
+// Fold a child's subtree into node's summary
+static inline void addSubtreeSummary(PokemonNode *node, const PokemonNode *child) {
+    node->size += child->size;
+    node->hpSum += child->hpSum;
+    node->attackSum += child->attackSum;
+    if (child->maxAttack > node->maxAttack) node->maxAttack = child->maxAttack;
+    node->typeMask |= child->typeMask;
+}
+
+// Count one more Pokemon of the given species in node's summary (an insert below it)
+static inline void addSpeciesToSummary(PokemonNode *node, uint32_t species) {
+    const SpeciesCatalog *catalog = &speciesCatalog;
+    node->size++;
+    node->hpSum += catalog->hp[species];
+    node->attackSum += catalog->attack[species];
+    if (catalog->attack[species] > node->maxAttack) node->maxAttack = catalog->attack[species];
+    node->typeMask |= (uint16_t) (1u << catalog->types[species]);
+}
+
+// Give to the node what source's summary covers (the same set of Pokemon, e.g. after a rotation)
+static inline void copyNodeSummary(PokemonNode *node, const PokemonNode *source) {
+    node->size = source->size;
+    node->hpSum = source->hpSum;
+    node->attackSum = source->attackSum;
+    node->maxAttack = source->maxAttack;
+    node->typeMask = source->typeMask;
+}
+
+static inline void updateNodeHeight(PokemonNode *node) {
+    int left = nodeHeight(node->left);
+    int right = nodeHeight(node->right);
+    node->height = (uint8_t) ((left > right ? left : right) + 1);
+}
+
+void updateNodeSummary(PokemonNode *node) {
+    // Start from the node itself, then fold in each child's subtree
+    initNodeSummary(node);
+    if (node->left != NULL) addSubtreeSummary(node, node->left);
+    if (node->right != NULL) addSubtreeSummary(node, node->right);
+    updateNodeHeight(node);
+}
+
+PokemonNode *rotateLeft(PokemonNode *root) {
+    // The right child moves up, its left subtree becomes our right subtree
+    PokemonNode *newRoot = root->right;
+    root->right = newRoot->left;
+    newRoot->left = root;
+
+    // The new root holds what the old one held; only the old root (now the child) is recounted
+    copyNodeSummary(newRoot, root);
+    updateNodeSummary(root);
+    updateNodeHeight(newRoot);
+    return newRoot;
+}
+
+PokemonNode *rotateRight(PokemonNode *root) {
+    // The left child moves up, its right subtree becomes our left subtree
+    PokemonNode *newRoot = root->left;
+    root->left = newRoot->right;
+    newRoot->right = root;
+
+    // The new root holds what the old one held; only the old root (now the child) is recounted
+    copyNodeSummary(newRoot, root);
+    updateNodeSummary(root);
+    updateNodeHeight(newRoot);
+    return newRoot;
+}
+
+// rebalanceNode once root's summary (all but its height) is already up to date
+static PokemonNode *restoreAvlBalance(PokemonNode *root) {
+    updateNodeHeight(root);
+    int balance = nodeHeight(root->left) - nodeHeight(root->right);
+
+    // Left-heavy: a left-right shape needs a left rotation of the child first
+    if (balance > 1) {
+        if (nodeHeight(root->left->left) < nodeHeight(root->left->right))
+            root->left = rotateLeft(root->left);
+        return rotateRight(root);
+    }
+
+    // Right-heavy: a right-left shape needs a right rotation of the child first
+    if (balance < -1) {
+        if (nodeHeight(root->right->right) < nodeHeight(root->right->left))
+            root->right = rotateRight(root->right);
+        return rotateLeft(root);
+    }
+
+    return root;
+}
+
+PokemonNode *rebalanceNode(PokemonNode *root) {
+    updateNodeSummary(root);
+    return restoreAvlBalance(root);
+}
+
+void summarizePokedex(const PokemonNode *root, PokedexSummary *summary) {
+    memset(summary, 0, sizeof(*summary));
+    if (root == NULL) return;
+    summary->count = (int) root->size;
+    summary->hpSum = root->hpSum;
+    summary->attackSum = root->attackSum;
+    summary->maxAttack = root->maxAttack;
+    summary->typeMask = root->typeMask;
+}
+
+PokemonNode *selectPokemonByRank(PokemonNode *root, int k) {
+    if (k < 0) return NULL;
+    // The left subtree holds the smaller IDs: step over it, or into it
+    while (root != NULL) {
+        int leftSize = countPokemonNodes(root->left);
+        if (k < leftSize) {
+            root = root->left;
+        } else if (k == leftSize) {
+            return root;
+        } else {
+            k -= leftSize + 1;
+            root = root->right;
+        }
+    }
+    return NULL;
+}
+
+int countPokemonOfType(const PokemonNode *root, PokemonType type) {
+    uint16_t bit = (uint16_t) (1u << type);
+    if (root == NULL || !(root->typeMask & bit)) return 0;
+
+    // Only subtrees holding the type go on the stack: at most one waiting sibling per level
+    // plus the node in hand, and a height fits in a uint8_t
+    const PokemonNode *stack[UINT8_MAX + 2];
+    int depth = 0, count = 0;
+    stack[depth++] = root;
+    while (depth > 0) {
+        const PokemonNode *node = stack[--depth];
+        count += speciesCatalog.types[node->species] == type;
+        if (node->left != NULL && (node->left->typeMask & bit)) stack[depth++] = node->left;
+        if (node->right != NULL && (node->right->typeMask & bit)) stack[depth++] = node->right;
+    }
+    return count;
+}
+
+// The recursive insert; insertPokemonNode counts it as one operation
+static PokemonNode *insertPokemonNodeAt(PokemonNode *root, PokemonNode *newNode, bool *added) {
     // Base case: if the tree is empty, return the new node
-    if (root == NULL) return newNode;
+    if (root == NULL) {
+        *added = true;
+        return newNode;
+    }
+    STAT_NODES(1);
 
     // Recursively insert the new node into the left or right subtree
-    if (newNode->data->id < root->data->id) {
-        root->left = insertPokemonNode(root->left, newNode);
-    } else if (newNode->data->id > root->data->id) {
-        root->right = insertPokemonNode(root->right, newNode);
+    if (newNode->species < root->species) {
+        root->left = insertPokemonNodeAt(root->left, newNode, added);
+    } else if (newNode->species > root->species) {
+        root->right = insertPokemonNodeAt(root->right, newNode, added);
+    } else {
+        // Duplicate ID: keep the existing node and free the new one
+        freePokemonNode(newNode);
+        return root;
     }
 
-    // Return the unchanged root node
+    // Every ancestor gains exactly the new species; then restore the AVL balance on the way back up
+    if (!*added) return root;
+    addSpeciesToSummary(root, newNode->species);
+    return restoreAvlBalance(root);
+}
+
+PokemonNode *insertPokemonNode(PokemonNode *root, PokemonNode *newNode) {
+    STAT_BEGIN(STAT_INSERT, span);
+    bool added = false;
+    root = insertPokemonNodeAt(root, newNode, &added);
+    STAT_END(STAT_INSERT, span);
     return root;
 }
 
+PokemonNode *lookupOrInsertPokemon(PokemonNode *root, const PokemonData *data, NodePool *pool, PokemonNode **found, bool *inserted) {
+    // Base case: the ID is missing, so this is where its new node belongs
+    if (root == NULL) {
+        *found = allocPokemonNode(pool, data);
+        *inserted = (*found != NULL);
+        return *found;
+    }
+    STAT_NODES(1);
+
+    uint32_t species = speciesPosition(data);
+    if (species < root->species) {
+        root->left = lookupOrInsertPokemon(root->left, data, pool, found, inserted);
+    } else if (species > root->species) {
+        root->right = lookupOrInsertPokemon(root->right, data, pool, found, inserted);
+    } else {
+        // Already in the tree: nothing changes, so no rebalancing is needed
+        *found = root;
+        *inserted = false;
+        return root;
+    }
+
+    // Every ancestor gains exactly the new species; then restore the AVL balance on the way back up
+    if (!*inserted) return root;
+    addSpeciesToSummary(root, species);
+    return restoreAvlBalance(root);
+}
+
 void addPokemon(OwnerNode *owner) {
     // Read the Pokemon ID to add
-    int pokemonId = readIntSafe("Enter ID to add: ");
+    addPokemonById(owner, readIntSafe("Enter ID to add: "));
+}
 
-    // Check if the ID is within the valid range
-    if (!(pokedex[0].id <= pokemonId && pokemonId <= pokedex[sizeof(pokedex) / sizeof(pokedex[0]) - 1].id)) {
+static void addPokemonByIdLocked(OwnerNode *owner, int pokemonId) {
+    // Check that the catalog has the ID
+    const PokemonData *species = findSpecies(pokemonId);
+    if (species == NULL) {
         printf("Invalid ID.\n");
         return;
     }
 
-    // Check if the Pokemon is already in the Pokedex
-    if (searchPokemonBFS(owner->pokedexRoot, pokemonId) != NULL) {
+    // Insert the Pokemon unless it is already in the Pokedex (one descent for both)
+    bool inserted;
+    if (!ownerAddPokemon(owner, species, &inserted)) return;
+    if (!inserted) {
         printf("Pokemon with ID %d is already in the Pokedex. No changes made.\n", pokemonId);
         return;
     }
+    journalRecord(JOURNAL_ADD, owner->ownerName, NULL, pokemonId);
+    printf("Pokemon %s (ID %d) added.\n", species->name, pokemonId);
+}
 
-    // Create a new Pokemon node and insert it into the Pokedex
-    owner->pokedexRoot = insertPokemonNode(owner->pokedexRoot, createPokemonNode(&pokedex[pokemonId - 1]));
-    printf("Pokemon %s (ID %d) added.\n", pokedex[pokemonId - 1].name, pokemonId);
+void addPokemonById(OwnerNode *owner, int pokemonId) {
+    // Pokedex changes only take their owner's lock; other owners change in parallel
+    if (!lockLiveOwner(owner)) return;
+    addPokemonByIdLocked(owner, pokemonId);
+    unlockOwner(owner);
 }
 
 void enterExistingPokedexMenu() {
@@ -515,10 +1726,7 @@ void enterExistingPokedexMenu() {
     }
 
     // Find the chosen Pokedex
-    OwnerNode *current = ownerHead;
-    for (int i = 1; i < pokedexIdx; i++) {
-        current = current->next;
-    }
+    OwnerNode *current = ownerAtPosition(pokedexIdx - 1);
 
     // Enter the chosen Pokedex menu
     printf("\nEntering %s's Pokedex...\n", current->ownerName);
@@ -534,6 +1742,9 @@ void enterExistingPokedexMenu() {
 
         // Read user's choice and handle it
         subChoice = readIntSafe("Your choice: ");
+        // Choices 1..5 map onto STAT_POKEDEX_ADD..STAT_POKEDEX_EVOLVE
+        StatOp statOp = subChoice >= 1 && subChoice <= 5 ? (StatOp) (STAT_POKEDEX_ADD + subChoice - 1) : STAT_OP_COUNT;
+        STAT_BEGIN(statOp, span);
         switch (subChoice) {
             case 1: addPokemon(current); break;
             case 2: displayMenu(current); break;
@@ -543,27 +1754,32 @@ void enterExistingPokedexMenu() {
             case 6: printf("Back to Main Menu.\n"); break;
             default: printf("Invalid choice.\n");
         }
+        if (statOp != STAT_OP_COUNT)
+            STAT_END(statOp, span);
+        checkpointJournalIfDue();
     } while (subChoice != 6);
 }
 
-PokemonNode *removeNodeBST(PokemonNode *root, int id) {
+// The recursive remove; removeNodeBST counts it as one operation
+static PokemonNode *removeNodeBSTAt(PokemonNode *root, uint32_t species) {
     if (root == NULL) {
         return NULL;
     }
+    STAT_NODES(1);
 
-    if (id < root->data->id) {
-        root->left = removeNodeBST(root->left, id);
-    } else if (id > root->data->id) {
-        root->right = removeNodeBST(root->right, id);
+    if (species < root->species) {
+        root->left = removeNodeBSTAt(root->left, species);
+    } else if (species > root->species) {
+        root->right = removeNodeBSTAt(root->right, species);
     } else {
         // Node with only one child or no child
         if (root->left == NULL) {
             PokemonNode *temp = root->right;
-            free(root);
+            freePokemonNode(root);
             return temp;
         } else if (root->right == NULL) {
             PokemonNode *temp = root->left;
-            free(root);
+            freePokemonNode(root);
             return temp;
         }
 
@@ -572,58 +1788,99 @@ PokemonNode *removeNodeBST(PokemonNode *root, int id) {
         while (temp && temp->left) temp = temp->left;
 
         // Copy the inorder successor's content to this node and delete the inorder successor
-        root->data = temp->data;
-        root->right = removeNodeBST(root->right, temp->data->id);
+        root->species = temp->species;
+        root->right = removeNodeBSTAt(root->right, temp->species);
     }
+
+    // Restore the AVL balance on the way back up
+    return rebalanceNode(root);
+}
+
+PokemonNode *removeNodeBST(PokemonNode *root, int id) {
+    STAT_BEGIN(STAT_REMOVE, span);
+
+    // An ID the catalog doesn't have can't be in the tree
+    int species = findSpeciesPosition(id);
+    if (species >= 0)
+        root = removeNodeBSTAt(root, (uint32_t) species);
+    STAT_END(STAT_REMOVE, span);
     return root;
 }
 
 void evolvePokemon(OwnerNode *owner) {
     // Check if the Pokedex is empty
-    if (owner == NULL || owner->pokedexRoot == NULL) {
+    if (owner == NULL || isPokedexEmpty(owner)) {
         printf("Cannot evolve. Pokedex empty.\n");
         return;
     }
 
     // Read the ID of the Pokemon to evolve
-    int id = readIntSafe("Enter ID of Pokemon to evolve: ");
-    PokemonNode *node = searchPokemonBFS(owner->pokedexRoot, id);
+    evolvePokemonById(owner, readIntSafe("Enter ID of Pokemon to evolve: "));
+}
+
+static void evolvePokemonByIdLocked(OwnerNode *owner, int id) {
+    if (isPokedexEmpty(owner)) {
+        printf("Cannot evolve. Pokedex empty.\n");
+        return;
+    }
+
+    const PokemonData *data = findOwnerPokemon(owner, id);
 
     // Check if the Pokemon with the given ID exists
-    if (node == NULL) {
+    if (data == NULL) {
         printf("No Pokemon with ID %d found.\n", id);
         return;
     }
 
     // Check if the Pokemon can evolve
-    if (node->data->CAN_EVOLVE == CANNOT_EVOLVE) {
+    if (data->CAN_EVOLVE == CANNOT_EVOLVE) {
         printf("Pokemon with ID %d cannot evolve.\n", id);
         return;
     }
 
+    // The evolved form is the next ID, which a loaded catalog may not have
     int envolveID = id + 1;
-    // Check if the evolved Pokemon is not already in the Pokedex
-    if (searchPokemonBFS(owner->pokedexRoot, envolveID) == NULL) {
-        // Create a new node for the evolved Pokemon and insert it into the Pokedex
-        owner->pokedexRoot = insertPokemonNode(owner->pokedexRoot, createPokemonNode(&pokedex[envolveID]));
+    const PokemonData *evolved = findSpecies(envolveID);
+    if (evolved == NULL) {
+        printf("Pokemon with ID %d cannot evolve.\n", id);
+        return;
     }
 
+    // Insert the evolved Pokemon unless it is already there
+    bool inserted;
+    if (!ownerAddPokemon(owner, evolved, &inserted)) return;
+
     // Print the evolution details
-    printf("Pokemon evolved from %s (ID %d) to %s (ID %d).\n", node->data->name, id, pokedex[id].name, envolveID);
+    printf("Pokemon evolved from %s (ID %d) to %s (ID %d).\n", data->name, id, evolved->name, envolveID);
 
     // Remove the old Pokemon
-    owner->pokedexRoot = removeNodeBST(owner->pokedexRoot, id);
+    ownerRemovePokemon(owner, id);
+    journalRecord(JOURNAL_EVOLVE, owner->ownerName, NULL, id);
 }
 
-OwnerNode *findOwnerByName(const char *name) {
+void evolvePokemonById(OwnerNode *owner, int id) {
+    // The add and the remove happen under one lock, so nobody sees both IDs
+    if (!lockLiveOwner(owner)) return;
+    evolvePokemonByIdLocked(owner, id);
+    unlockOwner(owner);
+}
+
+// findOwnerByName without the stats
+static OwnerNode *findOwnerByNameUncounted(const char *name) {
     // Check if the name or ownerHead is NULL
     if (name == NULL || ownerHead == NULL) {
         return NULL;
     }
 
+    // The hash index answers directly unless an insert into it failed
+    if (!ownerIndex.outOfSync) {
+        return ownerIndexFind(name);
+    }
+
     // Start searching from the head of the circular list
     OwnerNode *tempOwner = ownerHead;
     do {
+        STAT_NODES(1);
         // Compare the current owner's name with the given name
         if (strcmp(tempOwner->ownerName, name) == 0) {
             return tempOwner; // Return the owner if found
@@ -635,36 +1892,326 @@ OwnerNode *findOwnerByName(const char *name) {
     return NULL;
 }
 
+OwnerNode *findOwnerByName(const char *name) {
+    STAT_BEGIN(STAT_FIND_OWNER, span);
+    OwnerNode *owner = findOwnerByNameUncounted(name);
+    STAT_END(STAT_FIND_OWNER, span);
+    return owner;
+}
+
 PokemonNode *createPokemonNode(const PokemonData *data) {
     // Allocate memory for the new node
     PokemonNode *pokeNode = (PokemonNode *) malloc(sizeof(PokemonNode));
+    __atomic_fetch_add(&nodeMallocCount, 1, __ATOMIC_RELAXED);
     if (pokeNode == NULL) {
         printf("Memory allocation failed.\n");
         return NULL;
     }
 
-    // Initialize the node's data and pointers
-    pokeNode->data = (void *) data;
+    // Initialize the node's species and pointers
+    pokeNode->species = speciesPosition(data);
     pokeNode->left = pokeNode->right = NULL;
+    initNodeSummary(pokeNode);
+    pokeNode->pooled = false;
     return pokeNode;
 }
 
-OwnerNode *createOwner(char *ownerName, PokemonNode *starter) {
-    // Allocate memory for the new owner
-    OwnerNode *ownerNode = (OwnerNode *) malloc(sizeof(OwnerNode));
-    if (ownerName == NULL) {
+PokemonNode *allocPokemonNode(NodePool *pool, const PokemonData *data) {
+    if (pool == NULL || !nodePoolsEnabled)
+        return createPokemonNode(data);
+
+    PokemonNode *pokeNode;
+    if (pool->freeList != NULL) {
+        // Recycle the most recently released node
+        pokeNode = pool->freeList;
+        pool->freeList = pokeNode->right;
+    } else {
+        // Take the next never-used node, starting a new slab when the last one is full
+        if (pool->unusedInSlab == 0) {
+            __atomic_fetch_add(&nodeMallocCount, 1, __ATOMIC_RELAXED);
+            NodeSlab *slab = arenaAlloc(&ownerArena, NODE_SLAB_BYTES);
+            if (slab == NULL) {
+                printf("Memory allocation failed.\n");
+                return NULL;
+            }
+            slab->pool = pool;
+            slab->next = pool->slabs;
+            pool->slabs = slab;
+            pool->unusedInSlab = NODES_PER_SLAB;
+        }
+        PokemonNode *slabNodes = (PokemonNode *) (pool->slabs + 1);
+        pokeNode = &slabNodes[NODES_PER_SLAB - pool->unusedInSlab--];
+    }
+
+    // Initialize the node's species and pointers
+    pokeNode->species = speciesPosition(data);
+    pokeNode->left = pokeNode->right = NULL;
+    initNodeSummary(pokeNode);
+    pokeNode->pooled = true;
+    return pokeNode;
+}
+
+void releaseNodePool(NodePool *pool) {
+    // One free per slab; the nodes inside are never visited
+    NodeSlab *slab = pool->slabs;
+    while (slab != NULL) {
+        NodeSlab *next = slab->next;
+        arenaFree(&ownerArena, slab, NODE_SLAB_BYTES);
+        slab = next;
+    }
+    pool->slabs = NULL;
+    pool->freeList = NULL;
+    pool->unusedInSlab = 0;
+}
+
+void adoptNodePool(NodePool *dest, NodePool *src) {
+    if (src->slabs == NULL) return;
+
+    // Re-home src's slabs, then splice them in behind dest's newest slab, so
+    // dest keeps handing out the unused tail of its own newest slab
+    NodeSlab *last = src->slabs;
+    last->pool = dest;
+    while (last->next != NULL) {
+        last = last->next;
+        last->pool = dest;
+    }
+    if (dest->slabs == NULL) {
+        dest->slabs = src->slabs;
+        dest->unusedInSlab = src->unusedInSlab;
+    } else {
+        // The unused tail of src's newest slab is simply never handed out
+        last->next = dest->slabs->next;
+        dest->slabs->next = src->slabs;
+    }
+
+    // Append dest's free list behind src's
+    if (src->freeList != NULL) {
+        PokemonNode *tail = src->freeList;
+        while (tail->right != NULL)
+            tail = tail->right;
+        tail->right = dest->freeList;
+        dest->freeList = src->freeList;
+    }
+
+    src->slabs = NULL;
+    src->freeList = NULL;
+    src->unusedInSlab = 0;
+}
+
+OwnerNode *createOwnerWithName(const char *name, size_t nameLength) {
+    // Allocate the owner and its name next to each other in the arena
+    OwnerNode *ownerNode = arenaAlloc(&ownerArena, sizeof(OwnerNode));
+    char *arenaName = arenaAlloc(&ownerArena, nameLength + 1);
+    if (ownerNode == NULL || arenaName == NULL) {
         printf("Memory allocation failed.\n");
+        arenaFree(&ownerArena, ownerNode, sizeof(OwnerNode));
+        arenaFree(&ownerArena, arenaName, nameLength + 1);
         return NULL;
     }
+    memcpy(arenaName, name, nameLength);
+    arenaName[nameLength] = '\0';
+
     // Initialize the owner's data and pointers
-    ownerNode->ownerName = ownerName;
-    ownerNode->pokedexRoot = starter;
+    ownerNode->ownerName = arenaName;
+    ownerNode->pokedexRoot = NULL;
+    memset(&ownerNode->pokedexBits, 0, sizeof(ownerNode->pokedexBits));
+    memset(&ownerNode->nodePool, 0, sizeof(ownerNode->nodePool));
     ownerNode->next = NULL;
     ownerNode->prev = NULL;
+    pthread_mutex_init(&ownerNode->lock, NULL);
+    ownerNode->retired = false;
+    memset(&ownerNode->retiredNodes, 0, sizeof(ownerNode->retiredNodes));
+    return ownerNode;
+}
+
+OwnerNode *createOwner(char *ownerName, PokemonNode *starter) {
+    // The name moves into the arena next to its owner
+    OwnerNode *ownerNode = createOwnerWithName(ownerName, strlen(ownerName));
+    if (ownerNode == NULL) return NULL;
+    free(ownerName);
+    ownerNode->pokedexRoot = starter;
     return ownerNode;
 }
 
+uint32_t hashOwnerName(const char *name) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *) name; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Place an owner in the first free slot of its probe sequence (no resize);
+// the stores are atomic because epoch readers probe the table while it changes
+static void ownerIndexPlace(OwnerNode **slots, uint32_t *hashes, int capacity, OwnerNode *owner, uint32_t hash) {
+    int i = (int) (hash & (uint32_t) (capacity - 1));
+    while (slots[i] != NULL)
+        i = (i + 1) & (capacity - 1);
+    __atomic_store_n(&hashes[i], hash, __ATOMIC_RELAXED);
+    __atomic_store_n(&slots[i], owner, __ATOMIC_RELEASE);
+}
+
+// Seqlock around every index change, so epoch readers retry instead of locking
+static void beginOwnerIndexChange(void) {
+    __atomic_store_n(&ownerIndex.version, ownerIndex.version + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void endOwnerIndexChange(void) {
+    __atomic_store_n(&ownerIndex.version, ownerIndex.version + 1, __ATOMIC_RELEASE);
+}
+
+// Swap in new arrays (inside a change); an epoch reader may still be probing the old ones
+static void ownerIndexPublish(OwnerNode **slots, uint32_t *hashes, int capacity) {
+    if (epochReadsMode && ownerIndex.slots != NULL) {
+        retireBlock(ownerIndex.slots, false);
+        retireBlock(ownerIndex.hashes, false);
+    } else {
+        free(ownerIndex.slots);
+        free(ownerIndex.hashes);
+    }
+    // The arrays before the capacity that indexes them (readers load in the other order)
+    __atomic_store_n(&ownerIndex.slots, slots, __ATOMIC_RELEASE);
+    __atomic_store_n(&ownerIndex.hashes, hashes, __ATOMIC_RELEASE);
+    __atomic_store_n(&ownerIndex.capacity, capacity, __ATOMIC_RELEASE);
+}
+
+// After a failed insert: index every owner of the ring again (inside a change, with the
+// ring's write lock held); false leaves the index out of sync for the next try
+static bool ownerIndexRebuild(void) {
+    int count = 0;
+    if (ownerHead != NULL) {
+        OwnerNode *current = ownerHead;
+        do {
+            count++;
+            current = current->next;
+        } while (current != ownerHead);
+    }
+    int capacity = 64;
+    while (count * 10 > capacity * 7)
+        capacity *= 2;
+    OwnerNode **slots = calloc(capacity, sizeof(OwnerNode *));
+    uint32_t *hashes = malloc(capacity * sizeof(uint32_t));
+    if (slots == NULL || hashes == NULL) {
+        free(slots);
+        free(hashes);
+        return false;
+    }
+
+    OwnerNode *current = ownerHead;
+    for (int i = 0; i < count; i++) {
+        ownerIndexPlace(slots, hashes, capacity, current, hashOwnerName(current->ownerName));
+        current = current->next;
+    }
+    ownerIndexPublish(slots, hashes, capacity);
+    __atomic_store_n(&ownerIndex.count, count, __ATOMIC_RELAXED);
+    ownerIndex.outOfSync = false;
+    return true;
+}
+
+void ownerIndexInsert(OwnerNode *owner) {
+    beginOwnerIndexChange();
+    // Out of sync since a failed insert: the ring already holds this owner, so a rebuild indexes it
+    if (ownerIndex.outOfSync) {
+        ownerIndexRebuild();
+        endOwnerIndexChange();
+        return;
+    }
+
+    // Grow (doubling) before the table gets more than 70% full
+    if ((ownerIndex.count + 1) * 10 > ownerIndex.capacity * 7) {
+        int newCapacity = ownerIndex.capacity ? ownerIndex.capacity * 2 : 64;
+        OwnerNode **slots = calloc(newCapacity, sizeof(OwnerNode *));
+        uint32_t *hashes = malloc(newCapacity * sizeof(uint32_t));
+        if (slots == NULL || hashes == NULL) {
+            printf("Memory allocation failed.\n");
+            free(slots);
+            free(hashes);
+            ownerIndex.outOfSync = true;
+            endOwnerIndexChange();
+            return;
+        }
+
+        // Rehash from the cached hashes, no name is hashed again
+        for (int i = 0; i < ownerIndex.capacity; i++) {
+            if (ownerIndex.slots[i] != NULL)
+                ownerIndexPlace(slots, hashes, newCapacity, ownerIndex.slots[i], ownerIndex.hashes[i]);
+        }
+        ownerIndexPublish(slots, hashes, newCapacity);
+    }
+
+    ownerIndexPlace(ownerIndex.slots, ownerIndex.hashes, ownerIndex.capacity, owner, hashOwnerName(owner->ownerName));
+    __atomic_store_n(&ownerIndex.count, ownerIndex.count + 1, __ATOMIC_RELAXED);
+    endOwnerIndexChange();
+}
+
+OwnerNode *ownerIndexFind(const char *name) {
+    if (ownerIndex.count == 0) return NULL;
+
+    // Probe until an empty slot; strcmp only when the cached hash matches
+    uint32_t hash = hashOwnerName(name);
+    for (int i = (int) (hash & (uint32_t) (ownerIndex.capacity - 1));
+         ownerIndex.slots[i] != NULL;
+         i = (i + 1) & (ownerIndex.capacity - 1)) {
+        STAT_NODES(1);
+        if (ownerIndex.hashes[i] == hash && strcmp(ownerIndex.slots[i]->ownerName, name) == 0)
+            return ownerIndex.slots[i];
+    }
+    return NULL;
+}
+
+void ownerIndexRemove(OwnerNode *owner) {
+    // A removal is a chance to bring an out-of-sync index back (the owner is still in the ring)
+    if (ownerIndex.outOfSync) {
+        beginOwnerIndexChange();
+        ownerIndexRebuild();
+        endOwnerIndexChange();
+    }
+    if (ownerIndex.count == 0) return;
+
+    // Find the owner's slot (compare pointers, names are unique anyway)
+    int mask = ownerIndex.capacity - 1;
+    int i = (int) (hashOwnerName(owner->ownerName) & (uint32_t) mask);
+    while (ownerIndex.slots[i] != NULL && ownerIndex.slots[i] != owner)
+        i = (i + 1) & mask;
+    if (ownerIndex.slots[i] == NULL) return;
+
+    // Backward-shift: pull later entries of the cluster into the hole
+    // whenever the hole lies on their probe path, so no tombstones are needed
+    beginOwnerIndexChange();
+    int hole = i;
+    for (int j = (i + 1) & mask; ownerIndex.slots[j] != NULL; j = (j + 1) & mask) {
+        int home = (int) (ownerIndex.hashes[j] & (uint32_t) mask);
+        if (((j - home) & mask) >= ((j - hole) & mask)) {
+            __atomic_store_n(&ownerIndex.hashes[hole], ownerIndex.hashes[j], __ATOMIC_RELAXED);
+            __atomic_store_n(&ownerIndex.slots[hole], ownerIndex.slots[j], __ATOMIC_RELEASE);
+            hole = j;
+        }
+    }
+    __atomic_store_n(&ownerIndex.slots[hole], NULL, __ATOMIC_RELEASE);
+    __atomic_store_n(&ownerIndex.count, ownerIndex.count - 1, __ATOMIC_RELAXED);
+    endOwnerIndexChange();
+}
+
+void freeOwnerIndex(void) {
+    beginOwnerIndexChange();
+    free(ownerIndex.slots);
+    free(ownerIndex.hashes);
+    ownerIndex.slots = NULL;
+    ownerIndex.hashes = NULL;
+    ownerIndex.capacity = ownerIndex.count = 0;
+    ownerIndex.outOfSync = false;
+    endOwnerIndexChange();
+}
+
 void linkOwnerInCircularList(OwnerNode *newOwner) {
+    writeLockOwners();
+    linkOwnerLocked(newOwner);
+    unlockOwners();
+}
+
+void linkOwnerLocked(OwnerNode *newOwner) {
     // Check if the new owner is NULL
     if (newOwner == NULL) {
         printf("New owner is NULL.\n");
@@ -684,6 +2231,10 @@ void linkOwnerInCircularList(OwnerNode *newOwner) {
         newOwner->next = ownerHead;
         ownerHead->prev = newOwner;
     }
+
+    // Keep the name index and the registry (tail = last position) in sync with the ring
+    ownerIndexInsert(newOwner);
+    ownerRegistryInsert(ownerCount(), newOwner);
 }
 
 void openPokedexMenu() {
@@ -698,27 +2249,96 @@ void openPokedexMenu() {
         return;
     }
 
-    // Prompt for the starter Pokemon choice
-    printf("Choose Starter:\n1. Bulbasaur\n2. Charmander\n3. Squirtle\n");
-    PokemonNode *pokemon = createPokemonNode(&pokedex[(readIntSafe("Your choice: ") - 1) * 3]);
+    // Prompt for the starter Pokemon choice (a short catalog offers fewer)
+    printf("Choose Starter:\n");
+    for (int choice = 1; choice <= 3 && starterSpecies(choice) != NULL; choice++)
+        printf("%d. %s\n", choice, starterSpecies(choice)->name);
+    createPokedex(name, readIntSafe("Your choice: "));
+}
+
+void createPokedex(char *name, int starterChoice) {
+    // Check if the owner already exists
+    readLockOwners();
+    bool exists = findOwnerByName(name) != NULL;
+    unlockOwners();
+    if (exists) {
+        printf("Owner '%s' already exists. Not creating a new Pokedex.\n", name);
+        free(name);
+        return;
+    }
+
+    // Starters are the 1st, 4th and 7th species of the loaded catalog
+    const PokemonData *starter = starterSpecies(starterChoice);
+    if (starter == NULL) {
+        if (starterChoice < 1 || starterChoice > 3)
+            printf("Invalid choice.\n");
+        else
+            printf("The species catalog has no starter %d.\n", starterChoice);
+        free(name);
+        return;
+    }
+
+    // Create a new owner with the starter and link them in the circular list
+    OwnerNode *newOwner = createOwner(name, NULL);
+    if (newOwner == NULL) {
+        free(name);
+        return;
+    }
+    // Without its starter the owner is never linked or journaled (the failure is already reported)
+    bool inserted;
+    if (!ownerAddPokemon(newOwner, starter, &inserted)) {
+        freeOwnerNode(newOwner);
+        return;
+    }
 
-    // Create a new owner and link them in the circular list
-    OwnerNode *newOwner = createOwner(name, pokemon);
-    linkOwnerInCircularList(newOwner);
+    // Check the name again and link under one write lock, so two threads can't add the same name
+    writeLockOwners();
+    exists = findOwnerByName(newOwner->ownerName) != NULL;
+    if (!exists) {
+        linkOwnerLocked(newOwner);
+        journalRecord(JOURNAL_NEW, newOwner->ownerName, NULL, starterChoice);
+    }
+    unlockOwners();
+    if (exists) {
+        printf("Owner '%s' already exists. Not creating a new Pokedex.\n", newOwner->ownerName);
+        freeOwnerNode(newOwner);
+        return;
+    }
 
     // Confirm the creation of the new Pokedex
-    printf("New Pokedex created for %s with starter %s.\n", newOwner->ownerName, newOwner->pokedexRoot->data->name);
+    printf("New Pokedex created for %s with starter %s.\n", newOwner->ownerName, starter->name);
 }
 
-void removeOwnerFromCircularList(OwnerNode *target) {
-    // Check if the target or ownerHead is NULL
-    if (target == NULL || ownerHead ==NULL) {
+void deleteOwnerPokedex(OwnerNode *owner) {
+    // Only the thread that retires an owner removes it
+    if (!retireOwner(owner)) {
+        printf("Owner '%s' not found.\n", owner->ownerName);
+        return;
+    }
+    printf("Deleting %s's entire Pokedex...\n", owner->ownerName);
+    journalRecord(JOURNAL_DELETE, owner->ownerName, NULL, 0);
+    removeOwnerFromCircularList(owner);
+    printf("Pokedex deleted.\n");
+}
+
+// Free an owner no longer reachable from the ring; epoch readers may still hold it
+static void releaseUnlinkedOwner(OwnerNode *target) {
+    if (!epochReadsMode) {
+        freeOwnerNode(target);
         return;
     }
+    retireBlock(target, true);
+    reclaimRetiredBlocks(false);
+}
+
+// Unlink an owner from the ring and the name index, then free it
+static void unlinkAndFreeOwner(OwnerNode *target) {
+    // The owner leaves the name index together with the ring
+    ownerIndexRemove(target);
 
     // If there's only one node in the list
     if (target->next == target) {
-        freeOwnerNode(target);
+        releaseUnlinkedOwner(target);
         ownerHead = NULL;
         return;
     }
@@ -732,7 +2352,29 @@ void removeOwnerFromCircularList(OwnerNode *target) {
     }
 
     // Free the target node
-    freeOwnerNode(target);
+    releaseUnlinkedOwner(target);
+}
+
+// removeOwnerFromCircularList with ownerRingLock already held for writing
+static void removeOwnerLocked(OwnerNode *target) {
+    // Check if the target or ownerHead is NULL
+    if (target == NULL || ownerHead ==NULL) {
+        return;
+    }
+
+    // Drop it from the registry too (an unusable registry is rebuilt later)
+    if (ownerRegistryReady()) {
+        int position = ownerRegistryPositionOf(target);
+        if (position >= 0)
+            ownerRegistryRemoveAt(position);
+    }
+    unlinkAndFreeOwner(target);
+}
+
+void removeOwnerFromCircularList(OwnerNode *target) {
+    writeLockOwners();
+    removeOwnerLocked(target);
+    unlockOwners();
 }
 
 void deletePokedex() {
@@ -752,16 +2394,8 @@ void deletePokedex() {
         return;
     }
 
-    // Find the chosen Pokedex
-    OwnerNode *ownerNode = ownerHead;
-    for (int i = 1; i < owner; i++) {
-        ownerNode = ownerNode->next;
-    }
-
-    // Delete the chosen Pokedex
-    printf("Deleting %s's entire Pokedex...\n", ownerNode->ownerName);
-    removeOwnerFromCircularList(ownerNode);
-    printf("Pokedex deleted.\n");
+    // Delete the chosen Pokedex: the owner we retire is the one we unlink, even if the ring changes meanwhile
+    deleteOwnerPokedex(ownerAtPosition(owner - 1));
 }
 
 PokemonNode *mergeBST(PokemonNode *firstBGTRoot, PokemonNode *secondBSTRoot) {
@@ -771,21 +2405,96 @@ PokemonNode *mergeBST(PokemonNode *firstBGTRoot, PokemonNode *secondBSTRoot) {
     }
 
     // Insert the root of the second tree into the first tree
-    firstBGTRoot = insertPokemonNode(firstBGTRoot, createPokemonNode(secondBSTRoot->data));
+    firstBGTRoot = insertPokemonNode(firstBGTRoot, createPokemonNode(nodeData(secondBSTRoot)));
 
     // Recursively merge the left and right subtrees
     firstBGTRoot = mergeBST(firstBGTRoot, secondBSTRoot->left);
     return mergeBST(firstBGTRoot, secondBSTRoot->right);
 }
 
-void mergePokedexMenu() {
-    // Check if there are not enough owners to merge
-    if (ownerHead== NULL || ownerHead->next == ownerHead) {
-        printf("Not enough owners to merge.\n");
-        return;
+// Insert every node of 'source' into 'root', relinking the nodes themselves
+static PokemonNode *insertTreeNodes(PokemonNode *root, PokemonNode *source) {
+    if (source == NULL) return root;
+
+    PokemonNode *left = source->left;
+    PokemonNode *right = source->right;
+    root = insertTreeNodes(root, left);
+    root = insertTreeNodes(root, right);
+
+    // Detach the node before inserting it as a leaf (duplicates are freed)
+    source->left = source->right = NULL;
+    initNodeSummary(source);
+    return insertPokemonNode(root, source);
+}
+
+PokemonNode *mergeBSTBalanced(PokemonNode *firstRoot, PokemonNode *secondRoot) {
+    STAT_BEGIN(STAT_MERGE, span);
+
+    // If either tree is empty, the other one is already the result
+    if (firstRoot == NULL || secondRoot == NULL) {
+        STAT_END(STAT_MERGE, span);
+        return firstRoot ? firstRoot : secondRoot;
     }
 
-    printf("\n=== Merge Pokedexes ===\n");
+    // Exact sizes, so flattening never has to grow an array
+    int firstCount = countPokemonNodes(firstRoot);
+    int secondCount = countPokemonNodes(secondRoot);
+    STAT_NODES(firstCount + secondCount);
+    NodeArray first, second, merged;
+    initNodeArray(&first, firstCount);
+    initNodeArray(&second, secondCount);
+    initNodeArray(&merged, firstCount + secondCount);
+
+    // Without the arrays, fall back to relinking the nodes one by one
+    if (first.nodes == NULL || second.nodes == NULL || merged.nodes == NULL) {
+        free(first.nodes);
+        free(second.nodes);
+        free(merged.nodes);
+        PokemonNode *root = insertTreeNodes(firstRoot, secondRoot);
+        STAT_END(STAT_MERGE, span);
+        return root;
+    }
+
+    // Flatten both trees into sorted arrays
+    collectInOrder(firstRoot, &first);
+    collectInOrder(secondRoot, &second);
+
+    // Classic sorted merge; on equal IDs the first tree's node wins
+    int i = 0, j = 0;
+    while (i < first.size && j < second.size) {
+        uint32_t firstId = first.nodes[i]->species;
+        uint32_t secondId = second.nodes[j]->species;
+        if (firstId < secondId) {
+            merged.nodes[merged.size++] = first.nodes[i++];
+        } else if (secondId < firstId) {
+            merged.nodes[merged.size++] = second.nodes[j++];
+        } else {
+            merged.nodes[merged.size++] = first.nodes[i++];
+            freePokemonNode(second.nodes[j++]);
+        }
+    }
+    while (i < first.size)
+        merged.nodes[merged.size++] = first.nodes[i++];
+    while (j < second.size)
+        merged.nodes[merged.size++] = second.nodes[j++];
+
+    // Relink the sorted nodes into a perfectly balanced tree
+    PokemonNode *root = buildBalancedTree(merged.nodes, merged.size);
+    free(first.nodes);
+    free(second.nodes);
+    free(merged.nodes);
+    STAT_END(STAT_MERGE, span);
+    return root;
+}
+
+void mergePokedexMenu() {
+    // Check if there are not enough owners to merge
+    if (ownerHead== NULL || ownerHead->next == ownerHead) {
+        printf("Not enough owners to merge.\n");
+        return;
+    }
+
+    printf("\n=== Merge Pokedexes ===\n");
 
     // Get the first owner's name and find their Pokedex
     printf("Enter name of first owner: ");
@@ -808,52 +2517,220 @@ void mergePokedexMenu() {
         return;
     }
 
-    // Merge the Pokedexes and remove the second owner
-    printf("Merging %s and %s...\n", firstOwnerRoot->ownerName, secondOwnerRoot->ownerName);
-    firstOwnerRoot->pokedexRoot = mergeBST(firstOwnerRoot->pokedexRoot, secondOwnerRoot->pokedexRoot);
+    mergeOwners(firstOwnerRoot, secondOwnerRoot, secondOwnerName);
     free(firstOwnerName);
     free(secondOwnerName);
-    freeOwnerNode(secondOwnerRoot);
+}
+
+void mergeOwners(OwnerNode *first, OwnerNode *second, const char *secondName) {
+    // Merging an owner into itself would free the Pokedex it keeps
+    if (first == second) {
+        printf("Cannot merge a Pokedex with itself.\n");
+        return;
+    }
+
+    // Both Pokedexes change: lock them in address order, so two merges can't deadlock
+    lockOwnerPair(first, second);
+    if (first->retired || second->retired) {
+        printf("Owner '%s' not found.\n", first->retired ? first->ownerName : secondName);
+        unlockOwnerPair(first, second);
+        return;
+    }
+
+    // Merge the Pokedexes and retire the second owner, so only we remove it
+    printf("Merging %s and %s...\n", first->ownerName, second->ownerName);
+    mergeOwnerPokedex(first, second);
+    journalRecord(JOURNAL_MERGE, first->ownerName, second->ownerName, 0);
+    __atomic_store_n(&second->retired, true, __ATOMIC_RELEASE);
+    unlockOwnerPair(first, second);
+
+    // Unlink the second owner from the ring before freeing it
+    removeOwnerFromCircularList(second);
     printf("Merge completed.\n");
-    printf("Owner '%s' has been removed after merging.\n", secondOwnerName);
+    printf("Owner '%s' has been removed after merging.\n", secondName);
 }
 
 int getOwnerAmount(bool isPrintOwners) {
+    // The registry keeps the count, printing still goes through every owner
+    int count = ownerCount();
+    if (isPrintOwners) {
+        for (int i = 0; i < count; i++) {
+            printNumberedName("", i + 1, ". ", ownerAtPosition(i)->ownerName);
+        }
+        flushOutputSink();
+    }
+    return count;
+}
+
+// Slide the gap so it starts at 'position' (moves only the owners in between)
+static void moveRegistryGap(int position) {
+    OwnerRegistry *reg = &ownerRegistry;
+    int gapSize = reg->gapEnd - reg->gapStart;
+    if (position < reg->gapStart) {
+        int moved = reg->gapStart - position;
+        memmove(reg->slots + reg->gapEnd - moved, reg->slots + position, moved * sizeof(OwnerNode *));
+    } else if (position > reg->gapStart) {
+        int moved = position - reg->gapStart;
+        memmove(reg->slots + reg->gapStart, reg->slots + reg->gapEnd, moved * sizeof(OwnerNode *));
+    }
+    reg->gapStart = position;
+    reg->gapEnd = position + gapSize;
+}
+
+bool ownerRegistryReady(void) {
+    if (!ownerRegistry.outOfSync) return true;
+
+    // Count the ring and copy it into a fresh buffer, gap at the end
     int count = 0;
+    if (ownerHead != NULL) {
+        OwnerNode *current = ownerHead;
+        do {
+            count++;
+            current = current->next;
+        } while (current != ownerHead);
+    }
+    int capacity = 64;
+    while (capacity < count * 2)
+        capacity *= 2;
+    OwnerNode **slots = malloc(capacity * sizeof(OwnerNode *));
+    if (slots == NULL) return false;
+
     OwnerNode *current = ownerHead;
+    for (int i = 0; i < count; i++) {
+        slots[i] = current;
+        current = current->next;
+    }
+    free(ownerRegistry.slots);
+    ownerRegistry.slots = slots;
+    ownerRegistry.gapStart = count;
+    ownerRegistry.gapEnd = capacity;
+    ownerRegistry.capacity = capacity;
+    ownerRegistry.outOfSync = false;
+    return true;
+}
 
-    // Traverse the circular list to count owners
-    do {
+int ownerCount(void) {
+    if (ownerRegistryReady())
+        return ownerRegistry.capacity - (ownerRegistry.gapEnd - ownerRegistry.gapStart);
+
+    // No usable registry: count by walking the ring
+    int count = 0;
+    OwnerNode *current = ownerHead;
+    while (current != NULL) {
         count++;
-        if (isPrintOwners) {
-            printf("%d. %s\n", count, current->ownerName);
-        }
         current = current->next;
-    } while (current != ownerHead);
-
+        if (current == ownerHead) break;
+    }
     return count;
 }
 
+OwnerNode *ownerAtPosition(int position) {
+    if (ownerRegistryReady()) {
+        // Positions past the gap are shifted by its size
+        if (position < ownerRegistry.gapStart)
+            return ownerRegistry.slots[position];
+        return ownerRegistry.slots[position + ownerRegistry.gapEnd - ownerRegistry.gapStart];
+    }
+
+    // No usable registry: walk the ring from the head
+    OwnerNode *current = ownerHead;
+    for (int i = 0; i < position; i++)
+        current = current->next;
+    return current;
+}
+
+bool ownerRegistryInsert(int position, OwnerNode *owner) {
+    if (!ownerRegistryReady()) return false;
+    OwnerRegistry *reg = &ownerRegistry;
+
+    // A full buffer doubles; the owners after the gap move to the new end
+    if (reg->gapStart == reg->gapEnd) {
+        int newCapacity = reg->capacity ? reg->capacity * 2 : 64;
+        OwnerNode **slots = malloc(newCapacity * sizeof(OwnerNode *));
+        if (slots == NULL) {
+            printf("Memory allocation failed.\n");
+            reg->outOfSync = true;
+            return false;
+        }
+        int tail = reg->capacity - reg->gapEnd;
+        if (reg->slots != NULL) {
+            memcpy(slots, reg->slots, reg->gapStart * sizeof(OwnerNode *));
+            memcpy(slots + newCapacity - tail, reg->slots + reg->gapEnd, tail * sizeof(OwnerNode *));
+        }
+        free(reg->slots);
+        reg->slots = slots;
+        reg->gapEnd = newCapacity - tail;
+        reg->capacity = newCapacity;
+    }
+
+    moveRegistryGap(position);
+    reg->slots[reg->gapStart++] = owner;
+    return true;
+}
+
+OwnerNode *ownerRegistryRemoveAt(int position) {
+    // The removed owner is the first one after the gap; the gap swallows its slot
+    moveRegistryGap(position);
+    return ownerRegistry.slots[ownerRegistry.gapEnd++];
+}
+
+int ownerRegistryPositionOf(const OwnerNode *owner) {
+    for (int i = 0; i < ownerRegistry.gapStart; i++) {
+        if (ownerRegistry.slots[i] == owner) return i;
+    }
+    for (int i = ownerRegistry.gapEnd; i < ownerRegistry.capacity; i++) {
+        if (ownerRegistry.slots[i] == owner) return i - (ownerRegistry.gapEnd - ownerRegistry.gapStart);
+    }
+    return -1;
+}
+
+void freeOwnerRegistry(void) {
+    free(ownerRegistry.slots);
+    ownerRegistry.slots = NULL;
+    ownerRegistry.gapStart = ownerRegistry.gapEnd = ownerRegistry.capacity = 0;
+    ownerRegistry.outOfSync = false;
+}
+
 void sortOwners() {
-    int amount = getOwnerAmount(false);
+    STAT_BEGIN(STAT_SORT_OWNERS, span);
+
+    // The sort and its journal record happen under one write lock, in ring order
+    writeLockOwners();
+    int amount = ownerCount();
+    bool sorted = amount >= 2 && sortOwnerRingLocked();
+    if (sorted)
+        journalRecord(JOURNAL_SORT, NULL, NULL, 0);
+    unlockOwners();
+    STAT_NODES(amount);
+    STAT_END(STAT_SORT_OWNERS, span);
+
     if (amount < 2) {
         printf("0 or 1 owners only => no need to sort.\n");
         return;
     }
-
-    // Create an array to hold the owner nodes
-    OwnerNode **ownerArray = malloc(amount * sizeof(OwnerNode *));
-    if (ownerArray == NULL) {
+    if (!sorted) {
         printf("Memory allocation failed.\n");
         return;
     }
 
-    // Populate the array with owner nodes
-    OwnerNode *current = ownerHead;
-    for (int i = 0; i < amount; i++) {
-        ownerArray[i] = current;
-        current = current->next;
-    }
+    printf("Owners sorted by name.\n");
+}
+
+bool sortOwnerRing(void) {
+    writeLockOwners();
+    bool sorted = sortOwnerRingLocked();
+    unlockOwners();
+    return sorted;
+}
+
+bool sortOwnerRingLocked(void) {
+    int amount = ownerCount();
+    if (amount < 2) return true;
+    if (!ownerRegistryReady()) return false;
+
+    // With the gap moved to the end, the registry is the array of owners in ring order
+    moveRegistryGap(amount);
+    OwnerNode **ownerArray = ownerRegistry.slots;
 
     // Sort the array using qsort
     qsort(ownerArray, amount, sizeof(OwnerNode *), compareOwnerNames);
@@ -864,10 +2741,8 @@ void sortOwners() {
         ownerArray[i]->prev = ownerArray[(i - 1 + amount) % amount];
     }
     ownerHead = ownerArray[0];
-
-    // Free the temporary array
-    free(ownerArray);
-    printf("Owners sorted by name.\n");
+    // The registry was sorted in place; the name index maps names to nodes, not positions
+    return true;
 }
 
 void printOwnersCircular() {
@@ -883,12 +2758,28 @@ void printOwnersCircular() {
         return;
     }
 
+    printOwnersInDirection(directionChr, readIntSafe("How many prints? "));
+}
+
+void printOwnersInDirection(char directionChr, int count) {
+    // Nothing to walk without owners
+    if (ownerHead == NULL) return;
+
     // Traverse and print owners in the specified direction
     OwnerNode *temp = ownerHead;
-    for (int i = 0, count = readIntSafe("How many prints? "); i < count; i++) {
-        printf("[%d] %s\n", i + 1, temp->ownerName);
+    for (int i = 0; i < count; i++) {
+        printNumberedName("[", i + 1, "] ", temp->ownerName);
         temp = (directionChr == 'F' || directionChr == 'f') ? temp->next : temp->prev;
     }
+    flushOutputSink();
+}
+
+// The counter of a main menu choice (STAT_OP_COUNT: not counted)
+static inline StatOp mainMenuStatOp(int choice) {
+    static const StatOp ops[] = { STAT_MENU_NEW, STAT_MENU_EXISTING, STAT_MENU_DELETE, STAT_MENU_MERGE,
+                                  STAT_MENU_SORT, STAT_MENU_PRINT, STAT_OP_COUNT, STAT_MENU_SAVE, STAT_MENU_LOAD,
+                                  STAT_OP_COUNT, STAT_MENU_QUERY };
+    return choice >= 1 && choice <= 11 ? ops[choice - 1] : STAT_OP_COUNT;
 }
 
 void mainMenu() {
@@ -902,8 +2793,14 @@ void mainMenu() {
         printf("5. Sort Owners by Name\n");
         printf("6. Print Owners in a direction X times\n");
         printf("7. Exit\n");
+        printf("8. Save Owners to File\n");
+        printf("9. Load Owners from File\n");
+        printf("10. Stats\n");
+        printf("11. Query Pokemon across Owners\n");
         choice = readIntSafe("Your choice: ");
 
+        StatOp statOp = mainMenuStatOp(choice);
+        STAT_BEGIN(statOp, span);
         switch (choice) {
             case 1:
                 openPokedexMenu();
@@ -926,9 +2823,24 @@ void mainMenu() {
             case 7:
                 printf("Goodbye!\n");
                 break;
+            case 8:
+                saveOwnersMenu();
+                break;
+            case 9:
+                loadOwnersMenu();
+                break;
+            case 10:
+                printStats(stdout);
+                break;
+            case 11:
+                queryPokemonMenu();
+                break;
             default:
                 printf("Invalid.\n");
         }
+        if (statOp != STAT_OP_COUNT)
+            STAT_END(statOp, span);
+        checkpointJournalIfDue();
     } while (choice != 7);
 }
 
@@ -937,7 +2849,7 @@ PokemonNode *removePokemonById(PokemonNode *root, int id) {
     if (root == NULL) return NULL;
 
     // Search for the Pokemon by ID
-    PokemonNode *targetNode = searchPokemonBFS(root, id);
+    PokemonNode *targetNode = searchPokemonBST(root, id);
     if (targetNode == NULL) {
         // If the Pokemon is not found, print a message and return the original tree
         printf("Pokemon with ID %d not found.\n", id);
@@ -950,24 +2862,39 @@ PokemonNode *removePokemonById(PokemonNode *root, int id) {
 
 void freePokemon(OwnerNode *owner) {
     // Check if the owner or their Pokedex is empty
-    if (owner == NULL || owner->pokedexRoot == NULL) {
+    if (owner == NULL || isPokedexEmpty(owner)) {
         printf("No Pokemon to release.\n");
         return;
     }
 
     // Prompt for the Pokemon ID to release
-    int id = readIntSafe("Enter Pokemon ID to release: ");
+    releasePokemonById(owner, readIntSafe("Enter Pokemon ID to release: "));
+}
+
+static void releasePokemonByIdLocked(OwnerNode *owner, int id) {
+    if (isPokedexEmpty(owner)) {
+        printf("No Pokemon to release.\n");
+        return;
+    }
 
     // Search for the Pokemon by ID
-    PokemonNode *pokemonToRemove = searchPokemonBFS(owner->pokedexRoot, id);
+    const PokemonData *pokemonToRemove = findOwnerPokemon(owner, id);
     if (pokemonToRemove == NULL) {
         printf("No Pokemon with ID %d found.\n", id);
         return;
     }
 
-    // Remove the Pokemon and update the Pokedex
-    printf("Removing Pokemon %s (ID %d).\n", pokemonToRemove->data->name, pokemonToRemove->data->id);
-    owner->pokedexRoot = removePokemonById(owner->pokedexRoot, id);
+    // Remove the Pokemon and update the Pokedex (existence is already confirmed)
+    printf("Removing Pokemon %s (ID %d).\n", pokemonToRemove->name, pokemonToRemove->id);
+    ownerRemovePokemon(owner, id);
+    journalRecord(JOURNAL_RELEASE, owner->ownerName, NULL, id);
+}
+
+void releasePokemonById(OwnerNode *owner, int id) {
+    // Pokedex changes only take their owner's lock; other owners change in parallel
+    if (!lockLiveOwner(owner)) return;
+    releasePokemonByIdLocked(owner, id);
+    unlockOwner(owner);
 }
 
 
@@ -975,52 +2902,2697 @@ void freePokemonNode(PokemonNode *node) {
     // Check if the owner list is empty
     if (node == NULL) return;
 
-    free(node->data);
+    // A pooled node goes back on the free list of the pool owning its slab
+    if (node->pooled) {
+        NodeSlab *slab = (NodeSlab *) ((uintptr_t) node & ~(uintptr_t) (NODE_SLAB_BYTES - 1));
+        node->right = slab->pool->freeList;
+        slab->pool->freeList = node;
+        return;
+    }
+
+    // The species lives in the catalog, only the node itself is ours
     free(node);
 }
 
 void freePokemonTree(PokemonNode *root) {
-    // Check if the tree is empty
-    if (root == NULL) return;
-
-    // Recursively free the left and right subtrees
-    freePokemonTree(root->left);
-    freePokemonTree(root->right);
-
-    // Free the root node's data and the root node itself
-    freePokemonNode(root);
+    // Post-order: both children are gone before their parent. The cursor never
+    // reads a node again after returning it, so freeing it right away is safe.
+    TreeCursor cursor;
+    treeCursorInit(&cursor, root, TRAVERSE_POST);
+    for (PokemonNode *node = treeCursorNext(&cursor); node != NULL; node = treeCursorNext(&cursor))
+        freePokemonNode(node);
+    treeCursorFree(&cursor);
 }
 
 void freeOwnerNode(OwnerNode *owner) {
     // Check if the owner is empty
     if (owner == NULL) return;
 
-    free(owner->ownerName);
-    freePokemonTree(owner->pokedexRoot);
-    free(owner);
+    arenaFree(&ownerArena, owner->ownerName, strlen(owner->ownerName) + 1);
+    freeOwnerPokedex(owner);
+    pthread_mutex_destroy(&owner->lock);
+    arenaFree(&ownerArena, owner, sizeof(OwnerNode));
+}
+
+void freeOwnerPokedex(OwnerNode *owner) {
+    // Nodes replaced by path copying are no longer in the tree
+    reclaimOwnerNodes(owner, true);
+
+    // Pooled trees go away slab by slab; a tree without slabs is all malloc'd nodes
+    if (owner->nodePool.slabs != NULL)
+        releaseNodePool(&owner->nodePool);
+    else
+        freePokemonTree(owner->pokedexRoot);
+    owner->pokedexRoot = NULL;
 }
 
 void freeAllOwners(void) {
+    // No reader is left: owners still waiting for one go too
+    reclaimRetiredBlocks(true);
+
+    // The name index and the registry only point at owners, so they can go first
+    freeOwnerIndex();
+    freeOwnerRegistry();
+
     // Check if the owner list is empty
-    if (ownerHead == NULL ) return;
+    if (ownerHead != NULL) {
+        // Initialize the current pointer to the head of the list
+        OwnerNode *current = ownerHead;
+        do {
+            // Store the next owner node
+            OwnerNode *temp = current->next;
+            // Free the current owner node and its Pokedex
+            freeOwnerNode(current);
+            // Move to the next owner node
+            current = temp;
+        } while (current != ownerHead); // Continue until we loop back to the head
+
+        // Set the head to NULL after freeing all nodes
+        ownerHead = NULL;
+    }
 
-    // Initialize the current pointer to the head of the list
-    OwnerNode *current = ownerHead;
-    do {
-        // Store the next owner node
-        OwnerNode *temp = current->next;
-        // Free the current owner node and its Pokedex
-        freeOwnerNode(current);
-        // Move to the next owner node
-        current = temp;
-    } while (current != ownerHead); // Continue until we loop back to the head
-
-    // Set the head to NULL after freeing all nodes
-    ownerHead = NULL;
+    // Every block is back on a free list now, so the chunks can go
+    releaseArena(&ownerArena);
 }
 
-int main() {
-    mainMenu();
+void fastExitOwners(void) {
+#ifdef EX6_DEBUG_FREE
+    // Debug builds free every piece, so leak checkers see each block
     freeAllOwners();
+#else
+    // Trees built with --no-node-pool are malloc'd node by node and still go one by one
+    if (!nodePoolsEnabled && ownerHead != NULL) {
+        OwnerNode *current = ownerHead;
+        do {
+            freePokemonTree(current->pokedexRoot);
+            current = current->next;
+        } while (current != ownerHead);
+    }
+
+    // Owners, names and slabs all live in the arena: drop its chunks, not each owner
+    reclaimRetiredBlocks(true);
+    freeOwnerIndex();
+    freeOwnerRegistry();
+    releaseArena(&ownerArena);
+    ownerHead = NULL;
+#endif
+}
+
+// --------------------------------------------------------------
+// Owner Arena
+// --------------------------------------------------------------
+static void *arenaAllocLocked(Arena *arena, size_t size) {
+    // Every block of the largest class is aligned like a slab, because its free list hands
+    // blocks freed as long names back out as slabs; everything else is aligned to a granule
+    size_t sizeClass = (size + ARENA_GRANULE - 1) / ARENA_GRANULE;
+    size_t align = (sizeClass == ARENA_SIZE_CLASSES - 1) ? NODE_SLAB_BYTES : ARENA_GRANULE;
+#ifdef EX6_DEBUG_FREE
+    (void) arena;
+    void *block;
+    return posix_memalign(&block, align, size) == 0 ? block : NULL;
+#else
+
+    // Oversized requests (very long names) skip the arena
+    if (sizeClass >= ARENA_SIZE_CLASSES)
+        return malloc(size);
+
+    // Reuse a freed block of the same size class first
+    if (arena->freeLists[sizeClass] != NULL) {
+        void *block = arena->freeLists[sizeClass];
+        arena->freeLists[sizeClass] = *(void **) block;
+        return block;
+    }
+
+    // Bump-allocate, starting a new chunk when this one can't fit the block
+    uintptr_t start = ((uintptr_t) arena->bump + align - 1) & ~(uintptr_t) (align - 1);
+    if (arena->bump == NULL || start + sizeClass * ARENA_GRANULE > (uintptr_t) arena->limit) {
+        void *memory;
+        if (posix_memalign(&memory, NODE_SLAB_BYTES, ARENA_CHUNK_BYTES) != 0)
+            return NULL;
+        ArenaChunk *chunk = memory;
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+        arena->bump = (char *) (chunk + 1);
+        arena->limit = (char *) chunk + ARENA_CHUNK_BYTES;
+        start = ((uintptr_t) arena->bump + align - 1) & ~(uintptr_t) (align - 1);
+    }
+    arena->bump = (char *) (start + sizeClass * ARENA_GRANULE);
+    return (void *) start;
+#endif
+}
+
+void *arenaAlloc(Arena *arena, size_t size) {
+    // Owners change in parallel, and each one takes its slabs from the shared arena
+    pthread_mutex_lock(&arena->lock);
+    void *block = arenaAllocLocked(arena, size);
+    pthread_mutex_unlock(&arena->lock);
+    return block;
+}
+
+void arenaFree(Arena *arena, void *block, size_t size) {
+    if (block == NULL) return;
+#ifdef EX6_DEBUG_FREE
+    (void) arena;
+    (void) size;
+    free(block);
+#else
+    size_t sizeClass = (size + ARENA_GRANULE - 1) / ARENA_GRANULE;
+    if (sizeClass >= ARENA_SIZE_CLASSES) {
+        free(block);
+        return;
+    }
+
+    // Push the block on its size class's free list
+    pthread_mutex_lock(&arena->lock);
+    *(void **) block = arena->freeLists[sizeClass];
+    arena->freeLists[sizeClass] = block;
+    pthread_mutex_unlock(&arena->lock);
+#endif
+}
+
+void releaseArena(Arena *arena) {
+    ArenaChunk *chunk = arena->chunks;
+    while (chunk != NULL) {
+        ArenaChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena->chunks = NULL;
+    arena->bump = arena->limit = NULL;
+    memset(arena->freeLists, 0, sizeof(arena->freeLists));
+}
+
+// --------------------------------------------------------------
+// Bitset Pokedex
+// --------------------------------------------------------------
+bool pokedexBitsContains(const PokedexBits *bits, int id) {
+    // IDs outside the set's range are never present
+    if (id < 0 || id >= POKEDEX_BIT_WORDS * 64) return false;
+    return (__atomic_load_n(&bits->words[id / 64], __ATOMIC_RELAXED) >> (id % 64)) & 1;
+}
+
+bool pokedexBitsAdd(PokedexBits *bits, int id) {
+    if (id < 0 || id >= POKEDEX_BIT_WORDS * 64 || pokedexBitsContains(bits, id)) return false;
+    // Word-sized atomic stores: an epoch reader sees each word before or after, never torn
+    uint64_t *word = &bits->words[id / 64];
+    __atomic_store_n(word, *word | (uint64_t) 1 << (id % 64), __ATOMIC_RELAXED);
+    return true;
+}
+
+bool pokedexBitsRemove(PokedexBits *bits, int id) {
+    if (!pokedexBitsContains(bits, id)) return false;
+    uint64_t *word = &bits->words[id / 64];
+    __atomic_store_n(word, *word & ~((uint64_t) 1 << (id % 64)), __ATOMIC_RELAXED);
+    return true;
+}
+
+void pokedexBitsMerge(PokedexBits *dest, const PokedexBits *src) {
+    for (int i = 0; i < POKEDEX_BIT_WORDS; i++)
+        __atomic_store_n(&dest->words[i], dest->words[i] | src->words[i], __ATOMIC_RELAXED);
+}
+
+int pokedexBitsCount(const PokedexBits *bits) {
+    int count = 0;
+    for (int i = 0; i < POKEDEX_BIT_WORDS; i++)
+        count += __builtin_popcountll(__atomic_load_n(&bits->words[i], __ATOMIC_RELAXED));
+    return count;
+}
+
+int pokedexBitsNext(const PokedexBits *bits, int from) {
+    if (from < 0) from = 0;
+
+    for (int word = from / 64; word < POKEDEX_BIT_WORDS; word++) {
+        uint64_t remaining = __atomic_load_n(&bits->words[word], __ATOMIC_RELAXED);
+        // In the first word, drop the bits below 'from'
+        if (word == from / 64)
+            remaining &= ~(uint64_t) 0 << (from % 64);
+        if (remaining)
+            return word * 64 + __builtin_ctzll(remaining);
+    }
+    return -1;
+}
+
+void inOrderBitsGeneric(const PokedexBits *bits, VisitNodeFunc visit) {
+    // The visitor gets a node on our stack, valid only during the call
+    PokemonNode node = { .height = 1 };
+    for (int id = pokedexBitsNext(bits, 0); id != -1; id = pokedexBitsNext(bits, id + 1)) {
+        node.species = (uint32_t) findSpeciesPosition(id);
+        visit(&node);
+    }
+}
+
+void displayAlphabeticalBits(const PokedexBits *bits) {
+    initSpeciesNameRanks();
+    const SpeciesCatalog *catalog = &speciesCatalog;
+    if (catalog->byNameRank == NULL) return;
+
+    // Walk the species in name order and print the owned ones; the visitor's node is on our stack
+    PokemonNode node = { .height = 1 };
+    for (int rank = 0; rank < catalog->count; rank++) {
+        uint32_t species = catalog->byNameRank[rank];
+        if (pokedexBitsContains(bits, catalog->ids[species])) {
+            node.species = species;
+            printPokemonNode(&node);
+        }
+    }
+    flushOutputSink();
+}
+
+PokemonNode *buildBalancedTree(PokemonNode **nodes, int count) {
+    // Base case: no nodes, empty subtree
+    if (count <= 0) return NULL;
+
+    // The middle node is the root, each half becomes a subtree
+    int mid = count / 2;
+    PokemonNode *root = nodes[mid];
+    root->left = buildBalancedTree(nodes, mid);
+    root->right = buildBalancedTree(nodes + mid + 1, count - mid - 1);
+    updateNodeSummary(root);
+    return root;
+}
+
+PokemonNode *pokedexBitsToTree(const PokedexBits *bits) {
+    // Count and walk one copy: epoch readers build this while a writer may flip bits
+    PokedexBits snapshot;
+    for (int i = 0; i < POKEDEX_BIT_WORDS; i++)
+        snapshot.words[i] = __atomic_load_n(&bits->words[i], __ATOMIC_RELAXED);
+    int count = pokedexBitsCount(&snapshot);
+    if (count == 0) return NULL;
+
+    PokemonNode **nodes = malloc(count * sizeof(PokemonNode *));
+    if (nodes == NULL) {
+        printf("Memory allocation failed.\n");
+        return NULL;
+    }
+
+    // Set bits come out in ascending ID order, ready for a balanced build
+    int size = 0;
+    for (int id = pokedexBitsNext(&snapshot, 0); id != -1; id = pokedexBitsNext(&snapshot, id + 1)) {
+        PokemonNode *node = createPokemonNode(findSpecies(id));
+        if (node == NULL) break;
+        nodes[size++] = node;
+    }
+
+    PokemonNode *root = buildBalancedTree(nodes, size);
+    free(nodes);
+    return root;
+}
+
+// --------------------------------------------------------------
+// Owner Pokedex (tree or bitset)
+// --------------------------------------------------------------
+bool isPokedexEmpty(const OwnerNode *owner) {
+    if (bitsetPokedexMode)
+        return pokedexBitsNext(&owner->pokedexBits, 0) == -1;
+    return __atomic_load_n(&owner->pokedexRoot, __ATOMIC_ACQUIRE) == NULL;
+}
+
+const PokemonData *findOwnerPokemon(OwnerNode *owner, int id) {
+    if (bitsetPokedexMode)
+        return pokedexBitsContains(&owner->pokedexBits, id) ? findSpecies(id) : NULL;
+
+    PokemonNode *node = searchPokemonBST(__atomic_load_n(&owner->pokedexRoot, __ATOMIC_ACQUIRE), id);
+    return node ? nodeData(node) : NULL;
+}
+
+// Epoch readers can only reach owners linked into the ring; others change in place
+static bool copyOnWrite(const OwnerNode *owner) {
+    return epochReadsMode && owner->next != NULL;
+}
+
+bool ownerAddPokemon(OwnerNode *owner, const PokemonData *data, bool *inserted) {
+    if (bitsetPokedexMode) {
+        *inserted = pokedexBitsAdd(&owner->pokedexBits, data->id);
+        return true;
+    }
+    if (copyOnWrite(owner))
+        return cowAddPokemon(owner, data, inserted);
+
+    PokemonNode *node;
+    owner->pokedexRoot = lookupOrInsertPokemon(owner->pokedexRoot, data, &owner->nodePool, &node, inserted);
+    return node != NULL;
+}
+
+void ownerRemovePokemon(OwnerNode *owner, int id) {
+    if (bitsetPokedexMode)
+        pokedexBitsRemove(&owner->pokedexBits, id);
+    else if (copyOnWrite(owner))
+        cowRemovePokemon(owner, id);
+    else
+        owner->pokedexRoot = removeNodeBST(owner->pokedexRoot, id);
+}
+
+void mergeOwnerPokedex(OwnerNode *dest, OwnerNode *src) {
+    // Readers may still be walking src: it keeps its tree and slabs until it is freed
+    if (epochReadsMode && !bitsetPokedexMode) {
+        cowMergePokedex(dest, src);
+        return;
+    }
+
+    if (bitsetPokedexMode)
+        pokedexBitsMerge(&dest->pokedexBits, &src->pokedexBits);
+    else
+        dest->pokedexRoot = mergeBSTBalanced(dest->pokedexRoot, src->pokedexRoot);
+
+    // The merged Pokedex now owns (or has freed) all of src's nodes, slabs included
+    src->pokedexRoot = NULL;
+    adoptNodePool(&dest->nodePool, &src->nodePool);
+}
+
+// --------------------------------------------------------------
+// Snapshots (save / load every owner)
+// --------------------------------------------------------------
+
+// Write the owner's species IDs in ascending order into ids; returns how many
+static int collectOwnerIds(OwnerNode *owner, uint32_t *ids) {
+    int count = 0;
+    if (bitsetPokedexMode) {
+        for (int id = pokedexBitsNext(&owner->pokedexBits, 0); id != -1; id = pokedexBitsNext(&owner->pokedexBits, id + 1))
+            ids[count++] = (uint32_t) id;
+        return count;
+    }
+
+    // In-order walk with an explicit stack (AVL height stays small, 64 is plenty)
+    PokemonNode *stack[64];
+    int depth = 0;
+    PokemonNode *node = owner->pokedexRoot;
+    while (node != NULL || depth > 0) {
+        while (node != NULL) {
+            stack[depth++] = node;
+            node = node->left;
+        }
+        node = stack[--depth];
+        ids[count++] = (uint32_t) nodeId(node);
+        node = node->right;
+    }
+    return count;
+}
+
+int writeSnapshot(const char *path) {
+    // The owner table is filled first, so the header knows every size up front
+    int count = ownerCount();
+    SnapshotOwner *table = malloc((count > 0 ? count : 1) * sizeof(SnapshotOwner));
+    // A Pokedex holds each species at most once, so this fits any owner's IDs
+    uint32_t *ids = malloc((size_t) speciesCatalog.count * sizeof(uint32_t));
+    if (table == NULL || ids == NULL) {
+        printf("Memory allocation failed.\n");
+        free(table);
+        free(ids);
+        return -1;
+    }
+    SnapshotHeader header;
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.ownerCount = (uint32_t) count;
+    header.idCount = 0;
+    header.nameBytes = 0;
+    header.journalSequence = journal.sequence;
+    OwnerNode *owner = ownerHead;
+    for (int i = 0; i < count; i++, owner = owner->next) {
+        size_t nameLength = strlen(owner->ownerName);
+        table[i].nameOffset = (uint32_t) header.nameBytes;
+        table[i].nameLength = (uint32_t) nameLength;
+        table[i].idOffset = (uint32_t) header.idCount;
+        table[i].idCount = (uint32_t) collectOwnerIds(owner, ids);
+        header.nameBytes += nameLength + 1;
+        header.idCount += table[i].idCount;
+    }
+    if (header.nameBytes > UINT32_MAX || header.idCount > UINT32_MAX) {
+        printf("Too many owners to save.\n");
+        free(table);
+        free(ids);
+        return -1;
+    }
+
+    // Write next to the target and rename at the end, so a failed save keeps the old file
+    size_t pathLength = strlen(path);
+    char *tempPath = malloc(pathLength + 5);
+    FILE *file = tempPath ? fopen(strcat(strcpy(tempPath, path), ".tmp"), "wb") : NULL;
+    if (file == NULL) {
+        printf("Cannot write %s.\n", path);
+        free(tempPath);
+        free(table);
+        free(ids);
+        return -1;
+    }
+    setvbuf(file, NULL, _IOFBF, 1 << 20);
+
+    // Header, owner table, every ID array in owner order, then the name pool
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (count > 0)
+        ok = ok && fwrite(table, sizeof(SnapshotOwner), count, file) == (size_t) count;
+    owner = ownerHead;
+    for (int i = 0; ok && i < count; i++, owner = owner->next) {
+        int idCount = collectOwnerIds(owner, ids);
+        ok = fwrite(ids, sizeof(uint32_t), idCount, file) == (size_t) idCount;
+    }
+    owner = ownerHead;
+    for (int i = 0; ok && i < count; i++, owner = owner->next)
+        ok = fwrite(owner->ownerName, 1, table[i].nameLength + 1, file) == table[i].nameLength + 1;
+    // On disk before the rename, so the new name never points at a partial file
+    ok = ok && fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok = (fclose(file) == 0) && ok;
+    ok = ok && rename(tempPath, path) == 0;
+    if (!ok) {
+        printf("Cannot write %s.\n", path);
+        remove(tempPath);
+    }
+    free(tempPath);
+    free(table);
+    free(ids);
+    return ok ? count : -1;
+}
+
+int saveOwners(const char *path) {
+    // Nothing changes while the owners are written, so the file is one consistent state
+    writeLockOwners();
+    int count = writeSnapshot(path);
+    unlockOwners();
+    if (count >= 0)
+        printf("Saved %d owners to %s.\n", count, path);
+    return count;
+}
+
+// Check every offset, name and ID of a mapped snapshot before anything is loaded
+static bool validSnapshot(const unsigned char *base, size_t size) {
+    if (size < sizeof(SnapshotHeader)) return false;
+    const SnapshotHeader *header = (const SnapshotHeader *) base;
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 || header->version != SNAPSHOT_VERSION)
+        return false;
+    uint64_t expected = sizeof(SnapshotHeader) + (uint64_t) header->ownerCount * sizeof(SnapshotOwner) +
+                        header->idCount * sizeof(uint32_t) + header->nameBytes;
+    if (header->idCount > UINT32_MAX || header->nameBytes > UINT32_MAX || expected != size)
+        return false;
+
+    const SnapshotOwner *table = (const SnapshotOwner *) (header + 1);
+    const uint32_t *ids = (const uint32_t *) (table + header->ownerCount);
+    const char *names = (const char *) (ids + header->idCount);
+    for (uint32_t i = 0; i < header->ownerCount; i++) {
+        const SnapshotOwner *entry = &table[i];
+        // Names: in the pool, non-empty, '\0'-terminated with no '\0' inside
+        if ((uint64_t) entry->nameOffset + entry->nameLength + 1 > header->nameBytes || entry->nameLength == 0)
+            return false;
+        const char *name = names + entry->nameOffset;
+        if (name[entry->nameLength] != '\0' || memchr(name, '\0', entry->nameLength) != NULL)
+            return false;
+        // IDs: in the array, strictly ascending, species of the current catalog
+        if ((uint64_t) entry->idOffset + entry->idCount > header->idCount ||
+            entry->idCount > (uint32_t) speciesCatalog.count)
+            return false;
+        for (uint32_t j = 0; j < entry->idCount; j++) {
+            uint32_t id = ids[entry->idOffset + j];
+            if (id > INT_MAX || findSpecies((int) id) == NULL || (j > 0 && id <= ids[entry->idOffset + j - 1]))
+                return false;
+        }
+    }
+    return true;
+}
+
+// Give an owner the sorted IDs: set bits, or pooled nodes linked into a balanced tree
+static bool fillOwnerPokedex(OwnerNode *owner, const uint32_t *ids, uint32_t count) {
+    if (bitsetPokedexMode) {
+        for (uint32_t j = 0; j < count; j++)
+            pokedexBitsAdd(&owner->pokedexBits, (int) ids[j]);
+        return true;
+    }
+    PokemonNode **nodes = malloc((count > 0 ? count : 1) * sizeof(PokemonNode *));
+    if (nodes == NULL) {
+        printf("Memory allocation failed.\n");
+        return false;
+    }
+    uint32_t filled = 0;
+    while (filled < count) {
+        PokemonNode *node = allocPokemonNode(&owner->nodePool, findSpecies((int) ids[filled]));
+        if (node == NULL) break;
+        nodes[filled++] = node;
+    }
+    owner->pokedexRoot = buildBalancedTree(nodes, (int) filled);
+    free(nodes);
+    return filled == count;
+}
+
+// freeAllOwners, except that epoch readers may still be using the owners
+static void dropAllOwners(void) {
+    if (!epochReadsMode) {
+        freeAllOwners();
+        return;
+    }
+    while (ownerHead != NULL) {
+        retireOwner(ownerHead);
+        removeOwnerLocked(ownerHead);
+    }
+}
+
+int readSnapshot(const char *path, uint64_t *journalSequence) {
+    // Map the whole file read-only; nothing is parsed, only checked
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        printf("Cannot open %s.\n", path);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    size_t size = (size_t) info.st_size;
+    void *mapping = size > 0 ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (mapping == MAP_FAILED || !validSnapshot(mapping, size)) {
+        printf("Invalid snapshot file.\n");
+        if (mapping != MAP_FAILED) munmap(mapping, size);
+        return -1;
+    }
+
+    // The snapshot replaces every current owner
+    dropAllOwners();
+    const SnapshotHeader *header = mapping;
+    const SnapshotOwner *table = (const SnapshotOwner *) (header + 1);
+    const uint32_t *ids = (const uint32_t *) (table + header->ownerCount);
+    const char *names = (const char *) (ids + header->idCount);
+    *journalSequence = header->journalSequence;
+    int loaded = 0;
+    for (uint32_t i = 0; i < header->ownerCount; i++) {
+        const char *name = names + table[i].nameOffset;
+        if (findOwnerByName(name) != NULL) {
+            printf("Owner '%s' appears twice; keeping the first.\n", name);
+            continue;
+        }
+        OwnerNode *owner = createOwnerWithName(name, table[i].nameLength);
+        if (owner == NULL) break;
+        bool filled = fillOwnerPokedex(owner, ids + table[i].idOffset, table[i].idCount);
+        linkOwnerLocked(owner);
+        loaded++;
+        if (!filled) break;
+    }
+    munmap(mapping, size);
+    return loaded;
+}
+
+int loadOwners(const char *path) {
+    uint64_t journalSequence;
+    writeLockOwners();
+    int loaded = readSnapshot(path, &journalSequence);
+    unlockOwners();
+    if (loaded < 0) return -1;
+    printf("Loaded %d owners from %s.\n", loaded, path);
+
+    // The journal can't describe a wholesale replacement: start it over from this state
+    if (journal.fd >= 0)
+        checkpointJournal();
+    return loaded;
+}
+
+void saveOwnersMenu() {
+    printf("Enter file name: ");
+    char *path = getDynamicInput();
+    if (path == NULL) return;
+    saveOwners(path);
+    free(path);
+}
+
+void loadOwnersMenu() {
+    printf("Enter file name: ");
+    char *path = getDynamicInput();
+    if (path == NULL) return;
+    loadOwners(path);
+    free(path);
+}
+
+// --------------------------------------------------------------
+// Owner Locks
+// --------------------------------------------------------------
+void readLockOwners(void) {
+    pthread_rwlock_rdlock(&ownerRingLock);
+}
+
+void writeLockOwners(void) {
+    pthread_rwlock_wrlock(&ownerRingLock);
+}
+
+void unlockOwners(void) {
+    pthread_rwlock_unlock(&ownerRingLock);
+}
+
+void lockOwner(OwnerNode *owner) {
+    pthread_mutex_lock(&owner->lock);
+}
+
+void unlockOwner(OwnerNode *owner) {
+    pthread_mutex_unlock(&owner->lock);
+}
+
+bool lockLiveOwner(OwnerNode *owner) {
+    lockOwner(owner);
+    if (!owner->retired) return true;
+
+    // Being deleted or merged away by another thread
+    unlockOwner(owner);
+    printf("Owner '%s' not found.\n", owner->ownerName);
+    return false;
+}
+
+void lockOwnerPair(OwnerNode *first, OwnerNode *second) {
+    // Every thread locks the lower address first, so no two threads wait on each other
+    if (first == second) {
+        lockOwner(first);
+        return;
+    }
+    OwnerNode *lower = (uintptr_t) first < (uintptr_t) second ? first : second;
+    lockOwner(lower);
+    lockOwner(lower == first ? second : first);
+}
+
+void unlockOwnerPair(OwnerNode *first, OwnerNode *second) {
+    unlockOwner(first);
+    if (second != first)
+        unlockOwner(second);
+}
+
+bool retireOwner(OwnerNode *owner) {
+    lockOwner(owner);
+    bool claimed = !owner->retired;
+    __atomic_store_n(&owner->retired, true, __ATOMIC_RELEASE);
+    unlockOwner(owner);
+    return claimed;
+}
+
+// --------------------------------------------------------------
+// Epoch Reads (lock-free readers, --epoch-reads)
+// --------------------------------------------------------------
+static pthread_key_t epochSlotKey;
+static pthread_once_t epochSlotOnce = PTHREAD_ONCE_INIT;
+static __thread int epochSlotIndex = -1;
+static __thread int epochDepth = 0;
+
+// Thread exit hands the slot back
+static void releaseEpochSlot(void *slot) {
+    __atomic_store_n(&((EpochSlot *) slot)->claimed, false, __ATOMIC_RELEASE);
+}
+
+static void createEpochSlotKey(void) {
+    pthread_key_create(&epochSlotKey, releaseEpochSlot);
+}
+
+static void claimEpochSlot(void) {
+    pthread_once(&epochSlotOnce, createEpochSlotKey);
+    for (;;) {
+        for (int i = 0; i < EPOCH_MAX_THREADS; i++) {
+            bool expected = false;
+            if (!__atomic_compare_exchange_n(&epochTable.slots[i].claimed, &expected, true, false,
+                                             __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+                continue;
+
+            // Raise the high-water mark so epochAdvance looks at this slot
+            int used = __atomic_load_n(&epochTable.slotsUsed, __ATOMIC_RELAXED);
+            while (used < i + 1 &&
+                   !__atomic_compare_exchange_n(&epochTable.slotsUsed, &used, i + 1, false,
+                                                __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            }
+            epochSlotIndex = i;
+            pthread_setspecific(epochSlotKey, &epochTable.slots[i]);
+            return;
+        }
+        // Every slot is taken: wait for a reader thread to exit
+        sched_yield();
+    }
+}
+
+void epochEnter(void) {
+    if (epochDepth++ > 0) return;
+    if (epochSlotIndex < 0) claimEpochSlot();
+
+    EpochSlot *slot = &epochTable.slots[epochSlotIndex];
+    __atomic_store_n(&slot->epoch, __atomic_load_n(&epochTable.global, __ATOMIC_ACQUIRE), __ATOMIC_RELAXED);
+    // The announcement must be visible before this thread reads any shared pointer
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+void epochExit(void) {
+    if (--epochDepth > 0) return;
+    __atomic_store_n(&epochTable.slots[epochSlotIndex].epoch, 0, __ATOMIC_RELEASE);
+}
+
+uint64_t epochAdvance(void) {
+    uint64_t global = __atomic_load_n(&epochTable.global, __ATOMIC_ACQUIRE);
+    // Pairs with the fence in epochEnter: a reader we don't see here reads after our retirements
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    int used = __atomic_load_n(&epochTable.slotsUsed, __ATOMIC_ACQUIRE);
+    for (int i = 0; i < used; i++) {
+        uint64_t seen = __atomic_load_n(&epochTable.slots[i].epoch, __ATOMIC_ACQUIRE);
+        if (seen != 0 && seen != global) return global;
+    }
+
+    // Another writer may advance at the same time; either way the epoch moved
+    __atomic_compare_exchange_n(&epochTable.global, &global, global + 1, false,
+                                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    return __atomic_load_n(&epochTable.global, __ATOMIC_ACQUIRE);
+}
+
+void retireBlock(void *block, bool isOwner) {
+    RetiredBlockList *list = &retiredBlocks;
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 16;
+        RetiredBlock *items = realloc(list->items, capacity * sizeof(RetiredBlock));
+        if (items == NULL) {
+            // Better a leak than freeing under a reader
+            printf("Memory allocation failed.\n");
+            return;
+        }
+        list->items = items;
+        list->capacity = capacity;
+    }
+    uint64_t epoch = __atomic_load_n(&epochTable.global, __ATOMIC_ACQUIRE);
+    list->items[list->count++] = (RetiredBlock) { block, epoch, isOwner };
+}
+
+void reclaimRetiredBlocks(bool all) {
+    RetiredBlockList *list = &retiredBlocks;
+    if (list->count == 0) return;
+
+    // Stamps never decrease, so the blocks to free are a prefix
+    uint64_t global = all ? UINT64_MAX : epochAdvance();
+    int freed = 0;
+    while (freed < list->count && (all || list->items[freed].epoch + EPOCH_GRACE <= global)) {
+        RetiredBlock *item = &list->items[freed++];
+        if (item->isOwner)
+            freeOwnerNode(item->block);
+        else
+            free(item->block);
+    }
+    memmove(list->items, list->items + freed, (list->count - freed) * sizeof(RetiredBlock));
+    list->count -= freed;
+
+    if (list->count == 0) {
+        free(list->items);
+        list->items = NULL;
+        list->capacity = 0;
+    }
+}
+
+// Queue a replaced tree node (owner locked)
+static void retirePokemonNode(OwnerNode *owner, PokemonNode *node, uint64_t epoch) {
+    RetiredNodes *list = &owner->retiredNodes;
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : EPOCH_RECLAIM_BATCH;
+        PokemonNode **nodes = realloc(list->nodes, capacity * sizeof(PokemonNode *));
+        if (nodes == NULL) {
+            printf("Memory allocation failed.\n");
+            return;
+        }
+        list->nodes = nodes;
+        uint64_t *epochs = realloc(list->epochs, capacity * sizeof(uint64_t));
+        if (epochs == NULL) {
+            printf("Memory allocation failed.\n");
+            return;
+        }
+        list->epochs = epochs;
+        list->capacity = capacity;
+    }
+    list->nodes[list->count] = node;
+    list->epochs[list->count++] = epoch;
+}
+
+void reclaimOwnerNodes(OwnerNode *owner, bool all) {
+    RetiredNodes *list = &owner->retiredNodes;
+    if (list->capacity == 0) return;
+    uint64_t global = all ? UINT64_MAX : epochAdvance();
+    int freed = 0;
+    while (freed < list->count && (all || list->epochs[freed] + EPOCH_GRACE <= global))
+        freePokemonNode(list->nodes[freed++]);
+    if (freed > 0) {
+        memmove(list->nodes, list->nodes + freed, (list->count - freed) * sizeof(PokemonNode *));
+        memmove(list->epochs, list->epochs + freed, (list->count - freed) * sizeof(uint64_t));
+        list->count -= freed;
+    }
+
+    if (all) {
+        free(list->nodes);
+        free(list->epochs);
+        memset(list, 0, sizeof(*list));
+    }
+}
+
+OwnerNode *findOwnerByNameEpoch(const char *name) {
+    uint32_t hash = hashOwnerName(name);
+    for (;;) {
+        // Seqlock read: an odd version means a writer is mid-change
+        uint64_t version = __atomic_load_n(&ownerIndex.version, __ATOMIC_ACQUIRE);
+        if (version & 1) {
+            sched_yield();
+            continue;
+        }
+
+        // Capacity first: a writer publishes bigger arrays before the capacity that uses them
+        OwnerNode *found = NULL;
+        int capacity = __atomic_load_n(&ownerIndex.capacity, __ATOMIC_ACQUIRE);
+        OwnerNode **slots = __atomic_load_n(&ownerIndex.slots, __ATOMIC_ACQUIRE);
+        uint32_t *hashes = __atomic_load_n(&ownerIndex.hashes, __ATOMIC_ACQUIRE);
+        if (capacity > 0 && slots != NULL && hashes != NULL && __atomic_load_n(&ownerIndex.count, __ATOMIC_RELAXED) > 0) {
+            // A torn read may probe the wrong cluster; the version check below catches it
+            int i = (int) (hash & (uint32_t) (capacity - 1));
+            for (int probes = 0; probes < capacity; probes++, i = (i + 1) & (capacity - 1)) {
+                OwnerNode *owner = __atomic_load_n(&slots[i], __ATOMIC_ACQUIRE);
+                if (owner == NULL) break;
+                if (__atomic_load_n(&hashes[i], __ATOMIC_RELAXED) == hash && strcmp(owner->ownerName, name) == 0) {
+                    found = owner;
+                    break;
+                }
+            }
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&ownerIndex.version, __ATOMIC_RELAXED) != version) continue;
+        if (found != NULL && __atomic_load_n(&found->retired, __ATOMIC_ACQUIRE)) return NULL;
+        return found;
+    }
+}
+
+// Allocate a node for this change; fresh nodes may be changed freely until published
+static PokemonNode *cowNewNode(CowChange *change, const PokemonData *data) {
+    if (change->freshCount == COW_MAX_NODES) {
+        change->failed = true;
+        return NULL;
+    }
+    PokemonNode *node = allocPokemonNode(&change->owner->nodePool, data);
+    if (node == NULL) {
+        change->failed = true;
+        return NULL;
+    }
+    change->fresh[change->freshCount++] = node;
+    return node;
+}
+
+// The published node leaves the tree once this change is published
+static void cowDrop(CowChange *change, PokemonNode *node) {
+    if (change->replacedCount == COW_MAX_NODES) {
+        change->failed = true;
+        return;
+    }
+    change->replaced[change->replacedCount++] = node;
+}
+
+// A node this change may modify: fresh ones as they are, published ones copied
+static PokemonNode *cowWritable(CowChange *change, PokemonNode *node) {
+    for (int i = change->freshCount - 1; i >= 0; i--) {
+        if (change->fresh[i] == node) return node;
+    }
+    PokemonNode *copy = cowNewNode(change, nodeData(node));
+    if (copy == NULL) return node;
+    copy->left = node->left;
+    copy->right = node->right;
+    copy->height = node->height;
+    copyNodeSummary(copy, node);
+    cowDrop(change, node);
+    return copy;
+}
+
+// rebalanceNode for a fresh root: whatever a rotation moves is copied first
+static PokemonNode *cowRebalance(CowChange *change, PokemonNode *root) {
+    updateNodeHeight(root);
+    int balance = nodeHeight(root->left) - nodeHeight(root->right);
+
+    if (balance > 1) {
+        PokemonNode *left = cowWritable(change, root->left);
+        if (change->failed) return root;
+        root->left = left;
+        // Left-right case: rotate the left child first
+        if (nodeHeight(left->left) < nodeHeight(left->right)) {
+            PokemonNode *inner = cowWritable(change, left->right);
+            if (change->failed) return root;
+            left->right = inner;
+            root->left = rotateLeft(left);
+        }
+        return rotateRight(root);
+    }
+    if (balance < -1) {
+        PokemonNode *right = cowWritable(change, root->right);
+        if (change->failed) return root;
+        root->right = right;
+        // Right-left case: rotate the right child first
+        if (nodeHeight(right->right) < nodeHeight(right->left)) {
+            PokemonNode *inner = cowWritable(change, right->left);
+            if (change->failed) return root;
+            right->left = inner;
+            root->right = rotateRight(right);
+        }
+        return rotateLeft(root);
+    }
+    return root;
+}
+
+// Insert data along a copied path (an ID already there stops the change)
+static PokemonNode *cowInsert(CowChange *change, PokemonNode *root, const PokemonData *data) {
+    if (root == NULL) return cowNewNode(change, data);
+    uint32_t species = speciesPosition(data);
+    if (root->species == species) {
+        change->unchanged = true;
+        return root;
+    }
+
+    PokemonNode *copy = cowWritable(change, root);
+    if (change->failed) return root;
+    if (species < copy->species)
+        copy->left = cowInsert(change, copy->left, data);
+    else
+        copy->right = cowInsert(change, copy->right, data);
+    if (change->failed || change->unchanged) return copy;
+    // The copy's subtree gains exactly the new species
+    addSpeciesToSummary(copy, species);
+    return cowRebalance(change, copy);
+}
+
+// Remove a species along a copied path (a missing one stops the change)
+static PokemonNode *cowRemove(CowChange *change, PokemonNode *root, uint32_t species) {
+    if (root == NULL) {
+        change->unchanged = true;
+        return NULL;
+    }
+
+    // At most one child: that child takes the node's place as it is
+    if (root->species == species && (root->left == NULL || root->right == NULL)) {
+        cowDrop(change, root);
+        return root->left != NULL ? root->left : root->right;
+    }
+
+    PokemonNode *copy = cowWritable(change, root);
+    if (change->failed) return root;
+    if (species < copy->species) {
+        copy->left = cowRemove(change, copy->left, species);
+    } else if (species > copy->species) {
+        copy->right = cowRemove(change, copy->right, species);
+    } else {
+        // Two children: the copy takes the in-order successor's species, the successor goes
+        PokemonNode *successor = copy->right;
+        while (successor->left != NULL)
+            successor = successor->left;
+        copy->species = successor->species;
+        copy->right = cowRemove(change, copy->right, successor->species);
+    }
+    if (change->failed || change->unchanged) return copy;
+    updateNodeSummary(copy);
+    return cowRebalance(change, copy);
+}
+
+// Publish the new root, then retire what it replaced
+static void cowPublish(CowChange *change, PokemonNode *root) {
+    OwnerNode *owner = change->owner;
+    __atomic_store_n(&owner->pokedexRoot, root, __ATOMIC_RELEASE);
+
+    uint64_t epoch = __atomic_load_n(&epochTable.global, __ATOMIC_ACQUIRE);
+    for (int i = 0; i < change->replacedCount; i++)
+        retirePokemonNode(owner, change->replaced[i], epoch);
+    if (owner->retiredNodes.count >= EPOCH_RECLAIM_BATCH)
+        reclaimOwnerNodes(owner, false);
+}
+
+// Nobody saw the fresh nodes: give them straight back
+static void cowDiscard(CowChange *change) {
+    for (int i = 0; i < change->freshCount; i++)
+        freePokemonNode(change->fresh[i]);
+}
+
+static void startCowChange(CowChange *change, OwnerNode *owner) {
+    change->owner = owner;
+    change->freshCount = change->replacedCount = 0;
+    change->failed = change->unchanged = false;
+}
+
+bool cowAddPokemon(OwnerNode *owner, const PokemonData *data, bool *inserted) {
+    CowChange change;
+    startCowChange(&change, owner);
+    PokemonNode *root = cowInsert(&change, owner->pokedexRoot, data);
+    *inserted = !change.failed && !change.unchanged;
+    if (!*inserted) {
+        // Already there, or an allocation failed (already reported): the tree stays
+        cowDiscard(&change);
+        return !change.failed;
+    }
+    cowPublish(&change, root);
+    return true;
+}
+
+void cowRemovePokemon(OwnerNode *owner, int id) {
+    int species = findSpeciesPosition(id);
+    if (species < 0) return;
+    CowChange change;
+    startCowChange(&change, owner);
+    PokemonNode *root = cowRemove(&change, owner->pokedexRoot, (uint32_t) species);
+    if (change.failed || change.unchanged) {
+        cowDiscard(&change);
+        return;
+    }
+    cowPublish(&change, root);
+}
+
+void cowMergePokedex(OwnerNode *dest, OwnerNode *src) {
+    int destCount = countPokemonNodes(dest->pokedexRoot);
+    int srcCount = countPokemonNodes(src->pokedexRoot);
+    NodeArray destNodes, srcNodes;
+    initNodeArray(&destNodes, destCount + 1);
+    initNodeArray(&srcNodes, srcCount + 1);
+    PokemonNode **merged = malloc((destCount + srcCount + 1) * sizeof(PokemonNode *));
+    if (destNodes.nodes == NULL || srcNodes.nodes == NULL || merged == NULL) {
+        printf("Memory allocation failed.\n");
+        free(destNodes.nodes);
+        free(srcNodes.nodes);
+        free(merged);
+        return;
+    }
+    collectInOrder(dest->pokedexRoot, &destNodes);
+    collectInOrder(src->pokedexRoot, &srcNodes);
+
+    // Union of the two sorted ID lists, as new nodes in dest's pool
+    int count = 0, i = 0, j = 0;
+    bool failed = false;
+    while (!failed && (i < destNodes.size || j < srcNodes.size)) {
+        const PokemonData *data;
+        if (j == srcNodes.size || (i < destNodes.size && destNodes.nodes[i]->species < srcNodes.nodes[j]->species)) {
+            data = nodeData(destNodes.nodes[i++]);
+        } else if (i == destNodes.size || srcNodes.nodes[j]->species < destNodes.nodes[i]->species) {
+            data = nodeData(srcNodes.nodes[j++]);
+        } else {
+            data = nodeData(destNodes.nodes[i++]);
+            j++;
+        }
+        merged[count] = allocPokemonNode(&dest->nodePool, data);
+        if (merged[count] == NULL)
+            failed = true;
+        else
+            count++;
+    }
+
+    if (failed) {
+        // dest keeps its old tree
+        for (int k = 0; k < count; k++)
+            freePokemonNode(merged[k]);
+    } else {
+        __atomic_store_n(&dest->pokedexRoot, buildBalancedTree(merged, count), __ATOMIC_RELEASE);
+        uint64_t epoch = __atomic_load_n(&epochTable.global, __ATOMIC_ACQUIRE);
+        for (int k = 0; k < destNodes.size; k++)
+            retirePokemonNode(dest, destNodes.nodes[k], epoch);
+        reclaimOwnerNodes(dest, false);
+    }
+    free(destNodes.nodes);
+    free(srcNodes.nodes);
+    free(merged);
+}
+
+// --------------------------------------------------------------
+// Batch Fights (every pair of one Pokedex at once)
+// --------------------------------------------------------------
+void computeFightScores(const int32_t *attack, const int32_t *hp, double *scores, int count) {
+    int i = 0;
+#if defined(__AVX2__)
+    const __m256d attackWeight = _mm256_set1_pd(1.5);
+    const __m256d hpWeight = _mm256_set1_pd(1.2);
+    for (; i + 4 <= count; i += 4) {
+        __m256d attacks = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i *) (attack + i)));
+        __m256d hps = _mm256_cvtepi32_pd(_mm_loadu_si128((const __m128i *) (hp + i)));
+        _mm256_storeu_pd(scores + i, _mm256_add_pd(_mm256_mul_pd(attacks, attackWeight), _mm256_mul_pd(hps, hpWeight)));
+    }
+#elif defined(__SSE2__)
+    const __m128d attackWeight = _mm_set1_pd(1.5);
+    const __m128d hpWeight = _mm_set1_pd(1.2);
+    for (; i + 2 <= count; i += 2) {
+        __m128d attacks = _mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i *) (attack + i)));
+        __m128d hps = _mm_cvtepi32_pd(_mm_loadl_epi64((const __m128i *) (hp + i)));
+        _mm_storeu_pd(scores + i, _mm_add_pd(_mm_mul_pd(attacks, attackWeight), _mm_mul_pd(hps, hpWeight)));
+    }
+#endif
+    // The tail (or everything, without SIMD) uses pokemonFight's own formula
+    for (; i < count; i++)
+        scores[i] = attack[i] * 1.5 + hp[i] * 1.2;
+}
+
+void compareFightScores(const double *scores, int count, int first, signed char *outcomes) {
+    double mine = scores[first];
+    int j = first + 1;
+#if defined(__AVX2__)
+    const __m256d mine4 = _mm256_set1_pd(mine);
+    for (; j + 4 <= count; j += 4) {
+        __m256d theirs = _mm256_loadu_pd(scores + j);
+        int wins = _mm256_movemask_pd(_mm256_cmp_pd(mine4, theirs, _CMP_GT_OQ));
+        int losses = _mm256_movemask_pd(_mm256_cmp_pd(mine4, theirs, _CMP_LT_OQ));
+        for (int k = 0; k < 4; k++)
+            outcomes[j + k] = (signed char) (((wins >> k) & 1) - ((losses >> k) & 1));
+    }
+#elif defined(__SSE2__)
+    const __m128d mine2 = _mm_set1_pd(mine);
+    for (; j + 2 <= count; j += 2) {
+        __m128d theirs = _mm_loadu_pd(scores + j);
+        int wins = _mm_movemask_pd(_mm_cmpgt_pd(mine2, theirs));
+        int losses = _mm_movemask_pd(_mm_cmplt_pd(mine2, theirs));
+        outcomes[j] = (signed char) ((wins & 1) - (losses & 1));
+        outcomes[j + 1] = (signed char) ((wins >> 1) - (losses >> 1));
+    }
+#endif
+    for (; j < count; j++)
+        outcomes[j] = (signed char) ((mine > scores[j]) - (mine < scores[j]));
+}
+
+bool buildFightTable(OwnerNode *owner, FightTable *table) {
+    memset(table, 0, sizeof(*table));
+
+    // Members in ascending ID order: straight from the bits, or an in-order walk
+    PokedexBits snapshot;
+    NodeArray nodes = { NULL, 0, 0 };
+    int count;
+    if (bitsetPokedexMode) {
+        // One copy of the bits, so count and walk agree while a writer flips them
+        for (int i = 0; i < POKEDEX_BIT_WORDS; i++)
+            snapshot.words[i] = __atomic_load_n(&owner->pokedexBits.words[i], __ATOMIC_RELAXED);
+        count = pokedexBitsCount(&snapshot);
+    } else {
+        // The root's size sizes the array exactly (one root load, so both see the same tree)
+        PokemonNode *root = __atomic_load_n(&owner->pokedexRoot, __ATOMIC_ACQUIRE);
+        if (root != NULL)
+            initNodeArray(&nodes, countPokemonNodes(root));
+        collectInOrder(root, &nodes);
+        count = nodes.size;
+    }
+
+    int slots = count > 0 ? count : 1;
+    table->members = malloc(slots * sizeof(PokemonData *));
+    table->attack = malloc(slots * sizeof(int32_t));
+    table->hp = malloc(slots * sizeof(int32_t));
+    table->scores = malloc(slots * sizeof(double));
+    if (table->members == NULL || table->attack == NULL || table->hp == NULL || table->scores == NULL) {
+        printf("Memory allocation failed.\n");
+        free(nodes.nodes);
+        freeFightTable(table);
+        return false;
+    }
+
+    // Gather attack and HP from the catalog's columns, then score every member once
+    const SpeciesCatalog *catalog = &speciesCatalog;
+    int id = bitsetPokedexMode ? pokedexBitsNext(&snapshot, 0) : -1;
+    for (int i = 0; i < count; i++) {
+        uint32_t species;
+        if (bitsetPokedexMode) {
+            species = (uint32_t) findSpeciesPosition(id);
+            id = pokedexBitsNext(&snapshot, id + 1);
+        } else {
+            species = nodes.nodes[i]->species;
+        }
+        table->members[table->count++] = &catalog->species[species];
+        table->attack[i] = catalog->attack[species];
+        table->hp[i] = catalog->hp[species];
+    }
+    free(nodes.nodes);
+    computeFightScores(table->attack, table->hp, table->scores, table->count);
+    return true;
+}
+
+void freeFightTable(FightTable *table) {
+    free(table->members);
+    free(table->attack);
+    free(table->hp);
+    free(table->scores);
+    memset(table, 0, sizeof(*table));
+}
+
+// True if a is a weaker pick than b: a smaller gap, or the same gap on later IDs
+static bool weakerMatchup(const FightMatchup *a, const FightMatchup *b) {
+    if (a->margin != b->margin) return a->margin < b->margin;
+    if (a->first != b->first) return a->first > b->first;
+    return a->second > b->second;
+}
+
+// Restore the heap (weakest pick on top) below position
+static void siftMatchupDown(FightMatchup *heap, int size, int position) {
+    for (;;) {
+        int weakest = position, left = 2 * position + 1, right = left + 1;
+        if (left < size && weakerMatchup(&heap[left], &heap[weakest])) weakest = left;
+        if (right < size && weakerMatchup(&heap[right], &heap[weakest])) weakest = right;
+        if (weakest == position) return;
+        FightMatchup swap = heap[position];
+        heap[position] = heap[weakest];
+        heap[weakest] = swap;
+        position = weakest;
+    }
+}
+
+int topFightMatchups(const FightTable *table, int n, FightMatchup *matchups) {
+    if (n <= 0) return 0;
+
+    // Keep the n strongest picks in a heap with the weakest on top
+    int size = 0;
+    for (int i = 0; i < table->count; i++) {
+        for (int j = i + 1; j < table->count; j++) {
+            double gap = table->scores[i] - table->scores[j];
+            FightMatchup candidate = { i, j, gap < 0 ? -gap : gap };
+            if (size < n) {
+                // Sift up
+                int position = size++;
+                matchups[position] = candidate;
+                while (position > 0 && weakerMatchup(&matchups[position], &matchups[(position - 1) / 2])) {
+                    FightMatchup swap = matchups[position];
+                    matchups[position] = matchups[(position - 1) / 2];
+                    matchups[(position - 1) / 2] = swap;
+                    position = (position - 1) / 2;
+                }
+            } else if (weakerMatchup(&matchups[0], &candidate)) {
+                matchups[0] = candidate;
+                siftMatchupDown(matchups, size, 0);
+            }
+        }
+    }
+
+    // Pop the weakest to the back until the array runs strongest first
+    for (int end = size - 1; end > 0; end--) {
+        FightMatchup swap = matchups[0];
+        matchups[0] = matchups[end];
+        matchups[end] = swap;
+        siftMatchupDown(matchups, end, 0);
+    }
+    return size;
+}
+
+// "<name> (Score = <score>)\n" for every member, with printf's own %.2f, back to back:
+// member i's line runs from offsets[i] to offsets[i + 1]
+static char *buildFightLines(const FightTable *table, size_t *offsets) {
+    size_t capacity = (size_t) (table->count > 0 ? table->count : 1) * FIGHT_LINE_BYTES, used = 0;
+    char *lines = malloc(capacity);
+    if (lines == NULL) {
+        printf("Memory allocation failed.\n");
+        return NULL;
+    }
+    for (int i = 0; i < table->count; i++) {
+        offsets[i] = used;
+        int length = snprintf(lines + used, capacity - used, "%s (Score = %.2f)\n",
+                              table->members[i]->name, table->scores[i]);
+        // Long names or huge scores can outgrow the room: grow it and write the line again
+        while (length >= 0 && (size_t) length >= capacity - used) {
+            char *grown = realloc(lines, 2 * capacity);
+            if (grown == NULL) {
+                printf("Memory allocation failed.\n");
+                free(lines);
+                return NULL;
+            }
+            lines = grown;
+            capacity *= 2;
+            length = snprintf(lines + used, capacity - used, "%s (Score = %.2f)\n",
+                              table->members[i]->name, table->scores[i]);
+        }
+        used += length > 0 ? (size_t) length : 0;
+    }
+    offsets[table->count] = used;
+    return lines;
+}
+
+// One fight, exactly as fightPokemonByIdLocked prints it, through the output sink
+static void printTableFight(const FightTable *table, const char *lines, const size_t *offsets,
+                            int first, int second, int outcome) {
+    const char *winner = outcome > 0 ? table->members[first]->name : table->members[second]->name;
+    size_t winnerLength = outcome == 0 ? 0 : strlen(winner);
+    size_t firstLength = offsets[first + 1] - offsets[first], secondLength = offsets[second + 1] - offsets[second];
+    char *out = reserveOutputSink(2 * 11 + firstLength + secondLength + winnerLength + 12);
+    if (out == NULL) return;
+    out = appendText(out, "Pokemon 1: ", 11);
+    out = appendText(out, lines + offsets[first], firstLength);
+    out = appendText(out, "Pokemon 2: ", 11);
+    out = appendText(out, lines + offsets[second], secondLength);
+    if (outcome == 0) {
+        out = appendText(out, "It's a tie!\n", 12);
+    } else {
+        out = appendText(out, winner, winnerLength);
+        out = appendText(out, " wins!\n", 7);
+    }
+    commitOutputSink(out);
+}
+
+// Table, per-member lines and a scratch row for one owner; false (reported) on failure
+static bool startFightReport(OwnerNode *owner, FightTable *table, char **lines, size_t **offsets) {
+    if (isPokedexEmpty(owner)) {
+        printf("Pokedex is empty.\n");
+        return false;
+    }
+    if (!buildFightTable(owner, table)) return false;
+    *offsets = malloc((size_t) (table->count + 1) * sizeof(size_t));
+    *lines = *offsets != NULL ? buildFightLines(table, *offsets) : NULL;
+    if (*lines == NULL) {
+        if (*offsets == NULL) printf("Memory allocation failed.\n");
+        free(*offsets);
+        freeFightTable(table);
+        return false;
+    }
+    return true;
+}
+
+void fightAllPairs(OwnerNode *owner) {
+    if (!beginOwnerRead(owner)) return;
+
+    FightTable table;
+    char *lines;
+    size_t *offsets;
+    if (startFightReport(owner, &table, &lines, &offsets)) {
+        signed char *outcomes = malloc(table.count);
+        if (outcomes == NULL) {
+            printf("Memory allocation failed.\n");
+        } else {
+            // One vector pass per row decides all of that member's later fights
+            for (int i = 0; i < table.count; i++) {
+                compareFightScores(table.scores, table.count, i, outcomes);
+                for (int j = i + 1; j < table.count; j++)
+                    printTableFight(&table, lines, offsets, i, j, outcomes[j]);
+            }
+            flushOutputSink();
+            free(outcomes);
+        }
+        free(lines);
+        free(offsets);
+        freeFightTable(&table);
+    }
+    endOwnerRead(owner);
+}
+
+void fightTopMatchups(OwnerNode *owner, int n) {
+    if (n <= 0) {
+        printf("Invalid choice.\n");
+        return;
+    }
+    if (!beginOwnerRead(owner)) return;
+
+    FightTable table;
+    char *lines;
+    size_t *offsets;
+    if (startFightReport(owner, &table, &lines, &offsets)) {
+        // More picks than pairs just returns every pair
+        long pairs = (long) table.count * (table.count - 1) / 2;
+        int wanted = pairs < n ? (int) pairs : n;
+        FightMatchup *matchups = malloc((size_t) (wanted > 0 ? wanted : 1) * sizeof(FightMatchup));
+        if (matchups == NULL) {
+            printf("Memory allocation failed.\n");
+        } else {
+            int found = topFightMatchups(&table, wanted, matchups);
+            for (int k = 0; k < found; k++) {
+                int first = matchups[k].first, second = matchups[k].second;
+                double mine = table.scores[first], theirs = table.scores[second];
+                printTableFight(&table, lines, offsets, first, second, (mine > theirs) - (mine < theirs));
+            }
+            flushOutputSink();
+            free(matchups);
+        }
+        free(lines);
+        free(offsets);
+        freeFightTable(&table);
+    }
+    endOwnerRead(owner);
+}
+
+// --------------------------------------------------------------
+// Pokemon Queries (filters across every owner)
+// --------------------------------------------------------------
+void initPokemonFilter(PokemonFilter *filter) {
+    filter->type = QUERY_ANY;
+    filter->hpMin = INT_MIN;
+    filter->hpMax = INT_MAX;
+    filter->attackMin = INT_MIN;
+    filter->attackMax = INT_MAX;
+    filter->canEvolve = QUERY_ANY;
+}
+
+bool pokemonMatchesFilter(const PokemonFilter *filter, const PokemonData *data) {
+    return (filter->type == QUERY_ANY || (int) data->TYPE == filter->type) &&
+           data->hp >= filter->hpMin && data->hp <= filter->hpMax &&
+           data->attack >= filter->attackMin && data->attack <= filter->attackMax &&
+           (filter->canEvolve == QUERY_ANY || (int) data->CAN_EVOLVE == filter->canEvolve);
+}
+
+int markMatchingSpecies(const PokemonFilter *filter, uint8_t *bitmap) {
+    const SpeciesCatalog *catalog = &speciesCatalog;
+    int count = catalog->count, matching = 0, i = 0;
+    bool anyType = filter->type == QUERY_ANY, anyEvolve = filter->canEvolve == QUERY_ANY;
+#if defined(__AVX2__)
+    // Eight species per step; a lane is rejected when a value is outside its range or a
+    // byte column differs, and the eight sign bits make one bitmap byte
+    const __m256i hpMin = _mm256_set1_epi32(filter->hpMin), hpMax = _mm256_set1_epi32(filter->hpMax);
+    const __m256i attackMin = _mm256_set1_epi32(filter->attackMin);
+    const __m256i attackMax = _mm256_set1_epi32(filter->attackMax);
+    const __m256i type = _mm256_set1_epi32(filter->type), evolve = _mm256_set1_epi32(filter->canEvolve);
+    for (; i + 8 <= count; i += 8) {
+        __m256i hp = _mm256_loadu_si256((const __m256i *) (catalog->hp + i));
+        __m256i attack = _mm256_loadu_si256((const __m256i *) (catalog->attack + i));
+        __m256i reject = _mm256_or_si256(_mm256_cmpgt_epi32(hpMin, hp), _mm256_cmpgt_epi32(hp, hpMax));
+        reject = _mm256_or_si256(reject, _mm256_cmpgt_epi32(attackMin, attack));
+        reject = _mm256_or_si256(reject, _mm256_cmpgt_epi32(attack, attackMax));
+        __m256i accept = _mm256_set1_epi32(-1);
+        if (!anyType) {
+            __m256i types = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) (catalog->types + i)));
+            accept = _mm256_cmpeq_epi32(types, type);
+        }
+        if (!anyEvolve) {
+            __m256i evolves = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) (catalog->canEvolve + i)));
+            accept = _mm256_and_si256(accept, _mm256_cmpeq_epi32(evolves, evolve));
+        }
+        int bits = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_andnot_si256(reject, accept)));
+        bitmap[i / 8] = (uint8_t) bits;
+        matching += __builtin_popcount((unsigned int) bits);
+    }
+#elif defined(__SSE2__)
+    // Two steps of four species fill one bitmap byte; the byte columns are widened by unpacking
+    const __m128i hpMin = _mm_set1_epi32(filter->hpMin), hpMax = _mm_set1_epi32(filter->hpMax);
+    const __m128i attackMin = _mm_set1_epi32(filter->attackMin), attackMax = _mm_set1_epi32(filter->attackMax);
+    const __m128i type = _mm_set1_epi32(filter->type), evolve = _mm_set1_epi32(filter->canEvolve);
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8) {
+        int bits = 0;
+        for (int half = 0; half < 8; half += 4) {
+            __m128i hp = _mm_loadu_si128((const __m128i *) (catalog->hp + i + half));
+            __m128i attack = _mm_loadu_si128((const __m128i *) (catalog->attack + i + half));
+            __m128i reject = _mm_or_si128(_mm_cmpgt_epi32(hpMin, hp), _mm_cmpgt_epi32(hp, hpMax));
+            reject = _mm_or_si128(reject, _mm_cmpgt_epi32(attackMin, attack));
+            reject = _mm_or_si128(reject, _mm_cmpgt_epi32(attack, attackMax));
+            __m128i accept = _mm_set1_epi32(-1);
+            int32_t packed;
+            if (!anyType) {
+                memcpy(&packed, catalog->types + i + half, sizeof(packed));
+                __m128i types = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+                accept = _mm_cmpeq_epi32(types, type);
+            }
+            if (!anyEvolve) {
+                memcpy(&packed, catalog->canEvolve + i + half, sizeof(packed));
+                __m128i evolves = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+                accept = _mm_and_si128(accept, _mm_cmpeq_epi32(evolves, evolve));
+            }
+            bits |= _mm_movemask_ps(_mm_castsi128_ps(_mm_andnot_si128(reject, accept))) << half;
+        }
+        bitmap[i / 8] = (uint8_t) bits;
+        matching += __builtin_popcount((unsigned int) bits);
+    }
+#endif
+    // The tail (or everything, without SIMD) one species at a time, from the same columns
+    if (i < count)
+        memset(bitmap + i / 8, 0, (size_t) (count - i + 7) / 8);
+    for (; i < count; i++) {
+        bool match = (anyType || catalog->types[i] == filter->type) &&
+                     catalog->hp[i] >= filter->hpMin && catalog->hp[i] <= filter->hpMax &&
+                     catalog->attack[i] >= filter->attackMin && catalog->attack[i] <= filter->attackMax &&
+                     (anyEvolve || catalog->canEvolve[i] == filter->canEvolve);
+        if (match) {
+            bitmap[i / 8] |= (uint8_t) (1u << (i % 8));
+            matching++;
+        }
+    }
+    return matching;
+}
+
+// Add one match to a worker's buffer (doubling it when full)
+static void addQueryMatch(QueryWorker *worker, OwnerNode *owner, int id) {
+    if (worker->count == worker->capacity) {
+        long capacity = worker->capacity > 0 ? worker->capacity * 2 : 256;
+        QueryMatch *grown = realloc(worker->matches, (size_t) capacity * sizeof(QueryMatch));
+        if (grown == NULL) {
+            worker->failed = true;
+            return;
+        }
+        worker->matches = grown;
+        worker->capacity = capacity;
+    }
+    worker->matches[worker->count].owner = owner;
+    worker->matches[worker->count++].id = id;
+}
+
+// One owner's matches, ascending by ID (the owner is locked or pinned by the caller)
+static void scanQueryOwner(QueryWorker *worker, OwnerNode *owner) {
+    const QueryScan *scan = worker->scan;
+    if (bitsetPokedexMode) {
+        for (int word = 0; word < POKEDEX_BIT_WORDS; word++) {
+            uint64_t hits = __atomic_load_n(&owner->pokedexBits.words[word], __ATOMIC_RELAXED) &
+                            scan->bitsMatch.words[word];
+            worker->nodes += 64;
+            if (scan->mode == QUERY_COUNT) {
+                worker->count += __builtin_popcountll(hits);
+                continue;
+            }
+            for (; hits != 0; hits &= hits - 1) {
+                addQueryMatch(worker, owner, word * 64 + __builtin_ctzll(hits));
+                if (scan->mode == QUERY_OWNERS) return;
+            }
+        }
+        return;
+    }
+
+    // The root's subtree fields rule out a whole Pokédex without type or strong enough attack
+    PokemonNode *root = __atomic_load_n(&owner->pokedexRoot, __ATOMIC_ACQUIRE);
+    const PokemonFilter *filter = scan->filter;
+    if (root == NULL || root->maxAttack < filter->attackMin ||
+        (filter->type != QUERY_ANY && !(root->typeMask & (1u << filter->type))))
+        return;
+
+    TreeCursor cursor;
+    treeCursorInit(&cursor, root, TRAVERSE_IN);
+    PokemonNode *node;
+    while ((node = treeCursorNext(&cursor)) != NULL) {
+        worker->nodes++;
+        uint32_t species = node->species;
+        if (!(scan->speciesMatch[species / 8] >> (species % 8) & 1)) continue;
+        if (scan->mode == QUERY_COUNT) {
+            worker->count++;
+            continue;
+        }
+        addQueryMatch(worker, owner, speciesCatalog.ids[species]);
+        if (scan->mode == QUERY_OWNERS) break;
+    }
+    if (cursor.failed) worker->failed = true;
+    treeCursorFree(&cursor);
+}
+
+// Claim chunks of owners until none are left; each owner's matches are recorded in its span
+static void *runQueryWorker(void *arg) {
+    QueryWorker *worker = arg;
+    QueryScan *scan = worker->scan;
+    if (epochReadsMode) epochEnter();
+    while (true) {
+        int first = __atomic_fetch_add(&scan->nextOwner, QUERY_CHUNK_OWNERS, __ATOMIC_RELAXED);
+        if (first >= scan->ownerCount) break;
+        int last = first + QUERY_CHUNK_OWNERS < scan->ownerCount ? first + QUERY_CHUNK_OWNERS : scan->ownerCount;
+        for (int i = first; i < last; i++) {
+            OwnerNode *owner = scan->owners[i];
+            long start = worker->count;
+            if (!epochReadsMode) lockOwner(owner);
+            if (!__atomic_load_n(&owner->retired, __ATOMIC_ACQUIRE))
+                scanQueryOwner(worker, owner);
+            if (!epochReadsMode) unlockOwner(owner);
+            if (scan->spans != NULL) {
+                scan->spans[i].worker = worker->index;
+                scan->spans[i].start = start;
+                scan->spans[i].count = worker->count - start;
+            }
+        }
+    }
+    if (epochReadsMode) epochExit();
+    return NULL;
+}
+
+// How many threads scan ownerCount owners
+static int queryThreadCount(int ownerCount) {
+    int threads = queryThreads;
+    if (threads <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = ownerCount / QUERY_OWNERS_PER_THREAD;
+        if (cores > 0 && threads > cores) threads = (int) cores;
+    }
+    if (threads > QUERY_MAX_THREADS) threads = QUERY_MAX_THREADS;
+    return threads < 1 ? 1 : threads;
+}
+
+// Scan the owners with the calling thread as worker 0; false if any worker failed
+static bool runQueryScan(QueryScan *scan, QueryWorker *workers, int threads) {
+    pthread_t ids[QUERY_MAX_THREADS];
+    bool started[QUERY_MAX_THREADS] = { false };
+    for (int t = 0; t < threads; t++) {
+        workers[t].scan = scan;
+        workers[t].index = t;
+    }
+    // A thread that can't start leaves its share to the others
+    for (int t = 1; t < threads; t++)
+        started[t] = pthread_create(&ids[t], NULL, runQueryWorker, &workers[t]) == 0;
+    runQueryWorker(&workers[0]);
+
+    bool ok = true;
+    for (int t = 0; t < threads; t++) {
+        if (started[t]) pthread_join(ids[t], NULL);
+        ok = ok && !workers[t].failed;
+    }
+    return ok;
+}
+
+// Bits of the IDs whose species pass, for --bitset Pokédexes (every ID is below POKEDEX_BIT_WORDS * 64)
+static void markMatchingBits(QueryScan *scan) {
+    for (int p = 0; p < speciesCatalog.count; p++) {
+        int id = speciesCatalog.ids[p];
+        if ((scan->speciesMatch[p / 8] >> (p % 8) & 1) && id < POKEDEX_BIT_WORDS * 64)
+            scan->bitsMatch.words[id / 64] |= (uint64_t) 1 << (id % 64);
+    }
+}
+
+// The owners in ring order (and a span per owner unless only counting); ownerRingLock held
+static bool listQueryOwners(QueryScan *scan) {
+    int owners = 0;
+    OwnerNode *owner = ownerHead;
+    while (owner != NULL) {
+        owners++;
+        owner = owner->next;
+        if (owner == ownerHead) break;
+    }
+    scan->owners = malloc((size_t) (owners > 0 ? owners : 1) * sizeof(OwnerNode *));
+    if (scan->mode != QUERY_COUNT)
+        scan->spans = malloc((size_t) (owners > 0 ? owners : 1) * sizeof(QueryOwnerSpan));
+    if (scan->owners == NULL || (scan->mode != QUERY_COUNT && scan->spans == NULL)) return false;
+
+    for (owner = ownerHead; scan->ownerCount < owners; owner = owner->next)
+        scan->owners[scan->ownerCount++] = owner;
+    return true;
+}
+
+// Total the workers and copy their runs into result in ring order
+static bool gatherQueryMatches(const QueryScan *scan, const QueryWorker *workers, int threads, QueryResult *result) {
+    for (int t = 0; t < threads; t++) {
+        result->count += workers[t].count;
+        STAT_NODES(workers[t].nodes);
+    }
+    if (scan->mode == QUERY_COUNT) return true;
+
+    result->matches = malloc((size_t) (result->count > 0 ? result->count : 1) * sizeof(QueryMatch));
+    if (result->matches == NULL) return false;
+    long next = 0;
+    for (int i = 0; i < scan->ownerCount && next < result->count; i++) {
+        const QueryOwnerSpan *run = &scan->spans[i];
+        memcpy(result->matches + next, workers[run->worker].matches + run->start,
+               (size_t) run->count * sizeof(QueryMatch));
+        next += run->count;
+    }
+    return true;
+}
+
+bool queryPokemon(const PokemonFilter *filter, QueryMode mode, QueryResult *result) {
+    STAT_BEGIN(STAT_QUERY, span);
+    result->matches = NULL;
+    result->count = 0;
+
+    QueryScan scan;
+    memset(&scan, 0, sizeof(scan));
+    scan.filter = filter;
+    scan.mode = mode;
+    QueryWorker workers[QUERY_MAX_THREADS];
+    memset(workers, 0, sizeof(workers));
+    int threads = 0;
+
+    uint8_t *speciesMatch = malloc((size_t) (speciesCatalog.count + 7) / 8);
+    bool ok = speciesMatch != NULL;
+    if (ok) {
+        int matching = markMatchingSpecies(filter, speciesMatch);
+        scan.speciesMatch = speciesMatch;
+        if (bitsetPokedexMode)
+            markMatchingBits(&scan);
+
+        // The ring can't change while the owners are scanned; Pokédex changes still can
+        readLockOwners();
+        ok = listQueryOwners(&scan);
+        // No species passes: no Pokemon can, whatever the owners hold
+        if (ok && matching > 0 && scan.ownerCount > 0) {
+            threads = queryThreadCount(scan.ownerCount);
+            ok = runQueryScan(&scan, workers, threads);
+        }
+        unlockOwners();
+    }
+    if (ok)
+        ok = gatherQueryMatches(&scan, workers, threads, result);
+    if (!ok) {
+        printf("Memory allocation failed.\n");
+        freeQueryResult(result);
+    }
+
+    for (int t = 0; t < threads; t++)
+        free(workers[t].matches);
+    free(scan.spans);
+    free(scan.owners);
+    free(speciesMatch);
+    STAT_END(STAT_QUERY, span);
+    return ok;
+}
+
+void freeQueryResult(QueryResult *result) {
+    free(result->matches);
+    result->matches = NULL;
+    result->count = 0;
+}
+
+void printQueryResult(const QueryResult *result, QueryMode mode) {
+    if (mode == QUERY_COUNT) {
+        printf("Matching Pokemon: %ld\n", result->count);
+        return;
+    }
+    if (result->count == 0) {
+        printf("No matching Pokemon.\n");
+        return;
+    }
+
+    OwnerNode *current = NULL;
+    for (long i = 0; i < result->count; i++) {
+        const QueryMatch *match = &result->matches[i];
+        int position = findSpeciesPosition(match->id);
+        if (mode == QUERY_OWNERS) {
+            printf("%s: ID %d (%s)\n", match->owner->ownerName, match->id, speciesCatalog.species[position].name);
+            continue;
+        }
+        if (match->owner != current) {
+            // Owner lines go through printf, so hand over whatever the sink holds first
+            flushOutputSink();
+            printf("Owner: %s\n", match->owner->ownerName);
+            current = match->owner;
+        }
+        PokemonNode node = { .species = (uint32_t) position, .height = 1 };
+        printPokemonNode(&node);
+    }
+    flushOutputSink();
+}
+
+// Read a type name (any case) or "any" for the query menu; false if it names no type
+static bool readQueryType(int *type) {
+    printf("Type (e.g. FIRE, or ANY): ");
+    char *text = getDynamicInput();
+    if (text == NULL) return false;
+    for (char *p = text; *p; p++)
+        *p = (char) toupper((unsigned char) *p);
+    *type = strcmp(text, "ANY") == 0 ? QUERY_ANY : findTypeByName(text, strlen(text));
+    bool named = strcmp(text, "ANY") == 0 || *type >= 0;
+    free(text);
+    return named;
+}
+
+void queryPokemonMenu(void) {
+    if (ownerHead == NULL) {
+        printf("No existing Pokedexes.\n");
+        return;
+    }
+
+    PokemonFilter filter;
+    initPokemonFilter(&filter);
+    if (!readQueryType(&filter.type)) {
+        printf("Invalid type.\n");
+        return;
+    }
+    // HP and attack are positive, so 0 leaves a bound open
+    int hpMin = readIntSafe("Min HP (0 = no minimum): ");
+    int hpMax = readIntSafe("Max HP (0 = no maximum): ");
+    int attackMin = readIntSafe("Min Attack (0 = no minimum): ");
+    int attackMax = readIntSafe("Max Attack (0 = no maximum): ");
+    if (hpMin > 0) filter.hpMin = hpMin;
+    if (hpMax > 0) filter.hpMax = hpMax;
+    if (attackMin > 0) filter.attackMin = attackMin;
+    if (attackMax > 0) filter.attackMax = attackMax;
+
+    int evolve = readIntSafe("Can evolve? (1 = Yes, 2 = No, 3 = Any): ");
+    if (evolve < 1 || evolve > 3) {
+        printf("Invalid choice.\n");
+        return;
+    }
+    filter.canEvolve = evolve == 1 ? CAN_EVOLVE : evolve == 2 ? CANNOT_EVOLVE : QUERY_ANY;
+
+    printf("1. List matches\n");
+    printf("2. Count matches\n");
+    printf("3. Owners with a match\n");
+    int choice = readIntSafe("Your choice: ");
+    if (choice < 1 || choice > 3) {
+        printf("Invalid choice.\n");
+        return;
+    }
+    QueryMode mode = choice == 1 ? QUERY_LIST : choice == 2 ? QUERY_COUNT : QUERY_OWNERS;
+
+    QueryResult result;
+    if (queryPokemon(&filter, mode, &result))
+        printQueryResult(&result, mode);
+    freeQueryResult(&result);
+}
+
+// --------------------------------------------------------------
+// Instrumentation (per-operation counters and latency histograms)
+// --------------------------------------------------------------
+
+// Names printed for each StatOp, in enum order
+static const char *statOpNames[STAT_OP_COUNT] = {
+    "searchPokemonBFS", "insertPokemonNode", "removeNodeBST", "mergeBSTBalanced",
+    "BFSGeneric", "findOwnerByName", "sortOwners", "queryPokemon",
+    "menu: New Pokedex", "menu: Existing Pokedex", "menu: Delete a Pokedex", "menu: Merge Pokedexes",
+    "menu: Sort Owners", "menu: Print Owners", "menu: Save Owners", "menu: Load Owners", "menu: Query Pokemon",
+    "pokedex: Add Pokemon", "pokedex: Display", "pokedex: Release", "pokedex: Fight", "pokedex: Evolve"
+};
+
+static uint64_t statNowNs(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
+
+// The calling thread's counters, created and listed on its first call
+static StatsBlock *threadStatsBlock(void) {
+    if (threadStats == NULL) {
+        StatsBlock *block = calloc(1, sizeof(StatsBlock));
+        if (block == NULL) return NULL;
+        pthread_mutex_lock(&statsLock);
+        block->next = statsBlocks;
+        statsBlocks = block;
+        pthread_mutex_unlock(&statsLock);
+        threadStats = block;
+    }
+    return threadStats;
+}
+
+// Only the owning thread writes a counter: a relaxed store (no locked add) is enough
+// for printStats to read it from another thread
+static inline void statAdd(uint64_t *counter, uint64_t amount) {
+    __atomic_store_n(counter, *counter + amount, __ATOMIC_RELAXED);
+}
+
+void statBegin(StatOp op, StatSpan *span) {
+    // Get the block first, so creating it isn't charged to the operation
+    StatsBlock *block = threadStatsBlock();
+    span->timed = op >= STAT_MENU_NEW || (block != NULL && block->ops[op].calls % STAT_SAMPLE_EVERY == 0);
+    span->nodes = threadNodesVisited;
+    span->allocations = threadAllocations;
+    span->startNs = span->timed ? statNowNs() : 0;
+}
+
+void statEnd(StatOp op, const StatSpan *span) {
+    uint64_t elapsed = span->timed ? statNowNs() - span->startNs : 0;
+    StatsBlock *block = threadStats;
+    if (block == NULL) return;
+
+    OpStats *stats = &block->ops[op];
+    statAdd(&stats->calls, 1);
+    statAdd(&stats->nodes, threadNodesVisited - span->nodes);
+    statAdd(&stats->allocations, threadAllocations - span->allocations);
+    if (!span->timed) return;
+
+    // Bucket b holds [2^b, 2^(b+1)) ns, so it is the index of the highest set bit
+    int bucket = elapsed == 0 ? 0 : 63 - __builtin_clzll(elapsed);
+    if (bucket >= STAT_BUCKETS) bucket = STAT_BUCKETS - 1;
+    statAdd(&stats->timed, 1);
+    statAdd(&stats->totalNs, elapsed);
+    statAdd(&stats->buckets[bucket], 1);
+}
+
+// Upper bound of a bucket, 2^(bucket+1) ns, rounded up to ns, us or ms
+static void formatBucketBound(int bucket, char *text, size_t size) {
+    if (bucket >= STAT_BUCKETS - 1) {
+        snprintf(text, size, "more");
+        return;
+    }
+    unsigned long long bound = 1ull << (bucket + 1);
+    if (bound < 10000)
+        snprintf(text, size, "%lluns", bound);
+    else if (bound < 10000000)
+        snprintf(text, size, "%lluus", (bound + 999) / 1000);
+    else
+        snprintf(text, size, "%llums", (bound + 999999) / 1000000);
+}
+
+// The bucket holding the timed call at fraction of the way through the sorted latencies
+static int statPercentileBucket(const OpStats *stats, double fraction) {
+    uint64_t rank = (uint64_t) (fraction * (double) stats->timed);
+    uint64_t seen = 0;
+    for (int b = 0; b < STAT_BUCKETS; b++) {
+        seen += stats->buckets[b];
+        if (seen > rank) return b;
+    }
+    return STAT_BUCKETS - 1;
+}
+
+void printStats(FILE *out) {
+#ifdef EX6_NO_STATS
+    fprintf(out, "Stats are compiled out (EX6_NO_STATS).\n");
+    return;
+#endif
+
+    // Sum every thread's counters
+    OpStats totals[STAT_OP_COUNT];
+    memset(totals, 0, sizeof(totals));
+    pthread_mutex_lock(&statsLock);
+    for (StatsBlock *block = statsBlocks; block != NULL; block = block->next) {
+        for (int op = 0; op < STAT_OP_COUNT; op++) {
+            const OpStats *from = &block->ops[op];
+            totals[op].calls += __atomic_load_n(&from->calls, __ATOMIC_RELAXED);
+            totals[op].nodes += __atomic_load_n(&from->nodes, __ATOMIC_RELAXED);
+            totals[op].allocations += __atomic_load_n(&from->allocations, __ATOMIC_RELAXED);
+            totals[op].timed += __atomic_load_n(&from->timed, __ATOMIC_RELAXED);
+            totals[op].totalNs += __atomic_load_n(&from->totalNs, __ATOMIC_RELAXED);
+            for (int b = 0; b < STAT_BUCKETS; b++)
+                totals[op].buckets[b] += __atomic_load_n(&from->buckets[b], __ATOMIC_RELAXED);
+        }
+    }
+    pthread_mutex_unlock(&statsLock);
+
+    fprintf(out, "=== Stats ===\n");
+    fprintf(out, "%-24s %9s %9s %10s %8s %8s %11s %11s\n",
+            "operation", "calls", "timed", "avg ns", "p50 <", "p99 <", "nodes/call", "allocs/call");
+    bool any = false;
+    char p50[16], p99[16], bound[16];
+    for (int op = 0; op < STAT_OP_COUNT; op++) {
+        const OpStats *stats = &totals[op];
+        if (stats->calls == 0) continue;
+        any = true;
+
+        // Latency comes from the timed calls only
+        uint64_t timed = stats->timed ? stats->timed : 1;
+        formatBucketBound(statPercentileBucket(stats, 0.5), p50, sizeof(p50));
+        formatBucketBound(statPercentileBucket(stats, 0.99), p99, sizeof(p99));
+        fprintf(out, "%-24s %9llu %9llu %10llu %8s %8s %11.1f %11.2f\n", statOpNames[op],
+                (unsigned long long) stats->calls, (unsigned long long) stats->timed,
+                (unsigned long long) (stats->totalNs / timed), p50, p99,
+                (double) stats->nodes / stats->calls, (double) stats->allocations / stats->calls);
+
+        // The histogram: calls per latency bucket, empty buckets left out
+        fprintf(out, "  latency");
+        for (int b = 0; b < STAT_BUCKETS; b++) {
+            if (stats->buckets[b] == 0) continue;
+            formatBucketBound(b, bound, sizeof(bound));
+            fprintf(out, " <%s:%llu", bound, (unsigned long long) stats->buckets[b]);
+        }
+        fprintf(out, "\n");
+    }
+    if (!any)
+        fprintf(out, "No operations counted yet.\n");
+}
+
+void freeStats(void) {
+    pthread_mutex_lock(&statsLock);
+    while (statsBlocks != NULL) {
+        StatsBlock *next = statsBlocks->next;
+        free(statsBlocks);
+        statsBlocks = next;
+    }
+    threadStats = NULL;
+    pthread_mutex_unlock(&statsLock);
+}
+
+// --------------------------------------------------------------
+// Journal (write-ahead log of every change, with checkpoints)
+// --------------------------------------------------------------
+
+// 32-bit FNV-1a over a byte range, continuing from hash
+static uint32_t journalChecksum(uint32_t hash, const void *bytes, size_t length) {
+    const unsigned char *p = bytes;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static bool writeAll(int fd, const void *bytes, size_t length) {
+    const char *p = bytes;
+    while (length > 0) {
+        ssize_t written = write(fd, p, length);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        p += written;
+        length -= (size_t) written;
+    }
+    return true;
+}
+
+static double journalNow(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// Hand the buffered records to the OS
+static bool flushJournalBuffer(void) {
+    if (journal.size == 0) return true;
+    bool ok = writeAll(journal.fd, journal.buffer, journal.size);
+    journal.size = 0;
+    if (!ok)
+        printf("Journal write failed.\n");
+    return ok;
+}
+
+static void appendJournalBytes(const void *bytes, size_t length) {
+    if (length == 0) return;
+    if (length > JOURNAL_BUFFER_BYTES - journal.size) {
+        flushJournalBuffer();
+        // Too big to buffer at all: straight to the file
+        if (length > JOURNAL_BUFFER_BYTES) {
+            if (!writeAll(journal.fd, bytes, length))
+                printf("Journal write failed.\n");
+            return;
+        }
+    }
+    memcpy(journal.buffer + journal.size, bytes, length);
+    journal.size += length;
+}
+
+static void syncJournalLocked(void) {
+    if (journal.unsynced)
+        fdatasync(journal.fd);
+    journal.unsynced = false;
+}
+
+void syncJournal(void) {
+    if (journal.fd < 0) return;
+    pthread_mutex_lock(&journal.lock);
+    syncJournalLocked();
+    pthread_mutex_unlock(&journal.lock);
+}
+
+void journalRecord(JournalOp op, const char *name, const char *otherName, int value) {
+    if (journal.fd < 0) return;
+
+    // Threads append whole records, one at a time, in sequence order
+    pthread_mutex_lock(&journal.lock);
+
+    // Record: length, checksum, sequence, op, then the payload (two names and a value)
+    uint32_t nameLength = name ? (uint32_t) strlen(name) : 0;
+    uint32_t otherLength = otherName ? (uint32_t) strlen(otherName) : 0;
+    int32_t value32 = value;
+    uint64_t sequence = journal.sequence + 1;
+    uint8_t op8 = (uint8_t) op;
+    uint32_t length = (uint32_t) (3 * sizeof(uint32_t) + nameLength + otherLength);
+
+    uint32_t checksum = journalChecksum(2166136261u, &sequence, sizeof(sequence));
+    checksum = journalChecksum(checksum, &op8, 1);
+    checksum = journalChecksum(checksum, &nameLength, sizeof(nameLength));
+    checksum = journalChecksum(checksum, name, nameLength);
+    checksum = journalChecksum(checksum, &otherLength, sizeof(otherLength));
+    checksum = journalChecksum(checksum, otherName, otherLength);
+    checksum = journalChecksum(checksum, &value32, sizeof(value32));
+
+    appendJournalBytes(&length, sizeof(length));
+    appendJournalBytes(&checksum, sizeof(checksum));
+    appendJournalBytes(&sequence, sizeof(sequence));
+    appendJournalBytes(&op8, 1);
+    appendJournalBytes(&nameLength, sizeof(nameLength));
+    appendJournalBytes(name, nameLength);
+    appendJournalBytes(&otherLength, sizeof(otherLength));
+    appendJournalBytes(otherName, otherLength);
+    appendJournalBytes(&value32, sizeof(value32));
+    journal.sequence = sequence;
+
+    // The record reaches the OS before we return: a crash of this process can't lose it
+    flushJournalBuffer();
+
+    // Group commit: one fdatasync covers every record since the window opened
+    double now = journal.syncMs > 0 ? journalNow() : 0.0;
+    if (!journal.unsynced) {
+        journal.unsynced = true;
+        journal.oldestUnsynced = now;
+        if (journal.syncThreadRunning)
+            pthread_cond_signal(&journal.windowOpened);
+    }
+    if (journal.syncMs == 0 || (journal.syncMs > 0 && (now - journal.oldestUnsynced) * 1000.0 >= journal.syncMs))
+        syncJournalLocked();
+
+    journal.sinceCheckpoint++;
+    pthread_mutex_unlock(&journal.lock);
+}
+
+// Closes each sync window on time, also when no further record arrives to close it
+static void *runJournalSyncThread(void *unused) {
+    (void) unused;
+    pthread_mutex_lock(&journal.lock);
+    while (journal.syncThreadRunning) {
+        if (!journal.unsynced) {
+            pthread_cond_wait(&journal.windowOpened, &journal.lock);
+            continue;
+        }
+        double deadline = journal.oldestUnsynced + journal.syncMs / 1000.0;
+        if (journalNow() >= deadline) {
+            syncJournalLocked();
+            continue;
+        }
+        struct timespec wake;
+        wake.tv_sec = (time_t) deadline;
+        wake.tv_nsec = (long) ((deadline - (double) wake.tv_sec) * 1e9);
+        pthread_cond_timedwait(&journal.windowOpened, &journal.lock, &wake);
+    }
+    pthread_mutex_unlock(&journal.lock);
+    return NULL;
+}
+
+void checkpointJournalIfDue(void) {
+    // Called between commands: mid-command (merge, delete) the owners are not consistent
+    if (journal.fd < 0 || journal.checkpointEvery <= 0) return;
+    pthread_mutex_lock(&journal.lock);
+    bool due = journal.sinceCheckpoint >= journal.checkpointEvery;
+    pthread_mutex_unlock(&journal.lock);
+    if (due)
+        checkpointJournal();
+}
+
+void checkpointJournal(void) {
+    if (journal.fd < 0) return;
+
+    // The snapshot records the last sequence it covers, so if we crash before the
+    // truncation, replay skips the records that are already in it.
+    // No owner or record changes between the snapshot and the truncation.
+    writeLockOwners();
+    pthread_mutex_lock(&journal.lock);
+    syncJournalLocked();
+    if (writeSnapshot(journal.snapshotPath) >= 0) {
+        if (ftruncate(journal.fd, JOURNAL_MAGIC_BYTES) != 0 || lseek(journal.fd, 0, SEEK_END) < 0)
+            printf("Journal write failed.\n");
+        else {
+            fdatasync(journal.fd);
+            journal.sinceCheckpoint = 0;
+        }
+    }
+    pthread_mutex_unlock(&journal.lock);
+    unlockOwners();
+}
+
+// Re-apply one logged change with the silent building blocks (no prompts, no messages)
+static void applyJournalRecord(JournalOp op, const char *name, const char *otherName, int value) {
+    OwnerNode *owner = findOwnerByName(name);
+    bool inserted;
+    switch (op) {
+        case JOURNAL_NEW:
+            if (owner != NULL || starterSpecies(value) == NULL) return;
+            owner = createOwnerWithName(name, strlen(name));
+            if (owner == NULL) return;
+            if (!ownerAddPokemon(owner, starterSpecies(value), &inserted)) {
+                freeOwnerNode(owner);
+                return;
+            }
+            linkOwnerInCircularList(owner);
+            break;
+        case JOURNAL_ADD:
+            if (owner != NULL && findSpecies(value) != NULL)
+                ownerAddPokemon(owner, findSpecies(value), &inserted);
+            break;
+        case JOURNAL_RELEASE:
+            if (owner != NULL)
+                ownerRemovePokemon(owner, value);
+            break;
+        case JOURNAL_EVOLVE:
+            if (owner != NULL && value < INT_MAX && findSpecies(value + 1) != NULL &&
+                findOwnerPokemon(owner, value) != NULL) {
+                if (ownerAddPokemon(owner, findSpecies(value + 1), &inserted))
+                    ownerRemovePokemon(owner, value);
+            }
+            break;
+        case JOURNAL_MERGE: {
+            OwnerNode *other = findOwnerByName(otherName);
+            if (owner != NULL && other != NULL && owner != other) {
+                mergeOwnerPokedex(owner, other);
+                removeOwnerFromCircularList(other);
+            }
+            break;
+        }
+        case JOURNAL_DELETE:
+            if (owner != NULL)
+                removeOwnerFromCircularList(owner);
+            break;
+        case JOURNAL_SORT:
+            sortOwnerRing();
+            break;
+    }
+}
+
+// Copy a length-prefixed name out of a record into a '\0'-terminated buffer
+static bool readJournalName(const unsigned char **p, const unsigned char *end, char **name, size_t *capacity) {
+    uint32_t length;
+    if ((size_t) (end - *p) < sizeof(length)) return false;
+    memcpy(&length, *p, sizeof(length));
+    *p += sizeof(length);
+    if ((size_t) (end - *p) < length || memchr(*p, '\0', length) != NULL) return false;
+    if (length + 1 > *capacity) {
+        char *grown = realloc(*name, length + 1);
+        if (grown == NULL) return false;
+        *name = grown;
+        *capacity = length + 1;
+    }
+    memcpy(*name, *p, length);
+    (*name)[length] = '\0';
+    *p += length;
+    return true;
+}
+
+// Replay every intact record after 'after'; returns the byte length of the intact prefix
+static size_t replayJournal(const unsigned char *data, size_t size, uint64_t after, long *replayed) {
+    const size_t headerBytes = 2 * sizeof(uint32_t) + sizeof(uint64_t) + 1;
+    size_t offset = JOURNAL_MAGIC_BYTES;
+    char *name = NULL, *otherName = NULL;
+    size_t nameCapacity = 0, otherCapacity = 0;
+    while (size - offset >= headerBytes) {
+        uint32_t length, checksum;
+        uint64_t sequence;
+        const unsigned char *p = data + offset;
+        memcpy(&length, p, sizeof(length));
+        memcpy(&checksum, p + 4, sizeof(checksum));
+        memcpy(&sequence, p + 8, sizeof(sequence));
+        JournalOp op = (JournalOp) p[16];
+        if (size - offset - headerBytes < length) break;
+
+        // A torn or corrupt record ends the journal
+        if (journalChecksum(2166136261u, p + 8, sizeof(sequence) + 1 + length) != checksum) break;
+        const unsigned char *payload = p + headerBytes, *end = payload + length;
+        int32_t value;
+        if (!readJournalName(&payload, end, &name, &nameCapacity) ||
+            !readJournalName(&payload, end, &otherName, &otherCapacity) ||
+            (size_t) (end - payload) != sizeof(value))
+            break;
+        memcpy(&value, payload, sizeof(value));
+
+        if (sequence > after) {
+            applyJournalRecord(op, name, otherName, value);
+            (*replayed)++;
+        }
+        if (sequence > journal.sequence)
+            journal.sequence = sequence;
+        offset += headerBytes + length;
+    }
+    free(name);
+    free(otherName);
+    return offset;
+}
+
+bool openJournal(const char *path) {
+    // Checkpoints live next to the journal
+    size_t pathLength = strlen(path);
+    journal.snapshotPath = malloc(pathLength + 6);
+    if (journal.snapshotPath == NULL) {
+        printf("Memory allocation failed.\n");
+        return false;
+    }
+    strcat(strcpy(journal.snapshotPath, path), ".snap");
+
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        printf("Cannot open %s.\n", path);
+        if (fd >= 0) close(fd);
+        return false;
+    }
+
+    // Recover: the last checkpoint first, then the records written after it
+    uint64_t checkpointSequence = 0;
+    struct stat snapshotInfo;
+    int recovered = 0;
+    if (stat(journal.snapshotPath, &snapshotInfo) == 0) {
+        writeLockOwners();
+        recovered = readSnapshot(journal.snapshotPath, &checkpointSequence);
+        unlockOwners();
+    }
+    if (recovered < 0) {
+        close(fd);
+        return false;
+    }
+    journal.sequence = checkpointSequence;
+
+    size_t size = (size_t) info.st_size, intact = JOURNAL_MAGIC_BYTES;
+    long replayed = 0;
+    if (size >= JOURNAL_MAGIC_BYTES) {
+        void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED || memcmp(mapping, JOURNAL_MAGIC, JOURNAL_MAGIC_BYTES) != 0) {
+            printf("Invalid journal file.\n");
+            if (mapping != MAP_FAILED) munmap(mapping, size);
+            close(fd);
+            return false;
+        }
+        intact = replayJournal(mapping, size, checkpointSequence, &replayed);
+        munmap(mapping, size);
+    } else if (size > 0) {
+        printf("Invalid journal file.\n");
+        close(fd);
+        return false;
+    }
+
+    // Cut off a torn tail (or start a new journal) and append from there
+    if (size < JOURNAL_MAGIC_BYTES && !writeAll(fd, JOURNAL_MAGIC, JOURNAL_MAGIC_BYTES)) {
+        printf("Journal write failed.\n");
+        close(fd);
+        return false;
+    }
+    if (intact < size && ftruncate(fd, intact) != 0) {
+        printf("Journal write failed.\n");
+        close(fd);
+        return false;
+    }
+    lseek(fd, 0, SEEK_END);
+    fdatasync(fd);
+    journal.fd = fd;
+    journal.size = 0;
+    journal.unsynced = false;
+    journal.sinceCheckpoint = replayed;
+
+    // With a sync window, a thread sleeps until each window's deadline (on the same clock as journalNow)
+    if (journal.syncMs > 0) {
+        pthread_condattr_t attributes;
+        pthread_condattr_init(&attributes);
+        pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+        pthread_cond_init(&journal.windowOpened, &attributes);
+        pthread_condattr_destroy(&attributes);
+        journal.syncThreadRunning = true;
+        if (pthread_create(&journal.syncThread, NULL, runJournalSyncThread, NULL) != 0) {
+            // Without it the window still closes on the next record, checkpoint or exit
+            journal.syncThreadRunning = false;
+            pthread_cond_destroy(&journal.windowOpened);
+        }
+    }
+
+    if (recovered > 0 || replayed > 0)
+        printf("Recovered %d owners (%ld journal records replayed).\n", ownerCount(), replayed);
+    return true;
+}
+
+void closeJournal(void) {
+    if (journal.fd < 0) return;
+    if (journal.syncThreadRunning) {
+        pthread_mutex_lock(&journal.lock);
+        journal.syncThreadRunning = false;
+        pthread_cond_signal(&journal.windowOpened);
+        pthread_mutex_unlock(&journal.lock);
+        pthread_join(journal.syncThread, NULL);
+        pthread_cond_destroy(&journal.windowOpened);
+    }
+    syncJournal();
+    close(journal.fd);
+    journal.fd = -1;
+    free(journal.snapshotPath);
+    journal.snapshotPath = NULL;
+}
+
+// --------------------------------------------------------------
+// Batch Commands
+// --------------------------------------------------------------
+
+// Split a line into whitespace-separated tokens in place; returns maxTokens + 1 if there are more
+static int splitBatchLine(char *line, char **tokens, int maxTokens) {
+    int count = 0;
+    char *p = line;
+    while (true) {
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+            p++;
+        if (*p == '\0') return count;
+        if (count == maxTokens) return maxTokens + 1;
+        tokens[count++] = p;
+        while (*p && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+            p++;
+        if (*p) *p++ = '\0';
+    }
+}
+
+// Same acceptance rule as readIntSafe: strtol must consume the whole token
+static bool parseBatchInt(const char *token, int *value) {
+    return parseIntView(token, strlen(token), value);
+}
+
+static OwnerNode *findBatchOwner(const char *name) {
+    OwnerNode *owner = findOwnerByName(name);
+    if (owner == NULL)
+        printf("Owner '%s' not found.\n", name);
+    return owner;
+}
+
+static bool batchNew(char **args) {
+    int starterChoice;
+    if (!parseBatchInt(args[1], &starterChoice)) return false;
+    char *name = myStrdup(args[0]);
+    if (name != NULL)
+        createPokedex(name, starterChoice);
+    return true;
+}
+
+static bool batchAdd(char **args) {
+    int id;
+    if (!parseBatchInt(args[1], &id)) return false;
+    OwnerNode *owner = findBatchOwner(args[0]);
+    if (owner != NULL)
+        addPokemonById(owner, id);
+    return true;
+}
+
+static bool batchRelease(char **args) {
+    int id;
+    if (!parseBatchInt(args[1], &id)) return false;
+    OwnerNode *owner = findBatchOwner(args[0]);
+    if (owner != NULL)
+        releasePokemonById(owner, id);
+    return true;
+}
+
+static bool batchEvolve(char **args) {
+    int id;
+    if (!parseBatchInt(args[1], &id)) return false;
+    OwnerNode *owner = findBatchOwner(args[0]);
+    if (owner != NULL)
+        evolvePokemonById(owner, id);
+    return true;
+}
+
+static bool batchFight(char **args) {
+    int firstId, secondId;
+    if (!parseBatchInt(args[1], &firstId) || !parseBatchInt(args[2], &secondId)) return false;
+    OwnerNode *owner = findBatchOwner(args[0]);
+    if (owner != NULL)
+        fightPokemonById(owner, firstId, secondId);
+    return true;
+}
+
+static bool batchFightAll(char **args) {
+    OwnerNode *owner = findBatchOwner(args[0]);
+    if (owner != NULL)
+        fightAllPairs(owner);
+    return true;
+}
+
+static bool batchFightTop(char **args) {
+    int count;
+    if (!parseBatchInt(args[1], &count)) return false;
+    OwnerNode *owner = findBatchOwner(args[0]);
+    if (owner != NULL)
+        fightTopMatchups(owner, count);
+    return true;
+}
+
+static bool batchDisplay(char **args) {
+    // Orders in the display menu's numbering (1..5)
+    static const char *orders[] = { "bfs", "pre", "in", "post", "alpha" };
+    int choice = 0;
+    for (int i = 0; i < 5 && choice == 0; i++) {
+        if (strcmp(args[1], orders[i]) == 0)
+            choice = i + 1;
+    }
+    if (choice == 0) return false;
+    OwnerNode *owner = findBatchOwner(args[0]);
+    if (owner != NULL)
+        displayPokedexOrder(owner, choice);
+    return true;
+}
+
+static bool batchDelete(char **args) {
+    OwnerNode *owner = findBatchOwner(args[0]);
+    if (owner != NULL)
+        deleteOwnerPokedex(owner);
+    return true;
+}
+
+static bool batchMerge(char **args) {
+    if (ownerHead == NULL || ownerHead->next == ownerHead) {
+        printf("Not enough owners to merge.\n");
+        return true;
+    }
+    OwnerNode *first = findBatchOwner(args[0]);
+    if (first == NULL) return true;
+    OwnerNode *second = findBatchOwner(args[1]);
+    if (second != NULL)
+        mergeOwners(first, second, args[1]);
+    return true;
+}
+
+static bool batchSort(char **args) {
+    (void) args;
+    sortOwners();
+    return true;
+}
+
+static bool batchPrint(char **args) {
+    int count;
+    char direction = args[0][0];
+    if (args[0][1] != '\0' || !parseBatchInt(args[1], &count)) return false;
+    if (direction != 'F' && direction != 'f' && direction != 'B' && direction != 'b') {
+        printf("Invalid input.\n");
+        return true;
+    }
+    printOwnersInDirection(direction, count);
+    return true;
+}
+
+static bool batchSave(char **args) {
+    saveOwners(args[0]);
+    return true;
+}
+
+static bool batchLoad(char **args) {
+    loadOwners(args[0]);
+    return true;
+}
+
+// A batch range: "any", "N", "N-M", "N-" (at least N) or "-M" (at most M)
+static bool parseBatchRange(const char *token, int *min, int *max) {
+    *min = INT_MIN;
+    *max = INT_MAX;
+    if (strcmp(token, "any") == 0) return true;
+    const char *dash = strchr(token, '-');
+    if (dash == NULL) {
+        if (!parseBatchInt(token, min)) return false;
+        *max = *min;
+        return true;
+    }
+    if (dash == token && dash[1] == '\0') return false;
+    if (dash > token && !parseIntView(token, (size_t) (dash - token), min)) return false;
+    return dash[1] == '\0' || parseBatchInt(dash + 1, max);
+}
+
+static bool batchQuery(char **args) {
+    static const char *modes[] = { "list", "count", "owners" };
+    static const QueryMode modeValues[] = { QUERY_LIST, QUERY_COUNT, QUERY_OWNERS };
+    int mode = 0;
+    while (mode < 3 && strcmp(args[0], modes[mode]) != 0)
+        mode++;
+    if (mode == 3) return false;
+
+    PokemonFilter filter;
+    initPokemonFilter(&filter);
+    if (strcmp(args[1], "any") != 0) {
+        filter.type = findTypeByName(args[1], strlen(args[1]));
+        if (filter.type < 0) return false;
+    }
+    if (!parseBatchRange(args[2], &filter.hpMin, &filter.hpMax) ||
+        !parseBatchRange(args[3], &filter.attackMin, &filter.attackMax))
+        return false;
+    if (strcmp(args[4], "yes") == 0)
+        filter.canEvolve = CAN_EVOLVE;
+    else if (strcmp(args[4], "no") == 0)
+        filter.canEvolve = CANNOT_EVOLVE;
+    else if (strcmp(args[4], "any") != 0)
+        return false;
+
+    QueryResult result;
+    if (queryPokemon(&filter, modeValues[mode], &result))
+        printQueryResult(&result, modeValues[mode]);
+    freeQueryResult(&result);
+    return true;
+}
+
+static const BatchCommand batchCommands[] = {
+    { "new", 2, batchNew },
+    { "add", 2, batchAdd },
+    { "release", 2, batchRelease },
+    { "evolve", 2, batchEvolve },
+    { "fight", 3, batchFight },
+    { "display", 2, batchDisplay },
+    { "delete", 1, batchDelete },
+    { "merge", 2, batchMerge },
+    { "sort", 0, batchSort },
+    { "print", 2, batchPrint },
+    { "save", 1, batchSave },
+    { "load", 1, batchLoad },
+    { "fightall", 1, batchFightAll },
+    { "fighttop", 2, batchFightTop },
+    { "query", 5, batchQuery },
+};
+
+long runBatchCommands(InputReader *input) {
+    char *line = NULL;
+    size_t lineCapacity = 0;
+    long lineNumber = 0, executed = 0;
+    char *tokens[BATCH_MAX_TOKENS];
+    InputView view;
+
+    while (readInputLine(input, &view)) {
+        lineNumber++;
+
+        // Tokens are cut in place, so copy the line out of the (read-only) input first
+        if (view.length + 1 > lineCapacity) {
+            char *grown = realloc(line, view.length + 1);
+            if (grown == NULL) {
+                printf("Memory allocation failed.\n");
+                break;
+            }
+            line = grown;
+            lineCapacity = view.length + 1;
+        }
+        memcpy(line, view.text, view.length);
+        line[view.length] = '\0';
+        int count = splitBatchLine(line, tokens, BATCH_MAX_TOKENS);
+
+        // Blank lines and '#' comments are skipped
+        if (count == 0 || tokens[0][0] == '#') continue;
+
+        // Find the command and check its argument count before running it
+        const BatchCommand *command = NULL;
+        for (size_t i = 0; i < sizeof(batchCommands) / sizeof(batchCommands[0]); i++) {
+            if (strcmp(tokens[0], batchCommands[i].name) == 0) {
+                command = &batchCommands[i];
+                break;
+            }
+        }
+        if (command == NULL || count - 1 != command->argCount || !command->run(tokens + 1)) {
+            printf("Invalid command on line %ld.\n", lineNumber);
+            continue;
+        }
+        executed++;
+        checkpointJournalIfDue();
+    }
+
+    free(line);
+    return executed;
+}
+
+#ifndef EX6_NO_MAIN
+int main(int argc, char *argv[]) {
+    // Command-line options pick how the Pokedexes are stored and how input is read
+    bool batchMode = false;
+    const char *journalPath = NULL;
+    const char *speciesPath = NULL;
+    for (int i = 1; i < argc; i++) {
+        // Options that take a value read it from the next argument
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        int number;
+        bool numberValue = value != NULL && parseIntView(value, strlen(value), &number);
+        if (strcmp(argv[i], "--bitset") == 0) {
+            bitsetPokedexMode = true;
+        } else if (strcmp(argv[i], "--epoch-reads") == 0) {
+            epochReadsMode = true;
+        } else if (strcmp(argv[i], "--no-node-pool") == 0) {
+            nodePoolsEnabled = false;
+        } else if (strcmp(argv[i], "--fast-exit") == 0) {
+            fastExitMode = true;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            statsOnExit = true;
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            batchMode = true;
+        } else if (strcmp(argv[i], "--journal") == 0 && value != NULL) {
+            journalPath = argv[++i];
+        } else if (strcmp(argv[i], "--species") == 0 && value != NULL) {
+            speciesPath = argv[++i];
+        } else if (strcmp(argv[i], "--journal-sync-ms") == 0 && numberValue) {
+            journal.syncMs = number;
+            i++;
+        } else if (strcmp(argv[i], "--checkpoint-every") == 0 && numberValue && number >= 0) {
+            journal.checkpointEvery = number;
+            i++;
+        } else if (strcmp(argv[i], "--query-threads") == 0 && numberValue && number >= 0) {
+            queryThreads = number;
+            i++;
+        } else {
+            printf("Unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    // The catalog comes first: journal recovery already looks species up
+    if (speciesPath != NULL && !loadSpeciesCatalog(speciesPath))
+        return 1;
+    if (bitsetPokedexMode && speciesCatalog.lastId >= POKEDEX_BIT_WORDS * 64) {
+        printf("--bitset needs species IDs below %d.\n", POKEDEX_BIT_WORDS * 64);
+        freeSpeciesCatalog();
+        return 1;
+    }
+
+    if (journalPath != NULL && !openJournal(journalPath)) {
+        freeAllOwners();
+        freeSpeciesCatalog();
+        return 1;
+    }
+
+    if (batchMode)
+        runBatchCommands(&stdinReader);
+    else
+        mainMenu();
+    flushOutputSink();
+    resetInputReader(&stdinReader);
+    closeJournal();
+    if (fastExitMode)
+        fastExitOwners();
+    else
+        freeAllOwners();
+    freeSpeciesCatalog();
+    if (statsOnExit)
+        printStats(stderr);
+    freeStats();
     return 0;
 }
+#endif
@@ -1,8 +1,10 @@
 #ifndef EX6_H
 #define EX6_H
 
+#include <pthread.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 typedef enum
 {
@@ -39,26 +41,567 @@ typedef struct PokemonData
     EvolutionStatus CAN_EVOLVE;
 } PokemonData;
 
-// Binary Tree Node (for Pokédex)
+// Binary Tree Node (for Pokédex): 48 bytes. Besides its species, each node sums up the
+// subtree rooted here; updateNodeSummary recomputes that whenever the children change
 typedef struct PokemonNode
 {
-    PokemonData *data;
     struct PokemonNode *left;
     struct PokemonNode *right;
+    int64_t hpSum;      // HP of every Pokemon in the subtree
+    int64_t attackSum;  // attack of every Pokemon in the subtree
+    uint32_t species;   // position in speciesCatalog; positions sort like IDs, so it is the BST key
+    uint32_t size;      // nodes in the subtree (a leaf is 1)
+    int32_t maxAttack;  // highest attack in the subtree
+    uint16_t typeMask;  // bit t set: the subtree holds a Pokemon of PokemonType t
+    uint8_t height;     // AVL height of the subtree rooted here (a leaf is 1)
+    bool pooled;        // true if the node lives in a NodePool slab, false if malloc'd
 } PokemonNode;
 
+// Slabs are aligned to their size, so a node finds its slab by masking its address
+#define NODE_SLAB_BYTES 512 // 10 nodes: small Pokedexes waste little
+
+struct NodePool;
+
+// Header at the start of every slab; the nodes follow it
+typedef struct NodeSlab
+{
+    struct NodePool *pool; // pool that currently owns the slab's nodes
+    struct NodeSlab *next; // next slab of the same pool
+} NodeSlab;
+
+// Per-owner node allocator: whole slabs, plus a free list of released nodes
+typedef struct NodePool
+{
+    NodeSlab *slabs;       // newest slab first
+    PokemonNode *freeList; // released nodes, chained through their right pointer
+    int unusedInSlab;      // never-used nodes left at the end of the newest slab
+} NodePool;
+
+#define NODES_PER_SLAB ((int) ((NODE_SLAB_BYTES - sizeof(NodeSlab)) / sizeof(PokemonNode)))
+
+// Whole-Pokédex figures read off a root's subtree fields (summarizePokedex)
+typedef struct
+{
+    int count;
+    int64_t hpSum;
+    int64_t attackSum;
+    int maxAttack;     // 0 for an empty Pokedex
+    uint16_t typeMask; // bit t set: some Pokemon has PokemonType t
+} PokedexSummary;
+
+// Number of species in the built-in pokedex table (IDs 1..SPECIES_COUNT)
+#define SPECIES_COUNT 151
+
+// Species set for the bitset Pokedex mode: bit i is set <=> species ID i is owned
+#define POKEDEX_BIT_WORDS 3 // 192 bits, enough for IDs 1..151 (a loaded catalog must stay below 192)
+
+typedef struct PokedexBits
+{
+    uint64_t words[POKEDEX_BIT_WORDS];
+} PokedexBits;
+
+// A loaded catalog's ID index is a direct-mapped array while its IDs span at most
+// this many times the number of species, and a hash table when they are sparser
+#define SPECIES_DIRECT_SPREAD 4
+
+// Longest species name a loaded catalog may have
+#define SPECIES_NAME_MAX 40
+
+// Catalogs up to this many species sort a Pokedex by name in stack slots, one per name rank
+#define RANK_SLOTS_MAX 1024
+
+// Every species, sorted by ID, with an index from ID to position. Nodes hold a position.
+// The fields scans read are packed columns; the full records (names included) are apart.
+typedef struct SpeciesCatalog
+{
+    const int32_t *ids;
+    const uint8_t *types; // PokemonType
+    const int32_t *hp;
+    const int32_t *attack;
+    const uint8_t *canEvolve; // EvolutionStatus
+    const PokemonData *species; // cold: the records, for menus and messages
+    int count;
+    int firstId;
+    int lastId;
+    int32_t *direct;      // position of ID firstId + i (-1: none); NULL when the IDs are contiguous
+    uint32_t *slots;      // hashed index for sparse IDs: position + 1 (0: empty), linear probing
+    uint32_t slotShift;   // the hash keeps its top 32 - slotShift bits (table size 2^(32 - slotShift))
+    uint32_t *nameRanks;  // alphabetical rank of each position, built on first use
+    uint32_t *byNameRank; // position at each rank
+    PokemonData *loaded;  // the records of a loaded catalog (NULL for the built-in table)
+    char *namePool;       // its names, each distinct name stored once
+    void *columns;        // one block behind its columns
+} SpeciesCatalog;
+
+// Names of a catalog being loaded: a pool of '\0'-terminated names and a hash set over it
+typedef struct SpeciesNamePool
+{
+    char *text;
+    size_t size;
+    size_t capacity;
+    uint32_t *slots; // offset + 1 of a name in text (0: empty), linear probing
+    uint32_t mask;   // table size - 1 (a power of two)
+    uint32_t used;
+} SpeciesNamePool;
+
+// Tree nodes a copy-on-write change replaced, kept until no epoch reader can be on them
+typedef struct RetiredNodes
+{
+    PokemonNode **nodes; // oldest first
+    uint64_t *epochs;    // global epoch at retirement, one per node (never decreasing)
+    int count;
+    int capacity;
+} RetiredNodes;
+
 // Linked List Node (for Owners)
 typedef struct OwnerNode
 {
     char *ownerName;          // Owner's name
     PokemonNode *pokedexRoot; // Pointer to the root of the owner's Pokédex
+    PokedexBits pokedexBits;  // The owner's Pokédex instead of the tree, in bitset mode
+    NodePool nodePool;        // Slabs holding the nodes of pokedexRoot
     struct OwnerNode *next;   // Next owner in the linked list
     struct OwnerNode *prev;   // Previous owner in the linked list
+    pthread_mutex_t lock;     // Guards this owner's Pokédex (and retired)
+    bool retired;             // Claimed for removal (delete / merged away); only its claimer frees it
+    RetiredNodes retiredNodes; // Replaced tree nodes waiting for readers to move on (--epoch-reads)
 } OwnerNode;
 
 // Global head pointer for the linked list of owners
 OwnerNode *ownerHead = NULL;
 
+// Guards the ring, the name index and the registry: read for lookups and Pokédex changes,
+// write for linking, unlinking and sorting owners. Taken before any owner's lock.
+pthread_rwlock_t ownerRingLock = PTHREAD_RWLOCK_INITIALIZER;
+
+// Open-addressing (linear probing) hash index from owner name to OwnerNode
+typedef struct
+{
+    OwnerNode **slots; // NULL marks an empty slot
+    uint32_t *hashes;  // cached name hash of each slot's owner
+    int capacity;      // always a power of two
+    int count;         // number of indexed owners
+    bool outOfSync;    // an insert failed: lookups walk the ring until the next insert or removal rebuilds it
+    uint64_t version;  // odd while a writer changes the table (lets epoch readers skip the lock)
+} OwnerIndex;
+
+// Global name index over every owner in the ring
+OwnerIndex ownerIndex = { NULL, NULL, 0, 0, false, 0 };
+
+// Gap buffer of owners in ring order (position 0 is ownerHead)
+typedef struct
+{
+    OwnerNode **slots; // owners before gapStart, then the gap, then owners from gapEnd on
+    int gapStart;      // first free slot of the gap
+    int gapEnd;        // first used slot after the gap
+    int capacity;      // total number of slots
+    bool outOfSync;    // an insert failed: rebuild from the ring before the next use
+} OwnerRegistry;
+
+// Global positional registry over every owner in the ring
+OwnerRegistry ownerRegistry = { NULL, 0, 0, 0, false };
+
+// When false (--no-node-pool), every PokemonNode is its own malloc
+bool nodePoolsEnabled = true;
+
+// Number of allocations made for PokemonNode memory (single nodes or whole slabs); bumped atomically
+long nodeMallocCount = 0;
+
+// Bump allocator in big chunks, recycling freed blocks per 16-byte size class. The largest
+// class (slabs and names of 497-512 bytes) is slab-aligned, so any of its blocks can be a slab.
+// Build with -DEX6_DEBUG_FREE to turn every arena call into plain malloc/free.
+#define ARENA_CHUNK_BYTES (1 << 20)
+#define ARENA_GRANULE 16
+#define ARENA_SIZE_CLASSES (NODE_SLAB_BYTES / ARENA_GRANULE + 1)
+
+typedef struct ArenaChunk
+{
+    struct ArenaChunk *next; // chunk memory follows this header
+} ArenaChunk;
+
+typedef struct
+{
+    ArenaChunk *chunks;                   // every chunk, newest first
+    char *bump;                           // next unused byte in the newest chunk
+    char *limit;                          // end of the newest chunk
+    void *freeLists[ARENA_SIZE_CLASSES];  // recycled blocks, chained through their first bytes
+    pthread_mutex_t lock;                 // owners allocate slabs in parallel
+} Arena;
+
+// Arena holding every OwnerNode, owner name and Pokedex slab
+Arena ownerArena = { NULL, NULL, NULL, { NULL }, PTHREAD_MUTEX_INITIALIZER };
+
+// When true (--fast-exit), exit drops the arena instead of freeing owner by owner
+bool fastExitMode = false;
+
+// When true (--bitset), every owner keeps its Pokédex in pokedexBits, not a BST
+bool bitsetPokedexMode = false;
+
+// Guards the one sort behind the catalog's nameRanks / byNameRank
+pthread_once_t speciesNameRanksOnce = PTHREAD_ONCE_INIT;
+
+// When true (--epoch-reads), readers take no locks: trees change by path copying and
+// replaced nodes and owners are freed only after every reader has moved on
+bool epochReadsMode = false;
+
+// Threads a cross-owner query may use (--query-threads; 0 picks one per QUERY_OWNERS_PER_THREAD
+// owners, up to the online cores)
+int queryThreads = 0;
+
+// Size of the output sink's buffer (flushed to stdout with write when full)
+#define OUTPUT_SINK_BYTES (1 << 16)
+
+// User-space output buffer for the display functions; printf output still goes to stdout
+typedef struct OutputSink
+{
+    char buffer[OUTPUT_SINK_BYTES];
+    size_t size;
+} OutputSink;
+
+// Per-thread sink behind printPokemonNode and the owner lists (threads don't interleave lines)
+__thread OutputSink outputSink = {{0}, 0};
+
+// Bytes read per chunk when the input can't be memory-mapped (pipes, terminals)
+#define INPUT_CHUNK_BYTES (1 << 16)
+
+// A slice of the input: length bytes at text, not '\0'-terminated
+typedef struct InputView
+{
+    const char *text;
+    size_t length;
+} InputView;
+
+// Whole-input reader: a regular file is mmap'ed once, anything else is read in chunks
+typedef struct InputReader
+{
+    int fd;          // file descriptor read from
+    char *data;      // the mapping, or the chunk buffer
+    size_t size;     // bytes available in data
+    size_t pos;      // next unread byte
+    size_t capacity; // chunk buffer size (unused when mapped)
+    bool mapped;
+    bool opened;     // set up lazily by the first read
+} InputReader;
+
+// Reader behind readIntSafe, getDynamicInput and --batch (fd 0 is stdin)
+InputReader stdinReader = {0, NULL, 0, 0, 0, false, false};
+
+// Snapshot file: header, owner table, every owner's ID array (uint32), then the name pool.
+// Integers are stored in the machine's native byte order.
+#define SNAPSHOT_MAGIC "EX6SNAP1"
+#define SNAPSHOT_VERSION 3
+
+typedef struct SnapshotHeader
+{
+    char magic[8];      // SNAPSHOT_MAGIC, without its '\0'
+    uint32_t version;   // SNAPSHOT_VERSION
+    uint32_t ownerCount;
+    uint64_t idCount;   // IDs in all owners' arrays together
+    uint64_t nameBytes; // size of the name pool ('\0' after every name)
+    uint64_t journalSequence; // last journal record the snapshot includes (0 without --journal)
+} SnapshotHeader;
+
+// One owner in ring order: where its name and its sorted IDs are
+typedef struct SnapshotOwner
+{
+    uint32_t nameOffset; // byte offset in the name pool
+    uint32_t nameLength; // without the '\0'
+    uint32_t idOffset;   // index of its first ID
+    uint32_t idCount;
+} SnapshotOwner;
+
+// Journal file: JOURNAL_MAGIC, then one record per change:
+// u32 payload length, u32 FNV-1a checksum (sequence, op, payload), u64 sequence, u8 op,
+// payload = u32 length + name, u32 length + second name, i32 value
+#define JOURNAL_MAGIC "EX6JRNL1"
+#define JOURNAL_MAGIC_BYTES 8
+
+// Each record is assembled here and written to the journal file in one write
+#define JOURNAL_BUFFER_BYTES (1 << 16)
+
+// The changes the journal records
+typedef enum
+{
+    JOURNAL_NEW = 1, // name, starter choice (1-3)
+    JOURNAL_ADD,     // name, Pokemon ID
+    JOURNAL_RELEASE, // name, Pokemon ID
+    JOURNAL_EVOLVE,  // name, ID before evolving
+    JOURNAL_MERGE,   // first name, second name
+    JOURNAL_DELETE,  // name
+    JOURNAL_SORT
+} JournalOp;
+
+// Write-ahead journal (--journal); fd is -1 when journaling is off
+typedef struct Journal
+{
+    int fd;
+    char *snapshotPath;  // checkpoint file: the journal's path + ".snap"
+    uint64_t sequence;   // sequence number of the last record
+    unsigned char buffer[JOURNAL_BUFFER_BYTES];
+    size_t size;         // bytes waiting in buffer
+    bool unsynced;       // records written since the last fdatasync
+    double oldestUnsynced; // when the first of them was logged (seconds, monotonic)
+    int syncMs;          // group commit window: 0 = fsync every record, < 0 = never
+    long checkpointEvery; // records between checkpoints (0 = never)
+    long sinceCheckpoint;
+    pthread_mutex_t lock; // threads append whole records one at a time
+    pthread_cond_t windowOpened; // wakes the sync thread when a window opens (re-made by openJournal)
+    bool syncThreadRunning;
+    pthread_t syncThread;  // fdatasyncs when a window's time is up, even if nothing else is logged
+} Journal;
+
+Journal journal = {-1, NULL, 0, {0}, 0, false, 0.0, 5, 100000, 0, PTHREAD_MUTEX_INITIALIZER,
+                   PTHREAD_COND_INITIALIZER, false, 0};
+
+// Epoch slots: one per reader thread, so at most this many threads read at once
+#define EPOCH_MAX_THREADS 256
+
+// A retired node or block is freed once the global epoch is this far past its retirement
+#define EPOCH_GRACE 2
+
+// Owners try to free their retired nodes once this many are waiting
+#define EPOCH_RECLAIM_BATCH 16
+
+// One reader thread's announcement, on its own cache line
+typedef struct
+{
+    uint64_t epoch; // global epoch seen on entry, 0 while outside a read section
+    bool claimed;   // taken by a live thread
+    char padding[64 - sizeof(uint64_t) - sizeof(bool)];
+} EpochSlot;
+
+typedef struct
+{
+    uint64_t global;                     // advances once every active reader has seen it
+    int slotsUsed;                       // high-water mark of claimed slots
+    EpochSlot slots[EPOCH_MAX_THREADS];
+} EpochTable;
+
+// Global epoch table (starts at EPOCH_GRACE so a retirement stamp never underflows)
+EpochTable epochTable = { EPOCH_GRACE, 0, {{0}} };
+
+// An owner, or an index array, no longer reachable but maybe still being read
+typedef struct
+{
+    void *block;
+    uint64_t epoch; // global epoch at retirement
+    bool isOwner;   // freeOwnerNode it, else plain free
+} RetiredBlock;
+
+typedef struct
+{
+    RetiredBlock *items; // oldest first
+    int count;
+    int capacity;
+} RetiredBlockList;
+
+// Removed owners and replaced name-index arrays (guarded by ownerRingLock for writing)
+RetiredBlockList retiredBlocks = { NULL, 0, 0 };
+
+// Most nodes one copy-on-write change copies or replaces (an AVL path is under 30 nodes)
+#define COW_MAX_NODES 96
+
+// One path-copying change to an owner's tree, built privately and then published
+typedef struct
+{
+    OwnerNode *owner;
+    PokemonNode *fresh[COW_MAX_NODES];    // copies made by this change, not yet visible
+    int freshCount;
+    PokemonNode *replaced[COW_MAX_NODES]; // published nodes the new tree no longer uses
+    int replacedCount;
+    bool failed;                          // an allocation failed: drop fresh, keep the old tree
+    bool unchanged;                       // the ID was already there (insert) or missing (remove)
+} CowChange;
+
+// Most tokens on one batch line ("query <mode> <type> <hp> <attack> <evolve>")
+#define BATCH_MAX_TOKENS 6
+
+// Runs one batch command on its arguments; false if an argument doesn't parse
+typedef bool (*BatchHandler)(char **args);
+
+// A batch command: its name, exact argument count and handler
+typedef struct BatchCommand
+{
+    const char *name;
+    int argCount;
+    BatchHandler run;
+} BatchCommand;
+
+// A Pokedex laid out for scoring many fights at once: attack and HP side by side
+typedef struct
+{
+    const PokemonData **members; // in ascending ID order
+    int32_t *attack;             // members[i]->attack
+    int32_t *hp;                 // members[i]->hp
+    double *scores;              // attack * 1.5 + hp * 1.2, exactly as pokemonFight computes it
+    int count;
+} FightTable;
+
+// One pair of a FightTable (first < second, so members[first] has the lower ID)
+typedef struct
+{
+    int first;
+    int second;
+    double margin; // winner's score minus loser's (0 for a tie)
+} FightMatchup;
+
+// Room first set aside per fight line piece "<name> (Score = <score>)\n"; longer names
+// or scores grow the buffer
+#define FIGHT_LINE_BYTES 64
+
+// A filter field that matches everything
+#define QUERY_ANY (-1)
+
+// Which Pokemon a query wants (section 24); every condition must hold
+typedef struct
+{
+    int type;      // PokemonType, or QUERY_ANY
+    int hpMin;     // inclusive
+    int hpMax;
+    int attackMin;
+    int attackMax;
+    int canEvolve; // CAN_EVOLVE, CANNOT_EVOLVE or QUERY_ANY
+} PokemonFilter;
+
+// What a query returns
+typedef enum
+{
+    QUERY_LIST,  // every matching (owner, ID) pair
+    QUERY_COUNT, // only the number of matching pairs
+    QUERY_OWNERS // one pair per owner with a match: its lowest matching ID
+} QueryMode;
+
+// One matching Pokemon
+typedef struct
+{
+    OwnerNode *owner;
+    int id;
+} QueryMatch;
+
+// Matches in ring order, ascending IDs within an owner (matches is NULL for QUERY_COUNT)
+typedef struct
+{
+    QueryMatch *matches;
+    long count;
+} QueryResult;
+
+// Owners a query thread claims at a time, owners worth one more thread, and the thread cap
+#define QUERY_CHUNK_OWNERS 16
+#define QUERY_OWNERS_PER_THREAD 64
+#define QUERY_MAX_THREADS 16
+
+// Where one owner's matches landed: a run of one worker's buffer
+typedef struct
+{
+    int worker;
+    long start;
+    long count;
+} QueryOwnerSpan;
+
+// A query in flight, shared by its threads
+typedef struct
+{
+    const PokemonFilter *filter;
+    const uint8_t *speciesMatch; // bit p set: catalog position p passes the filter
+    PokedexBits bitsMatch;       // the same by ID, for --bitset Pokédexes
+    QueryMode mode;
+    OwnerNode **owners;          // ring order
+    int ownerCount;
+    QueryOwnerSpan *spans;       // per owner (NULL for QUERY_COUNT)
+    int nextOwner;               // first owner no thread has claimed yet
+} QueryScan;
+
+// One query thread: the owners it claimed fill its own match buffer
+typedef struct
+{
+    QueryScan *scan;
+    int index;
+    QueryMatch *matches;
+    long count;
+    long capacity;
+    uint64_t nodes;
+    bool failed;
+} QueryWorker;
+
+// Operations the instrumentation counts (section 22)
+typedef enum
+{
+    STAT_SEARCH_BFS,
+    STAT_INSERT,
+    STAT_REMOVE,
+    STAT_MERGE,        // mergeBSTBalanced: merging owners runs it; mergeBST only serves the bench
+    STAT_BFS,
+    STAT_FIND_OWNER,
+    STAT_SORT_OWNERS,
+    STAT_QUERY,
+    // Main menu actions
+    STAT_MENU_NEW,
+    STAT_MENU_EXISTING,
+    STAT_MENU_DELETE,
+    STAT_MENU_MERGE,
+    STAT_MENU_SORT,
+    STAT_MENU_PRINT,
+    STAT_MENU_SAVE,
+    STAT_MENU_LOAD,
+    STAT_MENU_QUERY,
+    // Pokedex menu actions
+    STAT_POKEDEX_ADD,
+    STAT_POKEDEX_DISPLAY,
+    STAT_POKEDEX_RELEASE,
+    STAT_POKEDEX_FIGHT,
+    STAT_POKEDEX_EVOLVE,
+    STAT_OP_COUNT
+} StatOp;
+
+// Latency buckets: bucket b counts calls that took [2^b, 2^(b+1)) ns, the last one anything longer
+#define STAT_BUCKETS 40
+
+// The tree and owner operations time one call in this many (reading the clock costs more
+// than most of them); menu actions time every call
+#define STAT_SAMPLE_EVERY 16
+
+// Counters of one operation
+typedef struct
+{
+    uint64_t calls;
+    uint64_t nodes;       // tree nodes, index slots or owners the calls looked at
+    uint64_t allocations; // allocator calls made during the calls
+    uint64_t timed;       // calls whose latency was measured
+    uint64_t totalNs;     // summed over the timed calls
+    uint64_t buckets[STAT_BUCKETS];
+} OpStats;
+
+// One thread's counters. Only that thread writes them; blocks stay listed after
+// the thread ends so the totals keep its calls
+typedef struct StatsBlock
+{
+    OpStats ops[STAT_OP_COUNT];
+    struct StatsBlock *next;
+} StatsBlock;
+
+// Where an instrumented operation started (STAT_BEGIN)
+typedef struct
+{
+    uint64_t startNs;
+    uint64_t nodes;
+    uint64_t allocations;
+    bool timed;
+} StatSpan;
+
+// Allocator calls made by this thread (malloc/calloc/realloc/posix_memalign in ex6.c)
+__thread uint64_t threadAllocations = 0;
+
+// Nodes looked at by this thread's instrumented operations (STAT_NODES)
+__thread uint64_t threadNodesVisited = 0;
+
+// This thread's counters (created by its first instrumented call) and every thread's
+__thread StatsBlock *threadStats = NULL;
+StatsBlock *statsBlocks = NULL;
+pthread_mutex_t statsLock = PTHREAD_MUTEX_INITIALIZER;
+
+// When true (--stats), the counters are printed to stderr at exit
+bool statsOnExit = false;
+
 /* ------------------------------------------------------------
    1) Safe Input + Utility
    ------------------------------------------------------------ */
@@ -70,6 +613,50 @@ OwnerNode *ownerHead = NULL;
  */
 void trimWhitespace(char *str);
 
+/**
+ * @brief Trim a view by the same rule as trimWhitespace, without touching the bytes.
+ * @param view the view to shrink
+ * Why we made it: Names are trimmed straight in the input buffer.
+ */
+void trimInputView(InputView *view);
+
+/**
+ * @brief Read the next line, or at most limit bytes of it, as a view into the input.
+ * @param reader the InputReader
+ * @param limit most bytes to return; a '\n' within them ends the span and is consumed
+ * @param span receives the bytes (without the '\n'), valid until the next read
+ * @param sawNewline receives true if the span ended at a '\n'
+ * @return false at end of input
+ * Why we made it: Like fgets, but zero-copy and with a SIMD newline scan.
+ */
+bool readInputSpan(InputReader *reader, size_t limit, InputView *span, bool *sawNewline);
+
+/**
+ * @brief Read the next whole line as a view into the input (without its '\n').
+ * @param reader the InputReader
+ * @param line receives the line, valid until the next read
+ * @return false at end of input
+ * Why we made it: getDynamicInput and batch mode read whole lines.
+ */
+bool readInputLine(InputReader *reader, InputView *line);
+
+/**
+ * @brief Unmap or free a reader's input, so the next read starts over on its fd.
+ * @param reader the InputReader
+ * Why we made it: Cleanup at exit, and replaying another script on stdin.
+ */
+void resetInputReader(InputReader *reader);
+
+/**
+ * @brief Parse a base-10 int exactly like strtol plus a "nothing left over" check.
+ * @param text the digits (need not be '\0'-terminated)
+ * @param length number of bytes
+ * @param value receives the value (strtol's clamped result cast to int)
+ * @return true if the whole text was consumed
+ * Why we made it: readIntSafe's rules, parsed straight from the input view.
+ */
+bool parseIntView(const char *text, size_t length, int *value);
+
 /**
  * @brief C99-friendly strdup replacement.
  * @param src source string
@@ -101,6 +688,28 @@ char *getDynamicInput(void);
  */
 const char *getTypeName(PokemonType type);
 
+/**
+ * @brief Write everything in the output sink to stdout (after stdout's own buffer).
+ * Why we made it: One write call per 64 KiB of display output instead of a printf per line.
+ * Sink output must be flushed before the next printf, so displays flush when they finish.
+ */
+void flushOutputSink(void);
+
+/**
+ * @brief Get room for length bytes at the end of the output sink, flushing it if needed.
+ * @param length most bytes the caller will write
+ * @return where to write them, or NULL if length is bigger than the whole buffer
+ * Why we made it: A record is formatted straight into the buffer with one space check.
+ */
+char *reserveOutputSink(size_t length);
+
+/**
+ * @brief Mark the sink as filled up to end (the caller wrote into reserved room).
+ * @param end position after the last byte written
+ * Why we made it: Pairs with reserveOutputSink.
+ */
+void commitOutputSink(const char *end);
+
 /* ------------------------------------------------------------
    2) Creating & Freeing Nodes
    ------------------------------------------------------------ */
@@ -114,8 +723,39 @@ const char *getTypeName(PokemonType type);
 PokemonNode *createPokemonNode(const PokemonData *data);
 
 /**
- * @brief Create an OwnerNode for the circular owners list.
- * @param ownerName the dynamically allocated name
+ * @brief Create a BST node in an owner's node pool (plain malloc if pool is NULL).
+ * @param pool the owner's NodePool, or NULL
+ * @param data pointer to PokemonData (like from the global pokedex)
+ * @return the new node, or NULL if allocation failed
+ * Why we made it: Owner trees churn; recycled slab nodes beat a malloc per node.
+ */
+PokemonNode *allocPokemonNode(NodePool *pool, const PokemonData *data);
+
+/**
+ * @brief Release every slab of a pool at once, without visiting the nodes.
+ * @param pool pointer to NodePool (left empty)
+ * Why we made it: Dropping an owner's whole tree costs one free per slab.
+ */
+void releaseNodePool(NodePool *pool);
+
+/**
+ * @brief Move all of src's slabs and free nodes into dest.
+ * @param dest pool that takes over the slabs
+ * @param src pool that is left empty
+ * Why we made it: After a merge, dest's tree holds nodes from src's slabs.
+ */
+void adoptNodePool(NodePool *dest, NodePool *src);
+
+/**
+ * @brief Free an owner's whole Pokedex tree (pool release or node-by-node).
+ * @param owner pointer to the Owner (pokedexRoot becomes NULL)
+ * Why we made it: Delete, merge and exit all drop entire trees.
+ */
+void freeOwnerPokedex(OwnerNode *owner);
+
+/**
+ * @brief Create an OwnerNode (in the owner arena) for the circular owners list.
+ * @param ownerName the dynamically allocated name, copied into the arena and freed
  * @param starter BST root for the starter Pokemon
  * @return newly allocated OwnerNode*
  * Why we made it: Each user is represented as an OwnerNode.
@@ -123,14 +763,23 @@ PokemonNode *createPokemonNode(const PokemonData *data);
 OwnerNode *createOwner(char *ownerName, PokemonNode *starter);
 
 /**
- * @brief Free one PokemonNode (including name).
- * @param node pointer to node
+ * @brief Create an empty OwnerNode (in the owner arena) with a copy of the given name.
+ * @param name the name's bytes (need not be '\0'-terminated)
+ * @param nameLength number of bytes
+ * @return newly allocated OwnerNode*, or NULL
+ * Why we made it: Loading a snapshot copies names straight from the mapped file.
+ */
+OwnerNode *createOwnerWithName(const char *name, size_t nameLength);
+
+/**
+ * @brief Free one PokemonNode (its data points into the static pokedex and is kept).
+ * @param node pointer to node (pooled nodes go back on their pool's free list)
  * Why we made it: Avoid memory leaks for single nodes.
  */
 void freePokemonNode(PokemonNode *node);
 
 /**
- * @brief Recursively free a BST of PokemonNodes.
+ * @brief Free a BST of PokemonNodes (post-order TreeCursor walk).
  * @param root BST root
  * Why we made it: Clearing a user’s entire Pokedex means freeing a tree.
  */
@@ -148,25 +797,124 @@ void freeOwnerNode(OwnerNode *owner);
    ------------------------------------------------------------ */
 
 /**
- * @brief Insert a PokemonNode into BST by ID; duplicates freed.
+ * @brief Insert a PokemonNode into the AVL tree by ID; duplicates freed.
  * @param root pointer to BST root
  * @param newNode node to insert
  * @return updated BST root
- * Why we made it: Standard BST insertion ignoring duplicates.
+ * Why we made it: O(log n) insertion even when IDs arrive in sorted order.
  */
 PokemonNode *insertPokemonNode(PokemonNode *root, PokemonNode *newNode);
 
+/**
+ * @brief Return the AVL height stored in a node (0 for NULL).
+ * @param node pointer to node (may be NULL)
+ * @return height of the subtree rooted at node
+ * Why we made it: Balance checks must treat empty subtrees as height 0.
+ */
+int nodeHeight(const PokemonNode *node);
+
+/**
+ * @brief Recompute a node's height, size and subtree sums from its species and children.
+ * @param node pointer to node (children already up to date)
+ * Why we made it: Every insert, remove and rotation changes what a subtree holds.
+ */
+void updateNodeSummary(PokemonNode *node);
+
+/**
+ * @brief Rotate a subtree left (right child becomes the new root).
+ * @param root subtree root
+ * @return new subtree root
+ * Why we made it: Basic AVL rotation used by rebalanceNode.
+ */
+PokemonNode *rotateLeft(PokemonNode *root);
+
+/**
+ * @brief Rotate a subtree right (left child becomes the new root).
+ * @param root subtree root
+ * @return new subtree root
+ * Why we made it: Basic AVL rotation used by rebalanceNode.
+ */
+PokemonNode *rotateRight(PokemonNode *root);
+
+/**
+ * @brief Restore the AVL property at one node after its children changed.
+ * @param root subtree root whose children are already balanced
+ * @return new subtree root
+ * Why we made it: Sorted inserts would otherwise turn the Pokedex into a list.
+ */
+PokemonNode *rebalanceNode(PokemonNode *root);
+
+/**
+ * @brief Whole-Pokédex figures straight from the root: count, HP and attack sums,
+ * highest attack and the types present.
+ * @param root BST root (may be NULL)
+ * @param summary filled in (all zero for an empty tree)
+ * Why we made it: O(1) instead of a walk over every node.
+ */
+void summarizePokedex(const PokemonNode *root, PokedexSummary *summary);
+
+/**
+ * @brief The Pokemon with the k-th smallest ID (k = 0 is the smallest).
+ * @param root BST root
+ * @param k rank, 0..size-1
+ * @return the node, or NULL if k is out of range
+ * Why we made it: Subtree sizes find it in O(log n), without an in-order walk.
+ */
+PokemonNode *selectPokemonByRank(PokemonNode *root, int k);
+
+/**
+ * @brief Count the Pokemon of one type.
+ * @param root BST root
+ * @param type the type
+ * @return how many nodes have that type
+ * Why we made it: Subtrees whose typeMask lacks the type are skipped whole, so an
+ * absent type costs O(1) and a rare one only the paths down to its nodes.
+ */
+int countPokemonOfType(const PokemonNode *root, PokemonType type);
+
+/**
+ * @brief Merge two Pokedex trees into one perfectly balanced tree in O(n + m).
+ * @param firstRoot root of the tree that keeps its nodes
+ * @param secondRoot root of the tree merged in; its nodes are reused or freed
+ * @return root of the merged tree (secondRoot must not be used afterwards)
+ * Why we made it: Flatten both in order, merge without duplicates, rebuild,
+ * instead of copying and inserting every node of the second tree.
+ */
+PokemonNode *mergeBSTBalanced(PokemonNode *firstRoot, PokemonNode *secondRoot);
+
 /**
  * @brief BFS search for a Pokemon by ID in the BST.
  * @param root BST root
  * @param id ID to find
  * @return pointer to found node or NULL
  * Why we made it: BFS ensures we find nodes even in an unbalanced tree.
+ * It visits every node, so the menus use searchPokemonBST instead.
  */
 PokemonNode *searchPokemonBFS(PokemonNode *root, int id);
 
 /**
- * @brief Remove node from BST by ID if found (BST removal logic).
+ * @brief Iterative search for a Pokemon by ID, following the BST ordering.
+ * @param root BST root
+ * @param id ID to find
+ * @return pointer to found node or NULL
+ * Why we made it: One O(log n) descent instead of scanning every node.
+ */
+PokemonNode *searchPokemonBST(PokemonNode *root, int id);
+
+/**
+ * @brief Find the node for data->id, inserting a new node for it if missing.
+ * @param root BST root
+ * @param data species to look up (like from the global pokedex)
+ * @param pool node pool for a new node (NULL for plain malloc)
+ * @param found receives the node holding data->id (NULL if allocation failed)
+ * @param inserted receives true if a new node was created
+ * @return updated BST root
+ * Why we made it: Add and evolve need "check then insert" in a single descent.
+ */
+PokemonNode *lookupOrInsertPokemon(PokemonNode *root, const PokemonData *data, NodePool *pool, PokemonNode **found, bool *inserted);
+
+/**
+ * @brief Remove node from the AVL tree by ID if found, rebalancing on the way up.
  * @param root BST root
  * @param id ID to remove
  * @return updated BST root
@@ -175,11 +923,11 @@ PokemonNode *searchPokemonBFS(PokemonNode *root, int id);
 PokemonNode *removeNodeBST(PokemonNode *root, int id);
 
 /**
- * @brief Combine BFS search + BST removal to remove Pokemon by ID.
+ * @brief Combine keyed search + BST removal to remove Pokemon by ID.
  * @param root BST root
  * @param id the ID to remove
  * @return updated BST root
- * Why we made it: BFS confirms existence, then removeNodeBST does the removal.
+ * Why we made it: The search confirms existence, then removeNodeBST does the removal.
  */
 PokemonNode *removePokemonByID(PokemonNode *root, int id);
 
@@ -194,9 +942,9 @@ typedef void (*VisitNodeFunc)(PokemonNode *);
 
 
 /**
- * @brief Go through the owners list and count how many owners there are, and print their names if needed
+ * @brief Get how many owners there are, and print their names if needed
  * @param: isPrintOwners if true, print the owners' names
- * @return the amount of owners
+ * @return the amount of owners (from the registry, no ring walk)
  * why we made it: we need to know how many owners there are
  */
 int getOwnerAmount(bool isPrintOwners);
@@ -214,7 +962,7 @@ void visitPokemonByLevel(PokemonNode *root, int level, VisitNodeFunc visit);
 /**
  * @brief Return the maximum height of the BST (farthest leaf to root).
  * @param root BST root
- * @return height of the tree
+ * @return height of the tree, read from the AVL height in O(1)
  * Why we made it: We need to know how many levels to visit in BFS.
  */
 int BFSTreeHeight(PokemonNode *root);
@@ -228,6 +976,77 @@ int BFSTreeHeight(PokemonNode *root);
  */
 void BFSGeneric(PokemonNode *root, VisitNodeFunc visit);
 
+// Ring-buffer FIFO of node pointers used by the level-order traversals.
+typedef struct
+{
+    PokemonNode **items;
+    int head;     // index of the oldest queued node
+    int count;    // number of queued nodes
+    int capacity; // always a power of two, so indices wrap with a mask
+} NodeQueue;
+
+// Receives one whole BFS level: nodes[0..count-1], level counted from 1.
+typedef void (*VisitLevelFunc)(PokemonNode **nodes, int count, int level);
+
+/**
+ * @brief Initialize an empty NodeQueue (capacity rounded up to a power of two).
+ * @param queue pointer to NodeQueue
+ * @param cap initial capacity
+ * Why we made it: A queue can be kept and reused across many traversals.
+ */
+void initNodeQueue(NodeQueue *queue, int cap);
+
+/**
+ * @brief Append a node at the tail of the queue, doubling the ring if full.
+ * @param queue pointer to NodeQueue
+ * @param node pointer to the node
+ * @return true on success, false if growing the ring failed
+ * Why we made it: BFS pushes children while it pops parents.
+ */
+bool enqueueNode(NodeQueue *queue, PokemonNode *node);
+
+/**
+ * @brief Pop the node at the head of the queue.
+ * @param queue pointer to a non-empty NodeQueue
+ * @return the oldest queued node
+ * Why we made it: BFS visits nodes in the order they were queued.
+ */
+PokemonNode *dequeueNode(NodeQueue *queue);
+
+/**
+ * @brief Rotate the ring so the queued nodes start at items[0].
+ * @param queue pointer to NodeQueue
+ * @return items, now holding the queued nodes contiguously
+ * Why we made it: The batched traversal hands out a whole level as one array.
+ */
+PokemonNode **linearizeNodeQueue(NodeQueue *queue);
+
+/**
+ * @brief Release the queue's ring buffer.
+ * @param queue pointer to NodeQueue
+ * Why we made it: Reusable queues are freed by whoever owns them.
+ */
+void freeNodeQueue(NodeQueue *queue);
+
+/**
+ * @brief Level-order traversal on a caller-owned queue (no per-level re-descent).
+ * @param root BST root
+ * @param visit function pointer for what to do with each node
+ * @param queue queue to reuse; its contents are discarded
+ * Why we made it: One O(n) pass, and repeated traversals skip the allocation.
+ */
+void BFSGenericQueue(PokemonNode *root, VisitNodeFunc visit, NodeQueue *queue);
+
+/**
+ * @brief Level-order traversal that hands visit() one whole level at a time.
+ * @param root BST root
+ * @param visit function pointer called once per level
+ * @param queue queue to reuse; its contents are discarded
+ * Why we made it: Per-level work (batch printing, width stats) without per-node calls.
+ */
+void BFSLevelsGeneric(PokemonNode *root, VisitLevelFunc visit, NodeQueue *queue);
+
+// The three depth-first walks run on a TreeCursor (below), so tree depth never costs C stack
 /**
  * @brief A generic pre-order traversal (Root-Left-Right).
  * @param root BST root
@@ -252,10 +1071,76 @@ void inOrderGeneric(PokemonNode *root, VisitNodeFunc visit);
  */
 void postOrderGeneric(PokemonNode *root, VisitNodeFunc visit);
 
+// Orders a TreeCursor can walk in
+typedef enum
+{
+    TRAVERSE_PRE,  // Root-Left-Right
+    TRAVERSE_IN,   // Left-Root-Right (ascending IDs)
+    TRAVERSE_POST  // Left-Right-Root
+} TraversalOrder;
+
+// Path depth a cursor holds without allocating (an AVL tree of any real size fits)
+#define CURSOR_INLINE_DEPTH 64
+
+// Explicit-stack walk over a BST, one node per treeCursorNext. Don't copy a cursor:
+// stack may point at its own inlineStack.
+typedef struct
+{
+    TraversalOrder order;
+    PokemonNode **stack;    // ancestors still to finish (inlineStack until the path gets deeper)
+    int depth;
+    int capacity;
+    PokemonNode *current;   // in/post-order: subtree to descend into next
+    PokemonNode *last;      // post-order: the node returned last
+    bool failed;            // growing the stack failed; the walk ended early
+    PokemonNode *inlineStack[CURSOR_INLINE_DEPTH];
+} TreeCursor;
+
+// Visitor with caller context; return false to stop the walk
+typedef bool (*VisitNodeCtxFunc)(PokemonNode *node, void *ctx);
+
+/**
+ * @brief Start a walk over the tree under root.
+ * @param cursor cursor to set up (free it with treeCursorFree)
+ * @param root BST root (may be NULL)
+ * @param order pre-, in- or post-order
+ * Why we made it: The recursive walks use one C stack frame per level and
+ * overflow on a degenerate tree; the cursor keeps its path on the heap.
+ */
+void treeCursorInit(TreeCursor *cursor, PokemonNode *root, TraversalOrder order);
+
+/**
+ * @brief Advance the cursor.
+ * @param cursor cursor from treeCursorInit
+ * @return the next node in the cursor's order, or NULL at the end
+ * In post-order the node returned may be freed before the next call.
+ * Why we made it: Callers can stop anywhere, or interleave two walks.
+ */
+PokemonNode *treeCursorNext(TreeCursor *cursor);
+
+/**
+ * @brief Release a cursor's stack (needed only if it outgrew inlineStack).
+ * @param cursor cursor from treeCursorInit
+ * Why we made it: Pairs with treeCursorInit; safe to call on any cursor.
+ */
+void treeCursorFree(TreeCursor *cursor);
+
+/**
+ * @brief Walk the tree in order, calling visit(node, ctx) until it returns false.
+ * @param root BST root
+ * @param order pre-, in- or post-order
+ * @param visit visitor
+ * @param ctx passed to every visit call
+ * @return true if every node was visited, false if visit stopped the walk (or the stack failed)
+ * Why we made it: Aggregations (counts, sums, searches) keep their state in ctx, not globals.
+ */
+bool traverseTree(PokemonNode *root, TraversalOrder order, VisitNodeCtxFunc visit, void *ctx);
+
 /**
  * @brief Print one PokemonNode’s data: ID, Name, Type, HP, Attack, Evolve?
  * @param node pointer to the node
  * Why we made it: We can pass this to BFSGeneric or others to quickly print.
+ * The line goes into the output sink; call flushOutputSink when done printing.
  */
 void printPokemonNode(PokemonNode *node);
 
@@ -287,13 +1172,29 @@ void initNodeArray(NodeArray *na, int cap);
 void addNode(NodeArray *na, PokemonNode *node);
 
 /**
- * @brief Recursively collect all nodes from the BST into a NodeArray.
+ * @brief Collect all nodes from the BST into a NodeArray (pre-order).
  * @param root BST root
  * @param na pointer to NodeArray
  * Why we made it: We gather everything for qsort.
  */
 void collectAll(PokemonNode *root, NodeArray *na);
 
+/**
+ * @brief Count the nodes of a BST (the root's subtree size, no walk).
+ * @param root BST root
+ * @return number of nodes
+ * Why we made it: Arrays for flattening a tree can be sized exactly up front.
+ */
+int countPokemonNodes(PokemonNode *root);
+
+/**
+ * @brief Collect all nodes of the BST into a NodeArray in ascending ID order.
+ * @param root BST root
+ * @param na pointer to NodeArray
+ * Why we made it: A sorted node list lets merges and rebuilds run in linear time.
+ */
+void collectInOrder(PokemonNode *root, NodeArray *na);
+
 /**
  * @brief Compare function for qsort (alphabetical by node->data->name).
  * @param a pointer to a pointer to PokemonNode
@@ -313,9 +1214,18 @@ int compareByNameNode(const void *a, const void *b);
 int compareOwnerNames(const void *a, const void *b);
 
 /**
- * @brief BFS is nice, but alphabetical means we gather all nodes, sort by name, then print.
+ * @brief Fill the catalog's nameRanks / byNameRank (sorts the names on the first call only).
+ * Why we made it: Species names are static, so one sort serves every alphabetical display.
+ */
+void initSpeciesNameRanks(void);
+
+/**
+ * @brief Print the tree sorted by name: each node goes into the slot of its species'
+ * name rank, then the filled slots print in rank order. Catalogs with more than
+ * RANK_SLOTS_MAX species sort the nodes by rank instead.
  * @param root BST root
- * Why we made it: Provide user the option to see Pokemon sorted by name.
+ * Why we made it: Provide user the option to see Pokemon sorted by name, in O(n)
+ * with no string compares or reallocs per call.
  */
 void displayAlphabetical(PokemonNode *root);
 
@@ -359,19 +1269,47 @@ void postOrderTraversal(PokemonNode *root);
 void pokemonFight(OwnerNode *owner);
 
 /**
- * @brief Evolve a Pokemon (ID -> ID+1) if allowed.
+ * @brief Fight two Pokemon of the owner's Pokedex, given their IDs.
+ * @param owner pointer to the Owner
+ * @param firstId ID of the first Pokemon
+ * @param secondId ID of the second Pokemon
+ * Locks the owner for the call; an owner retired by another thread is reported as not found.
+ * Why we made it: The fight itself, shared by the menu and batch mode.
+ */
+void fightPokemonById(OwnerNode *owner, int firstId, int secondId);
+
+/**
+ * @brief Evolve a Pokemon (ID -> ID+1) if allowed.
  * @param owner pointer to the Owner
  * Why we made it: Demonstrates removing an old ID, inserting the next ID.
  */
 void evolvePokemon(OwnerNode *owner);
 
 /**
- * @brief Prompt for an ID, BFS-check duplicates, then insert into BST.
+ * @brief Evolve the Pokemon with the given ID (ID -> ID+1) if allowed.
+ * @param owner pointer to the Owner
+ * @param id ID of the Pokemon to evolve
+ * Locks the owner for the call; an owner retired by another thread is reported as not found.
+ * Why we made it: The evolution itself, shared by the menu and batch mode.
+ */
+void evolvePokemonById(OwnerNode *owner, int id);
+
+/**
+ * @brief Prompt for an ID, then insert into BST unless it is already there.
  * @param owner pointer to the Owner
  * Why we made it: Primary user function for adding new Pokemon to an owner’s Pokedex.
  */
 void addPokemon(OwnerNode *owner);
 
+/**
+ * @brief Insert the Pokemon with the given ID unless it is already there.
+ * @param owner pointer to the Owner
+ * @param pokemonId ID to add (validated against the pokedex range)
+ * Locks the owner for the call; an owner retired by another thread is reported as not found.
+ * Why we made it: The insert itself, shared by the menu and batch mode.
+ */
+void addPokemonById(OwnerNode *owner, int pokemonId);
+
 /**
  * @brief Prompt for ID, remove that Pokemon from BST by ID.
  * @param owner pointer to the Owner
@@ -379,6 +1317,15 @@ void addPokemon(OwnerNode *owner);
  */
 void freePokemon(OwnerNode *owner);
 
+/**
+ * @brief Release the Pokemon with the given ID.
+ * @param owner pointer to the Owner
+ * @param id ID to release
+ * Locks the owner for the call; an owner retired by another thread is reported as not found.
+ * Why we made it: The release itself, shared by the menu and batch mode.
+ */
+void releasePokemonById(OwnerNode *owner, int id);
+
 /* ------------------------------------------------------------
    7) Display Menu for a Pokedex
    ------------------------------------------------------------ */
@@ -390,6 +1337,15 @@ void freePokemon(OwnerNode *owner);
  */
 void displayMenu(OwnerNode *owner);
 
+/**
+ * @brief Display the owner's Pokedex in one order of the display menu.
+ * @param owner pointer to Owner
+ * @param choice 1 BFS, 2 Pre, 3 In, 4 Post, 5 Alphabetical
+ * Locks the owner for the call; an owner retired by another thread is reported as not found.
+ * Why we made it: The display itself, shared by the menu and batch mode.
+ */
+void displayPokedexOrder(OwnerNode *owner, int choice);
+
 /* ------------------------------------------------------------
    8) Sorting Owners (Bubble Sort on Circular List)
    ------------------------------------------------------------ */
@@ -415,25 +1371,123 @@ void swapOwnerData(OwnerNode *a, OwnerNode *b);
 /**
  * @brief Insert a new owner into the circular list. If none exist, it's alone.
  * @param newOwner pointer to newly created OwnerNode
+ * Takes ownerRingLock for writing.
  * Why we made it: We need a standard approach to keep the list circular.
  */
 void linkOwnerInCircularList(OwnerNode *newOwner);
 
+/**
+ * @brief linkOwnerInCircularList for a caller already holding ownerRingLock for writing.
+ * @param newOwner pointer to newly created OwnerNode
+ * Why we made it: A name check and the link it guards must happen under one lock.
+ */
+void linkOwnerLocked(OwnerNode *newOwner);
+
 /**
  * @brief Remove a specific OwnerNode from the circular list, possibly updating head.
- * @param target pointer to the OwnerNode
+ * @param target pointer to the OwnerNode (retired by the caller when threads share the owners)
+ * Takes ownerRingLock for writing, so it waits for every thread still using an owner.
  * Why we made it: Deleting or merging owners requires removing them from the ring.
  */
 void removeOwnerFromCircularList(OwnerNode *target);
 
 /**
- * @brief Find an owner by name in the circular list.
+ * @brief Find an owner by name (through the hash index).
  * @param name string to match
  * @return pointer to the matching OwnerNode or NULL
  * Why we made it: We often need to locate an owner quickly.
  */
 OwnerNode *findOwnerByName(const char *name);
 
+/**
+ * @brief Hash an owner name (32-bit FNV-1a).
+ * @param name the name
+ * @return its hash
+ * Why we made it: The name index compares hashes before any strcmp.
+ */
+uint32_t hashOwnerName(const char *name);
+
+/**
+ * @brief Add an owner to the global name index, growing it when 70% full.
+ * @param owner pointer to the OwnerNode (its name must not be indexed yet)
+ * Why we made it: Keeps findOwnerByName O(1) as owners are linked in.
+ */
+void ownerIndexInsert(OwnerNode *owner);
+
+/**
+ * @brief Look up an owner by name in the global name index.
+ * @param name string to match
+ * @return pointer to the matching OwnerNode or NULL
+ * Why we made it: Expected O(1) lookups, full strcmp only on a hash match.
+ */
+OwnerNode *ownerIndexFind(const char *name);
+
+/**
+ * @brief Remove an owner from the global name index (backward-shift delete).
+ * @param owner pointer to the OwnerNode
+ * Why we made it: Owners leave the index when they leave the ring.
+ */
+void ownerIndexRemove(OwnerNode *owner);
+
+/**
+ * @brief Free the global name index and reset it to empty.
+ * Why we made it: Part of a squeaky-clean exit.
+ */
+void freeOwnerIndex(void);
+
+/**
+ * @brief Make sure the registry matches the ring, rebuilding it if needed.
+ * @return true if the registry can be used, false if the rebuild failed
+ * Why we made it: The ring is the source of truth; the registry is an index over it.
+ */
+bool ownerRegistryReady(void);
+
+/**
+ * @brief Number of owners in the ring.
+ * @return the count, O(1) from the registry
+ * Why we made it: Menus validate positions without walking the ring.
+ */
+int ownerCount(void);
+
+/**
+ * @brief Select the owner at a 0-based position in ring order from ownerHead.
+ * @param position 0 <= position < ownerCount()
+ * @return pointer to the OwnerNode
+ * Why we made it: O(1) select-by-number for the Pokedex menus.
+ */
+OwnerNode *ownerAtPosition(int position);
+
+/**
+ * @brief Insert an owner into the registry at a 0-based position.
+ * @param position 0 <= position <= ownerCount()
+ * @param owner pointer to the OwnerNode
+ * @return false if growing the buffer failed (the registry is then out of sync)
+ * Why we made it: New owners are appended at the ring's tail.
+ */
+bool ownerRegistryInsert(int position, OwnerNode *owner);
+
+/**
+ * @brief Remove and return the owner at a 0-based position in the registry.
+ * @param position 0 <= position < ownerCount()
+ * @return the removed OwnerNode (still linked in the ring)
+ * Why we made it: Moving the gap there makes nearby removals cheap.
+ */
+OwnerNode *ownerRegistryRemoveAt(int position);
+
+/**
+ * @brief Find the 0-based position of an owner in the registry.
+ * @param owner pointer to the OwnerNode
+ * @return its position, or -1 if it isn't registered
+ * Why we made it: Removing an owner found by name needs its position.
+ */
+int ownerRegistryPositionOf(const OwnerNode *owner);
+
+/**
+ * @brief Free the global registry and reset it to empty.
+ * Why we made it: Part of a squeaky-clean exit.
+ */
+void freeOwnerRegistry(void);
+
 /* ------------------------------------------------------------
    10) Owner Menus
    ------------------------------------------------------------ */
@@ -450,18 +1504,43 @@ void enterExistingPokedexMenu(void);
  */
 void openPokedexMenu(void);
 
+/**
+ * @brief Create a Pokedex for a new owner with starter 1, 2 or 3.
+ * @param name malloc'd owner name (always taken over: moved into the owner or freed)
+ * @param starterChoice 1 Bulbasaur, 2 Charmander, 3 Squirtle
+ * Why we made it: The creation itself, shared by the menu and batch mode.
+ */
+void createPokedex(char *name, int starterChoice);
+
 /**
  * @brief Delete an entire Pokedex (owner) from the list.
  * Why we made it: Let user pick which Pokedex to remove and free everything.
  */
 void deletePokedex(void);
 
+/**
+ * @brief Delete one owner's Pokedex, printing progress like the menu.
+ * @param owner pointer to the Owner (retired, then freed)
+ * Why we made it: Batch mode deletes by name instead of by number.
+ */
+void deleteOwnerPokedex(OwnerNode *owner);
+
 /**
  * @brief Merge the second owner's Pokedex into the first, then remove the second owner.
  * Why we made it: BFS copy demonstration plus removing an owner.
  */
 void mergePokedexMenu(void);
 
+/**
+ * @brief Merge the second owner's Pokedex into the first, then remove the second owner.
+ * @param first owner that keeps the merged Pokedex
+ * @param second owner merged in and freed (must differ from first)
+ * @param secondName name to report (the second owner's own name is freed with it)
+ * Locks both owners in address order, retires the second, then unlinks it under the write lock.
+ * Why we made it: The merge itself, shared by the menu and batch mode.
+ */
+void mergeOwners(OwnerNode *first, OwnerNode *second, const char *secondName);
+
 /* ------------------------------------------------------------
    11) Printing Owners in a Circle
    ------------------------------------------------------------ */
@@ -472,6 +1551,14 @@ void mergePokedexMenu(void);
  */
 void printOwnersCircular(void);
 
+/**
+ * @brief Print count owners starting at head, going forward (F/f) or backward.
+ * @param directionChr 'F'/'f' for next, anything else for prev
+ * @param count number of prints
+ * Why we made it: The walk itself, shared by the menu and batch mode.
+ */
+void printOwnersInDirection(char directionChr, int count);
+
 /* ------------------------------------------------------------
    12) Cleanup All Owners at Program End
    ------------------------------------------------------------ */
@@ -482,6 +1569,13 @@ void printOwnersCircular(void);
  */
 void freeAllOwners(void);
 
+/**
+ * @brief Drop every owner at once by releasing the whole owner arena.
+ * Why we made it: O(chunks) teardown for huge registries (--fast-exit).
+ * In an EX6_DEBUG_FREE build it frees owner by owner, like freeAllOwners.
+ */
+void fastExitOwners(void);
+
 /* ------------------------------------------------------------
    13) The Main Menu
    ------------------------------------------------------------ */
@@ -492,158 +1586,876 @@ void freeAllOwners(void);
  */
 void mainMenu(void);
 
+/* ------------------------------------------------------------
+   13b) Owner Arena
+   ------------------------------------------------------------ */
+
+/**
+ * @brief Allocate a block from an arena (reusing a freed block of its size class).
+ * @param arena pointer to the Arena
+ * @param size bytes needed; NODE_SLAB_BYTES blocks come back slab-aligned
+ * @return the block, or NULL if a new chunk couldn't be allocated
+ * Thread-safe: the arena's mutex is held for the call.
+ * Why we made it: Owners, names and slabs without a malloc each.
+ */
+void *arenaAlloc(Arena *arena, size_t size);
+
+/**
+ * @brief Give a block back to its arena's size-class free list.
+ * @param arena pointer to the Arena
+ * @param block the block (NULL is ignored)
+ * @param size the size it was allocated with
+ * Why we made it: Deleted owners' memory is reused by the next ones.
+ */
+void arenaFree(Arena *arena, void *block, size_t size);
+
+/**
+ * @brief Free every chunk of an arena at once, invalidating all its blocks.
+ * @param arena pointer to the Arena (left empty)
+ * Why we made it: Teardown in O(chunks) instead of O(blocks).
+ */
+void releaseArena(Arena *arena);
+
+/* ------------------------------------------------------------
+   14) Bitset Pokedex (fixed species ID range)
+   ------------------------------------------------------------ */
+
+/**
+ * @brief Check whether a species ID is in the set.
+ * @param bits pointer to the set
+ * @param id species ID
+ * @return true if present
+ * Why we made it: O(1) membership instead of a tree descent.
+ */
+bool pokedexBitsContains(const PokedexBits *bits, int id);
+
+/**
+ * @brief Add a species ID to the set.
+ * @param bits pointer to the set
+ * @param id species ID
+ * @return true if it was newly added, false if it was already there
+ * Why we made it: O(1) insert with the duplicate check built in.
+ */
+bool pokedexBitsAdd(PokedexBits *bits, int id);
+
+/**
+ * @brief Remove a species ID from the set.
+ * @param bits pointer to the set
+ * @param id species ID
+ * @return true if it was there
+ * Why we made it: O(1) release.
+ */
+bool pokedexBitsRemove(PokedexBits *bits, int id);
+
+/**
+ * @brief Merge src into dest with a word-wise OR.
+ * @param dest set that receives the union
+ * @param src set to merge in
+ * Why we made it: Merging two bitset Pokedexes is a handful of ORs.
+ */
+void pokedexBitsMerge(PokedexBits *dest, const PokedexBits *src);
+
+/**
+ * @brief Count the species in the set with popcount.
+ * @param bits pointer to the set
+ * @return number of set bits
+ * Why we made it: Sizing arrays and reports without a scan.
+ */
+int pokedexBitsCount(const PokedexBits *bits);
+
+/**
+ * @brief Find the smallest species ID >= from that is in the set (ctz scan).
+ * @param bits pointer to the set
+ * @param from first ID to consider
+ * @return the ID, or -1 if there is none
+ * Why we made it: Ordered iteration skips empty words in one step.
+ */
+int pokedexBitsNext(const PokedexBits *bits, int from);
+
+/**
+ * @brief Visit every species in the set in ascending ID order.
+ * @param bits pointer to the set
+ * @param visit function pointer, called with a temporary node per species
+ * Why we made it: In-order display straight from the bits, no tree needed.
+ */
+void inOrderBitsGeneric(const PokedexBits *bits, VisitNodeFunc visit);
+
+/**
+ * @brief Print the species in the set sorted by name (walks the name ranks, testing bits).
+ * @param bits pointer to the set
+ * Why we made it: Alphabetical display without building a temporary tree.
+ */
+void displayAlphabeticalBits(const PokedexBits *bits);
+
+/**
+ * @brief Link already sorted nodes into a perfectly balanced BST.
+ * @param nodes nodes sorted by ID (their child links are overwritten)
+ * @param count number of nodes
+ * @return root of the new tree
+ * Why we made it: Building from sorted data is O(n), with no rebalancing.
+ */
+PokemonNode *buildBalancedTree(PokemonNode **nodes, int count);
+
+/**
+ * @brief Build a temporary balanced BST holding the species in the set.
+ * @param bits pointer to the set
+ * @return root of the new tree (free with freePokemonTree)
+ * Why we made it: BFS/Pre/Post/Alphabetical displays work on trees.
+ */
+PokemonNode *pokedexBitsToTree(const PokedexBits *bits);
+
+/* ------------------------------------------------------------
+   15) Owner Pokedex (tree or bitset, same calls for both)
+   ------------------------------------------------------------ */
+
+/**
+ * @brief Check whether the owner's Pokedex is empty.
+ * @param owner pointer to the Owner
+ * @return true if it holds no Pokemon
+ * Why we made it: Menus shouldn't care which representation is in use.
+ */
+bool isPokedexEmpty(const OwnerNode *owner);
+
+/**
+ * @brief Find a Pokemon by ID in the owner's Pokedex.
+ * @param owner pointer to the Owner
+ * @param id ID to find
+ * @return the species data, or NULL if the owner doesn't have it
+ * Why we made it: Fight, evolve and release only need the species data.
+ */
+const PokemonData *findOwnerPokemon(OwnerNode *owner, int id);
+
+/**
+ * @brief Add a species to the owner's Pokedex unless it is already there.
+ * @param owner pointer to the Owner
+ * @param data species to add (like from the global pokedex)
+ * @param inserted receives true if it was newly added
+ * @return false if memory allocation failed
+ * Why we made it: One call for the duplicate check and the insert.
+ */
+bool ownerAddPokemon(OwnerNode *owner, const PokemonData *data, bool *inserted);
+
+/**
+ * @brief Remove a species from the owner's Pokedex if present.
+ * @param owner pointer to the Owner
+ * @param id ID to remove
+ * Why we made it: Release and evolve both drop an ID.
+ */
+void ownerRemovePokemon(OwnerNode *owner, int id);
+
+/**
+ * @brief Move every Pokemon of src into dest's Pokedex.
+ * @param dest owner that keeps the merged Pokedex
+ * @param src owner whose Pokedex is merged in (emptied, left for the caller to free)
+ * Why we made it: Merge menu works the same in tree and bitset mode.
+ */
+void mergeOwnerPokedex(OwnerNode *dest, OwnerNode *src);
+
+/* ------------------------------------------------------------
+   16) Snapshots (save / load every owner)
+   ------------------------------------------------------------ */
+
+/**
+ * @brief Save every owner (ring order) and Pokedex to a binary snapshot file.
+ * @param path file to write (written to path.tmp, then renamed)
+ * @return number of owners saved, or -1 on error
+ * Why we made it: Owners survive a restart without replaying menu input.
+ */
+int saveOwners(const char *path);
+
+/**
+ * @brief Write every owner to a snapshot file, silently.
+ * @param path file to write (written to path.tmp, synced, then renamed)
+ * @return number of owners written, or -1 on error
+ * Why we made it: Shared by saveOwners and the journal's checkpoints.
+ */
+int writeSnapshot(const char *path);
+
+/**
+ * @brief Replace every owner with the ones in a snapshot file.
+ * @param path file to load (mmap'ed and fully checked before anything changes)
+ * @return number of owners loaded, or -1 if the file can't be used
+ * Why we made it: O(n) restore: sorted IDs become balanced trees without rebalancing.
+ */
+int loadOwners(const char *path);
+
+/**
+ * @brief Replace every owner with the ones in a snapshot file, silently.
+ * @param path file to read
+ * @param journalSequence receives the last journal record the snapshot includes
+ * @return number of owners loaded, or -1 if the file can't be used
+ * Why we made it: Shared by loadOwners and journal recovery.
+ */
+int readSnapshot(const char *path, uint64_t *journalSequence);
+
+/**
+ * @brief Prompt for a file name and save every owner to it.
+ * Why we made it: Main menu entry for saveOwners.
+ */
+void saveOwnersMenu(void);
+
+/**
+ * @brief Prompt for a file name and load the owners saved in it.
+ * Why we made it: Main menu entry for loadOwners.
+ */
+void loadOwnersMenu(void);
+
+/* ------------------------------------------------------------
+   17) Journal (--journal)
+   ------------------------------------------------------------ */
+
+/**
+ * @brief Recover from a journal (checkpoint + newer records), then keep logging to it.
+ * @param path journal file (created if missing); its checkpoint is path.snap
+ * @return true if the journal is open and the owners are recovered
+ * Why we made it: A crash loses at most the records inside the group commit window.
+ */
+bool openJournal(const char *path);
+
+/**
+ * @brief Log one change (after it succeeded): write it to the file, fdatasync it when the sync window closes.
+ * @param op the change
+ * @param name owner it applies to (NULL for sort)
+ * @param otherName second owner (merge only, else NULL)
+ * @param value starter choice or Pokemon ID (0 when unused)
+ * Why we made it: One fdatasync covers every record in the sync window (group commit).
+ */
+void journalRecord(JournalOp op, const char *name, const char *otherName, int value);
+
+/**
+ * @brief fdatasync the records written since the last sync.
+ * Why we made it: Closes the group commit window early (exit, checkpoint).
+ */
+void syncJournal(void);
+
+/**
+ * @brief Checkpoint once checkpointEvery records were logged since the last one.
+ * Why we made it: Menus and --batch call it between commands, when every change is whole.
+ */
+void checkpointJournalIfDue(void);
+
+/**
+ * @brief Save a snapshot of every owner and empty the journal.
+ * Why we made it: Keeps replay time bounded by checkpointEvery records.
+ */
+void checkpointJournal(void);
+
+/**
+ * @brief Stop the sync thread, sync and close the journal.
+ * Why we made it: Every record logged before exit is on disk.
+ */
+void closeJournal(void);
+
+/**
+ * @brief Sort the owners ring by name, silently (takes ownerRingLock for writing).
+ * @return false if the registry could not be allocated
+ * Why we made it: Shared by sortOwners and journal replay.
+ */
+bool sortOwnerRing(void);
+
+/**
+ * @brief sortOwnerRing for a caller already holding ownerRingLock for writing.
+ * @return false if the registry could not be allocated
+ * Why we made it: sortOwners logs the sort under the same lock, in ring order.
+ */
+bool sortOwnerRingLocked(void);
+
+/* ------------------------------------------------------------
+   18) Batch Commands (--batch)
+   ------------------------------------------------------------ */
+
+/**
+ * @brief Run a compact command stream, one command per line, without prompts or menus.
+ * @param input reader to read (stdinReader in --batch mode)
+ * @return number of commands that ran (invalid lines are reported and skipped)
+ * Commands (owner names are single words, '#' starts a comment line):
+ *   new <owner> <1-3>        add <owner> <id>        release <owner> <id>
+ *   evolve <owner> <id>      fight <owner> <id> <id> delete <owner>
+ *   display <owner> <bfs|pre|in|post|alpha>          merge <owner> <owner>
+ *   sort                     print <F|B> <count>
+ *   save <file>              load <file>
+ *   fightall <owner>         fighttop <owner> <count>
+ *   query <list|count|owners> <type|any> <hp> <attack> <yes|no|any>
+ *     (hp and attack: any, N, N-M, N- or -M)
+ * Why we made it: Scripted workloads print only results, not prompts and menus.
+ */
+long runBatchCommands(InputReader *input);
+
+/* ------------------------------------------------------------
+   19) Owner Locks (threads sharing the owners)
+   ------------------------------------------------------------
+   Lock order: ownerRingLock, then owner locks (lower address first), then the arena's
+   or the journal's mutex. An OwnerNode pointer stays valid while its thread holds
+   ownerRingLock (read or write), after it retired the owner itself, or inside an epoch
+   read section (section 20). The menus and --batch run on one thread; ring changes
+   (new, delete, merge, sort, save, load) are called without ownerRingLock held,
+   Pokédex changes with at least the read lock. */
+
+/**
+ * @brief Take ownerRingLock for reading (lookups, Pokédex changes).
+ * Why we made it: Any number of threads use owners at once; removals wait for them.
+ */
+void readLockOwners(void);
+
+/**
+ * @brief Take ownerRingLock for writing (link, unlink, sort, snapshots).
+ * Why we made it: Ring changes need every other thread out of the owners.
+ */
+void writeLockOwners(void);
+
+/**
+ * @brief Release ownerRingLock (read or write).
+ * Why we made it: One release for both lock modes.
+ */
+void unlockOwners(void);
+
+/**
+ * @brief Lock one owner's Pokédex.
+ * @param owner pointer to the Owner
+ * Why we made it: Changes to different owners don't wait for each other.
+ */
+void lockOwner(OwnerNode *owner);
+
+/**
+ * @brief Unlock one owner's Pokédex.
+ * @param owner pointer to the Owner
+ * Why we made it: Pairs with lockOwner.
+ */
+void unlockOwner(OwnerNode *owner);
+
+/**
+ * @brief Lock an owner unless another thread retired it.
+ * @param owner pointer to the Owner
+ * @return true with the owner locked; false (and "not found" printed) if it was retired
+ * Why we made it: Entry check of every Pokédex command.
+ */
+bool lockLiveOwner(OwnerNode *owner);
+
+/**
+ * @brief Lock two owners, lower address first (once if they are the same owner).
+ * @param first pointer to one Owner
+ * @param second pointer to the other Owner
+ * Why we made it: Two merges of the same owners in opposite order can't deadlock.
+ */
+void lockOwnerPair(OwnerNode *first, OwnerNode *second);
+
+/**
+ * @brief Unlock two owners locked by lockOwnerPair.
+ * @param first pointer to one Owner
+ * @param second pointer to the other Owner
+ * Why we made it: Pairs with lockOwnerPair.
+ */
+void unlockOwnerPair(OwnerNode *first, OwnerNode *second);
+
+/**
+ * @brief Claim an owner for removal.
+ * @param owner pointer to the Owner
+ * @return true if this call retired it, false if another thread already had
+ * Why we made it: Exactly one thread frees an owner, even when two delete it at once.
+ */
+bool retireOwner(OwnerNode *owner);
+
+/* ------------------------------------------------------------
+   20) Epoch Reads (--epoch-reads: lock-free readers)
+   ------------------------------------------------------------
+   Readers announce the global epoch in their slot (epochEnter) and then read trees,
+   the name index and owners with no lock. Writers still lock as in section 19, but
+   never change a published node: they copy the path, publish the new root with one
+   atomic store and retire what it replaced. Anything retired at epoch e is freed once
+   the global epoch reaches e + EPOCH_GRACE, which it can't while a reader from e remains.
+   An OwnerNode pointer found inside a read section stays valid until epochExit. */
+
+/**
+ * @brief Enter a read section (nests; the outermost call announces the epoch).
+ * Why we made it: Pins everything a reader can reach, without taking any lock.
+ */
+void epochEnter(void);
+
+/**
+ * @brief Leave a read section (the outermost call clears the announcement).
+ * Why we made it: Pairs with epochEnter; lets the epoch move on.
+ */
+void epochExit(void);
+
+/**
+ * @brief Advance the global epoch if every reader inside a section has seen it.
+ * @return the global epoch after the attempt
+ * Why we made it: Writers call it before freeing, so retired memory ages out.
+ */
+uint64_t epochAdvance(void);
+
+/**
+ * @brief Queue a removed owner or a replaced name-index array for freeing.
+ * @param block the OwnerNode or array
+ * @param isOwner true for an OwnerNode (freed with freeOwnerNode), false for plain free
+ * Why we made it: Unlinking and freeing are one step without epoch readers; here they split.
+ * Call with ownerRingLock held for writing.
+ */
+void retireBlock(void *block, bool isOwner);
+
+/**
+ * @brief Free retired owners and index arrays whose grace period is over.
+ * @param all free everything regardless of epochs (no reader may be left)
+ * Why we made it: Removed owners can't be freed while a reader may hold them.
+ * Call with ownerRingLock held for writing (or with a single thread left).
+ */
+void reclaimRetiredBlocks(bool all);
+
+/**
+ * @brief Free an owner's retired tree nodes whose grace period is over.
+ * @param owner pointer to the Owner (locked by the caller)
+ * @param all free every retired node regardless of epochs
+ * Why we made it: Path copying replaces nodes on every change; they must go back to the pool.
+ */
+void reclaimOwnerNodes(OwnerNode *owner, bool all);
+
+/**
+ * @brief Find an owner by name without ownerRingLock (inside epochEnter/epochExit).
+ * @param name the owner's name
+ * @return the live owner, or NULL
+ * Why we made it: The index is read optimistically and re-read if a writer changed it.
+ */
+OwnerNode *findOwnerByNameEpoch(const char *name);
+
+/**
+ * @brief Add a Pokemon by path copying, then publish the new root.
+ * @param owner pointer to the Owner (locked by the caller)
+ * @param data species to add
+ * @param inserted set to true if it was not there before
+ * @return false if an allocation failed (the tree is unchanged)
+ * Why we made it: Readers walking the old tree never see a half-done rotation.
+ */
+bool cowAddPokemon(OwnerNode *owner, const PokemonData *data, bool *inserted);
+
+/**
+ * @brief Remove a Pokemon by path copying, then publish the new root.
+ * @param owner pointer to the Owner (locked by the caller)
+ * @param id ID to remove (absent IDs leave the tree alone)
+ * Why we made it: Same as cowAddPokemon, for releases and evolutions.
+ */
+void cowRemovePokemon(OwnerNode *owner, int id);
+
+/**
+ * @brief Merge src's tree into dest as a freshly built balanced tree.
+ * @param dest pointer to the Owner keeping the Pokédex (locked by the caller)
+ * @param src pointer to the Owner merged away (locked by the caller; its tree is untouched)
+ * Why we made it: Relinking src's nodes would change trees under readers.
+ */
+void cowMergePokedex(OwnerNode *dest, OwnerNode *src);
+
+/* ------------------------------------------------------------
+   21) Batch Fights (every pair of one Pokédex at once)
+   ------------------------------------------------------------ */
+
+/**
+ * @brief Gather an owner's Pokédex into a FightTable and score every member.
+ * @param owner pointer to the Owner (read section or lock held by the caller)
+ * @param table filled in; free it with freeFightTable
+ * @return false if an allocation failed (nothing to free then)
+ * Why we made it: The score kernel wants attack and HP in plain arrays, not tree nodes.
+ */
+bool buildFightTable(OwnerNode *owner, FightTable *table);
+
+/**
+ * @brief Free the arrays of a FightTable.
+ * @param table table filled by buildFightTable
+ * Why we made it: Pairs with buildFightTable.
+ */
+void freeFightTable(FightTable *table);
+
+/**
+ * @brief scores[i] = attack[i] * 1.5 + hp[i] * 1.2, four (AVX2) or two (SSE2) at a time.
+ * @param attack attack values
+ * @param hp HP values
+ * @param scores output, count entries
+ * @param count number of Pokemon
+ * Why we made it: Each score is computed once, not once per fight it appears in.
+ * The vector lanes do the same double multiplies and add as the scalar formula.
+ */
+void computeFightScores(const int32_t *attack, const int32_t *hp, double *scores, int count);
+
+/**
+ * @brief Outcome of member first against every later member.
+ * @param scores the table's scores
+ * @param count number of members
+ * @param first index of the first fighter
+ * @param outcomes outcomes[j] for j > first: 1 first wins, -1 j wins, 0 tie
+ * Why we made it: One vector compare decides four (or two) fights.
+ */
+void compareFightScores(const double *scores, int count, int first, signed char *outcomes);
+
+/**
+ * @brief The n most one-sided fights of a table (largest score gap first).
+ * @param table scored table
+ * @param n how many to return
+ * @param matchups output, room for n
+ * @return number returned (less than n when the table has fewer pairs)
+ * Why we made it: Top-N reports without sorting every pair.
+ */
+int topFightMatchups(const FightTable *table, int n, FightMatchup *matchups);
+
+/**
+ * @brief Print every fight between two of an owner's Pokemon, lower ID first.
+ * @param owner pointer to the Owner
+ * Each fight prints exactly what pokemonFight prints for the same two IDs.
+ * Why we made it: "Who beats whom" reports over a whole Pokédex.
+ */
+void fightAllPairs(OwnerNode *owner);
+
+/**
+ * @brief Print an owner's n most one-sided fights, in pokemonFight's format.
+ * @param owner pointer to the Owner
+ * @param n number of fights (ties in gap go to the lower IDs first)
+ * Why we made it: Top-N matchups without printing every pair.
+ */
+void fightTopMatchups(OwnerNode *owner, int n);
+
+/* ------------------------------------------------------------
+   22) Instrumentation (per-operation counters and latency histograms)
+   ------------------------------------------------------------ */
+
+// An instrumented function opens with STAT_BEGIN(op, span) and closes with STAT_END(op, span);
+// STAT_NODES adds to the node count. Building with -DEX6_NO_STATS compiles all of it out.
+#ifdef EX6_NO_STATS
+#define STAT_BEGIN(op, span)
+#define STAT_END(op, span) ((void) 0)
+#define STAT_NODES(count) ((void) (count))
+#else
+#define STAT_BEGIN(op, span) StatSpan span; statBegin((op), &span)
+#define STAT_END(op, span) statEnd((op), &span)
+#define STAT_NODES(count) (threadNodesVisited += (uint64_t) (count))
+#endif
+
+/**
+ * @brief Record the start of an operation: this thread's node and allocation counts, and
+ * the clock when this call is one of the timed ones.
+ * @param op the operation (STAT_OP_COUNT: an uncounted menu choice)
+ * @param span filled in
+ * Why we made it: statEnd charges the operation with what happened since.
+ */
+void statBegin(StatOp op, StatSpan *span);
+
+/**
+ * @brief Count one call of op: nodes and allocations since statBegin, and its latency bucket if timed.
+ * @param op the operation
+ * @param span from statBegin
+ * Why we made it: Thread-local counters, so recording takes no lock or atomic add.
+ */
+void statEnd(StatOp op, const StatSpan *span);
+
+/**
+ * @brief Print every counted operation: calls, average and percentile latency, nodes and
+ * allocations per call, and the latency histogram (summed over all threads).
+ * @param out stdout for the Stats menu, stderr for --stats
+ * Why we made it: See where the time goes without a profiler.
+ */
+void printStats(FILE *out);
+
+/**
+ * @brief Free every thread's counters.
+ * Why we made it: Called once at exit, after the last instrumented call.
+ */
+void freeStats(void);
+
+/* ------------------------------------------------------------
+   23) Species Catalog (built-in table or loaded from a file)
+   ------------------------------------------------------------ */
+
+/**
+ * @brief Look a species up by ID through the catalog's index.
+ * @param id species ID
+ * @return the species, or NULL if the catalog has no such ID
+ * Why we made it: Catalog IDs can be sparse, so an ID is no longer an array position.
+ */
+const PokemonData *findSpecies(int id);
+
+/**
+ * @brief Position of a species in the catalog (its records and columns) by ID.
+ * @param id species ID
+ * @return the position, or -1 if the catalog has no such ID
+ * Why we made it: Trees are keyed by position, so a lookup turns the ID into one first.
+ */
+int findSpeciesPosition(int id);
+
+/**
+ * @brief The species offered as starter choice 1, 2 or 3: the 1st, 4th or 7th species
+ * of the catalog (IDs 1, 4 and 7 of the built-in table).
+ * @param choice 1..3
+ * @return the species, or NULL for any other choice or a catalog too short to have it
+ * Why we made it: The starter menu, batch "new" and the journal share one rule.
+ */
+const PokemonData *starterSpecies(int choice);
+
+/**
+ * @brief Replace the catalog with one read from a CSV file, one species per line:
+ * "id,name,TYPE,hp,attack,canEvolve" (TYPE as printed, e.g. GRASS; canEvolve 0 or 1).
+ * Blank lines and lines starting with '#' are skipped; IDs may come in any order.
+ * @param path catalog file
+ * @return false (and the old catalog kept) on a bad line, duplicate ID or failed allocation
+ * Why we made it: Catalogs with many thousands of sparse IDs, without recompiling.
+ * Call it at startup, before any owner exists: nodes point into the catalog.
+ */
+bool loadSpeciesCatalog(const char *path);
+
+/**
+ * @brief Make records already in memory the catalog (index and columns are built for them).
+ * @param species records sorted by ID, IDs distinct; the caller keeps them alive
+ * @param count number of records (at least 1)
+ * @return false (and the old catalog kept) if they aren't sorted or an allocation failed
+ * Why we made it: Benchmarks and tools build catalogs without writing a file.
+ * Like loadSpeciesCatalog, only while no owner or tree exists.
+ */
+bool useSpeciesRecords(const PokemonData *species, int count);
+
+/**
+ * @brief Free a loaded catalog (and the name ranks) and go back to the built-in table.
+ * Why we made it: Called once at exit; no node may point into the catalog any more.
+ */
+void freeSpeciesCatalog(void);
+
+/* ------------------------------------------------------------
+   24) Pokemon Queries (filters across every owner)
+   ------------------------------------------------------------
+   A query first marks the catalog positions that pass the filter, a vector compare over
+   the species columns, so the owner scan tests one bit per Pokemon. Owners are handed
+   out QUERY_CHUNK_OWNERS at a time to up to queryThreads threads; each owner is read
+   under its lock (or in an epoch read section) while the query holds ownerRingLock. */
+
+/**
+ * @brief A filter that matches every Pokemon (narrow it field by field).
+ * @param filter filter to set up
+ * Why we made it: Callers set only the conditions they care about.
+ */
+void initPokemonFilter(PokemonFilter *filter);
+
+/**
+ * @brief Test one species against a filter.
+ * @param filter the filter
+ * @param data the species
+ * @return true if every condition holds
+ * Why we made it: The scalar rule the column scan must agree with.
+ */
+bool pokemonMatchesFilter(const PokemonFilter *filter, const PokemonData *data);
+
+/**
+ * @brief Mark the catalog positions whose species pass the filter.
+ * @param filter the filter
+ * @param bitmap output, (speciesCatalog.count + 7) / 8 bytes; bit p is position p
+ * @return number of matching species
+ * Why we made it: Eight (AVX2) or four (SSE2) species per compare, straight from the
+ * columns, instead of one record per Pokemon in every owner's tree.
+ */
+int markMatchingSpecies(const PokemonFilter *filter, uint8_t *bitmap);
+
+/**
+ * @brief Find the Pokemon passing the filter across every owner.
+ * @param filter the filter
+ * @param mode list, count or one match per owner
+ * @param result filled in; free it with freeQueryResult
+ * @return false (and result empty) if an allocation failed
+ * Why we made it: "Every FIRE Pokemon with attack above 90" without walking the
+ * owners by hand. Call without ownerRingLock held; the owners in result stay valid
+ * under the section 19 rules (until the next ring change on a single thread).
+ */
+bool queryPokemon(const PokemonFilter *filter, QueryMode mode, QueryResult *result);
+
+/**
+ * @brief Free the matches of a query result.
+ * @param result result from queryPokemon
+ * Why we made it: Pairs with queryPokemon.
+ */
+void freeQueryResult(QueryResult *result);
+
+/**
+ * @brief Print a query result: each match grouped under its owner, the count, or one line per owner.
+ * @param result result from queryPokemon
+ * @param mode the mode it was run with
+ * Why we made it: The menu item and the batch command print the same way.
+ */
+void printQueryResult(const QueryResult *result, QueryMode mode);
+
+/**
+ * @brief Main menu: read a filter and an output mode, then run the query.
+ * Why we made it: Cross-owner questions from the menu.
+ */
+void queryPokemonMenu(void);
+
+// The built-in species: SPECIES(id, name, type, hp, attack, canEvolve) for each one
+#define BUILTIN_SPECIES(SPECIES) \
+    SPECIES(1, "Bulbasaur", GRASS, 45, 49, CAN_EVOLVE) \
+    SPECIES(2, "Ivysaur", GRASS, 60, 62, CAN_EVOLVE) \
+    SPECIES(3, "Venusaur", GRASS, 80, 82, CANNOT_EVOLVE) \
+    SPECIES(4, "Charmander", FIRE, 39, 52, CAN_EVOLVE) \
+    SPECIES(5, "Charmeleon", FIRE, 58, 64, CAN_EVOLVE) \
+    SPECIES(6, "Charizard", FIRE, 78, 84, CANNOT_EVOLVE) \
+    SPECIES(7, "Squirtle", WATER, 44, 48, CAN_EVOLVE) \
+    SPECIES(8, "Wartortle", WATER, 59, 63, CAN_EVOLVE) \
+    SPECIES(9, "Blastoise", WATER, 79, 83, CANNOT_EVOLVE) \
+    SPECIES(10, "Caterpie", BUG, 45, 30, CAN_EVOLVE) \
+    SPECIES(11, "Metapod", BUG, 50, 20, CAN_EVOLVE) \
+    SPECIES(12, "Butterfree", BUG, 60, 45, CANNOT_EVOLVE) \
+    SPECIES(13, "Weedle", BUG, 40, 35, CAN_EVOLVE) \
+    SPECIES(14, "Kakuna", BUG, 45, 25, CAN_EVOLVE) \
+    SPECIES(15, "Beedrill", BUG, 65, 90, CANNOT_EVOLVE) \
+    SPECIES(16, "Pidgey", NORMAL, 40, 45, CAN_EVOLVE) \
+    SPECIES(17, "Pidgeotto", NORMAL, 63, 60, CAN_EVOLVE) \
+    SPECIES(18, "Pidgeot", NORMAL, 83, 80, CANNOT_EVOLVE) \
+    SPECIES(19, "Rattata", NORMAL, 30, 56, CAN_EVOLVE) \
+    SPECIES(20, "Raticate", NORMAL, 55, 81, CANNOT_EVOLVE) \
+    SPECIES(21, "Spearow", NORMAL, 40, 60, CAN_EVOLVE) \
+    SPECIES(22, "Fearow", NORMAL, 65, 90, CANNOT_EVOLVE) \
+    SPECIES(23, "Ekans", POISON, 35, 60, CAN_EVOLVE) \
+    SPECIES(24, "Arbok", POISON, 60, 85, CANNOT_EVOLVE) \
+    SPECIES(25, "Pikachu", ELECTRIC, 35, 55, CAN_EVOLVE) \
+    SPECIES(26, "Raichu", ELECTRIC, 60, 90, CANNOT_EVOLVE) \
+    SPECIES(27, "Sandshrew", GROUND, 50, 75, CAN_EVOLVE) \
+    SPECIES(28, "Sandslash", GROUND, 75, 100, CANNOT_EVOLVE) \
+    SPECIES(29, "NidoranF", POISON, 55, 47, CAN_EVOLVE) \
+    SPECIES(30, "Nidorina", POISON, 70, 62, CAN_EVOLVE) \
+    SPECIES(31, "Nidoqueen", POISON, 90, 92, CANNOT_EVOLVE) \
+    SPECIES(32, "NidoranM", POISON, 46, 57, CAN_EVOLVE) \
+    SPECIES(33, "Nidorino", POISON, 61, 72, CAN_EVOLVE) \
+    SPECIES(34, "Nidoking", POISON, 81, 102, CANNOT_EVOLVE) \
+    SPECIES(35, "Clefairy", FAIRY, 70, 45, CAN_EVOLVE) \
+    SPECIES(36, "Clefable", FAIRY, 95, 70, CANNOT_EVOLVE) \
+    SPECIES(37, "Vulpix", FIRE, 38, 41, CAN_EVOLVE) \
+    SPECIES(38, "Ninetales", FIRE, 73, 76, CANNOT_EVOLVE) \
+    SPECIES(39, "Jigglypuff", NORMAL, 115, 45, CAN_EVOLVE) \
+    SPECIES(40, "Wigglytuff", NORMAL, 140, 70, CANNOT_EVOLVE) \
+    SPECIES(41, "Zubat", POISON, 40, 45, CAN_EVOLVE) \
+    SPECIES(42, "Golbat", POISON, 75, 80, CAN_EVOLVE) \
+    SPECIES(43, "Oddish", GRASS, 45, 50, CAN_EVOLVE) \
+    SPECIES(44, "Gloom", GRASS, 60, 65, CAN_EVOLVE) \
+    SPECIES(45, "Vileplume", GRASS, 75, 80, CANNOT_EVOLVE) \
+    SPECIES(46, "Paras", BUG, 35, 70, CAN_EVOLVE) \
+    SPECIES(47, "Parasect", BUG, 60, 95, CANNOT_EVOLVE) \
+    SPECIES(48, "Venonat", BUG, 60, 55, CAN_EVOLVE) \
+    SPECIES(49, "Venomoth", BUG, 70, 65, CANNOT_EVOLVE) \
+    SPECIES(50, "Diglett", GROUND, 10, 55, CAN_EVOLVE) \
+    SPECIES(51, "Dugtrio", GROUND, 35, 80, CANNOT_EVOLVE) \
+    SPECIES(52, "Meowth", NORMAL, 40, 45, CAN_EVOLVE) \
+    SPECIES(53, "Persian", NORMAL, 65, 70, CANNOT_EVOLVE) \
+    SPECIES(54, "Psyduck", WATER, 50, 52, CAN_EVOLVE) \
+    SPECIES(55, "Golduck", WATER, 80, 82, CANNOT_EVOLVE) \
+    SPECIES(56, "Mankey", FIGHTING, 40, 80, CAN_EVOLVE) \
+    SPECIES(57, "Primeape", FIGHTING, 65, 105, CANNOT_EVOLVE) \
+    SPECIES(58, "Growlithe", FIRE, 55, 70, CAN_EVOLVE) \
+    SPECIES(59, "Arcanine", FIRE, 90, 110, CANNOT_EVOLVE) \
+    SPECIES(60, "Poliwag", WATER, 40, 50, CAN_EVOLVE) \
+    SPECIES(61, "Poliwhirl", WATER, 65, 65, CAN_EVOLVE) \
+    SPECIES(62, "Poliwrath", WATER, 90, 95, CANNOT_EVOLVE) \
+    SPECIES(63, "Abra", PSYCHIC, 25, 20, CAN_EVOLVE) \
+    SPECIES(64, "Kadabra", PSYCHIC, 40, 35, CAN_EVOLVE) \
+    SPECIES(65, "Alakazam", PSYCHIC, 55, 50, CANNOT_EVOLVE) \
+    SPECIES(66, "Machop", FIGHTING, 70, 80, CAN_EVOLVE) \
+    SPECIES(67, "Machoke", FIGHTING, 80, 100, CAN_EVOLVE) \
+    SPECIES(68, "Machamp", FIGHTING, 90, 130, CANNOT_EVOLVE) \
+    SPECIES(69, "Bellsprout", GRASS, 50, 75, CAN_EVOLVE) \
+    SPECIES(70, "Weepinbell", GRASS, 65, 90, CAN_EVOLVE) \
+    SPECIES(71, "Victreebel", GRASS, 80, 105, CANNOT_EVOLVE) \
+    SPECIES(72, "Tentacool", WATER, 40, 40, CAN_EVOLVE) \
+    SPECIES(73, "Tentacruel", WATER, 80, 70, CANNOT_EVOLVE) \
+    SPECIES(74, "Geodude", ROCK, 40, 80, CAN_EVOLVE) \
+    SPECIES(75, "Graveler", ROCK, 55, 95, CAN_EVOLVE) \
+    SPECIES(76, "Golem", ROCK, 80, 120, CANNOT_EVOLVE) \
+    SPECIES(77, "Ponyta", FIRE, 50, 85, CAN_EVOLVE) \
+    SPECIES(78, "Rapidash", FIRE, 65, 100, CANNOT_EVOLVE) \
+    SPECIES(79, "Slowpoke", WATER, 90, 65, CAN_EVOLVE) \
+    SPECIES(80, "Slowbro", WATER, 95, 75, CANNOT_EVOLVE) \
+    SPECIES(81, "Magnemite", ELECTRIC, 25, 35, CAN_EVOLVE) \
+    SPECIES(82, "Magneton", ELECTRIC, 50, 60, CANNOT_EVOLVE) \
+    SPECIES(83, "Farfetch'd", NORMAL, 52, 65, CANNOT_EVOLVE) \
+    SPECIES(84, "Doduo", NORMAL, 35, 85, CAN_EVOLVE) \
+    SPECIES(85, "Dodrio", NORMAL, 60, 110, CANNOT_EVOLVE) \
+    SPECIES(86, "Seel", WATER, 65, 45, CAN_EVOLVE) \
+    SPECIES(87, "Dewgong", WATER, 90, 70, CANNOT_EVOLVE) \
+    SPECIES(88, "Grimer", POISON, 80, 80, CAN_EVOLVE) \
+    SPECIES(89, "Muk", POISON, 105, 105, CANNOT_EVOLVE) \
+    SPECIES(90, "Shellder", WATER, 30, 65, CAN_EVOLVE) \
+    SPECIES(91, "Cloyster", WATER, 50, 95, CANNOT_EVOLVE) \
+    SPECIES(92, "Gastly", GHOST, 30, 35, CAN_EVOLVE) \
+    SPECIES(93, "Haunter", GHOST, 45, 50, CAN_EVOLVE) \
+    SPECIES(94, "Gengar", GHOST, 60, 65, CANNOT_EVOLVE) \
+    SPECIES(95, "Onix", ROCK, 35, 45, CANNOT_EVOLVE) \
+    SPECIES(96, "Drowzee", PSYCHIC, 60, 48, CAN_EVOLVE) \
+    SPECIES(97, "Hypno", PSYCHIC, 85, 73, CANNOT_EVOLVE) \
+    SPECIES(98, "Krabby", WATER, 30, 105, CAN_EVOLVE) \
+    SPECIES(99, "Kingler", WATER, 55, 130, CANNOT_EVOLVE) \
+    SPECIES(100, "Voltorb", ELECTRIC, 40, 30, CAN_EVOLVE) \
+    SPECIES(101, "Electrode", ELECTRIC, 60, 50, CANNOT_EVOLVE) \
+    SPECIES(102, "Exeggcute", GRASS, 60, 40, CAN_EVOLVE) \
+    SPECIES(103, "Exeggutor", GRASS, 95, 95, CANNOT_EVOLVE) \
+    SPECIES(104, "Cubone", GROUND, 50, 50, CAN_EVOLVE) \
+    SPECIES(105, "Marowak", GROUND, 60, 80, CANNOT_EVOLVE) \
+    SPECIES(106, "Hitmonlee", FIGHTING, 50, 120, CANNOT_EVOLVE) \
+    SPECIES(107, "Hitmonchan", FIGHTING, 50, 105, CANNOT_EVOLVE) \
+    SPECIES(108, "Lickitung", NORMAL, 90, 55, CANNOT_EVOLVE) \
+    SPECIES(109, "Koffing", POISON, 40, 65, CAN_EVOLVE) \
+    SPECIES(110, "Weezing", POISON, 65, 90, CANNOT_EVOLVE) \
+    SPECIES(111, "Rhyhorn", GROUND, 80, 85, CAN_EVOLVE) \
+    SPECIES(112, "Rhydon", GROUND, 105, 130, CANNOT_EVOLVE) \
+    SPECIES(113, "Chansey", NORMAL, 250, 5, CANNOT_EVOLVE) \
+    SPECIES(114, "Tangela", GRASS, 65, 55, CANNOT_EVOLVE) \
+    SPECIES(115, "Kangaskhan", NORMAL, 105, 95, CANNOT_EVOLVE) \
+    SPECIES(116, "Horsea", WATER, 30, 40, CAN_EVOLVE) \
+    SPECIES(117, "Seadra", WATER, 55, 65, CANNOT_EVOLVE) \
+    SPECIES(118, "Goldeen", WATER, 45, 67, CAN_EVOLVE) \
+    SPECIES(119, "Seaking", WATER, 80, 92, CANNOT_EVOLVE) \
+    SPECIES(120, "Staryu", WATER, 30, 45, CAN_EVOLVE) \
+    SPECIES(121, "Starmie", WATER, 60, 75, CANNOT_EVOLVE) \
+    SPECIES(122, "Mr. Mime", PSYCHIC, 40, 45, CANNOT_EVOLVE) \
+    SPECIES(123, "Scyther", BUG, 70, 110, CANNOT_EVOLVE) \
+    SPECIES(124, "Jynx", ICE, 65, 50, CANNOT_EVOLVE) \
+    SPECIES(125, "Electabuzz", ELECTRIC, 65, 83, CANNOT_EVOLVE) \
+    SPECIES(126, "Magmar", FIRE, 65, 95, CANNOT_EVOLVE) \
+    SPECIES(127, "Pinsir", BUG, 65, 125, CANNOT_EVOLVE) \
+    SPECIES(128, "Tauros", NORMAL, 75, 100, CANNOT_EVOLVE) \
+    SPECIES(129, "Magikarp", WATER, 20, 10, CAN_EVOLVE) \
+    SPECIES(130, "Gyarados", WATER, 95, 125, CANNOT_EVOLVE) \
+    SPECIES(131, "Lapras", WATER, 130, 85, CANNOT_EVOLVE) \
+    SPECIES(132, "Ditto", NORMAL, 48, 48, CANNOT_EVOLVE) \
+    SPECIES(133, "Eevee", NORMAL, 55, 55, CAN_EVOLVE) \
+    SPECIES(134, "Vaporeon", WATER, 130, 65, CANNOT_EVOLVE) \
+    SPECIES(135, "Jolteon", ELECTRIC, 65, 65, CANNOT_EVOLVE) \
+    SPECIES(136, "Flareon", FIRE, 65, 130, CANNOT_EVOLVE) \
+    SPECIES(137, "Porygon", NORMAL, 65, 60, CANNOT_EVOLVE) \
+    SPECIES(138, "Omanyte", ROCK, 35, 40, CAN_EVOLVE) \
+    SPECIES(139, "Omastar", ROCK, 70, 60, CANNOT_EVOLVE) \
+    SPECIES(140, "Kabuto", ROCK, 30, 80, CAN_EVOLVE) \
+    SPECIES(141, "Kabutops", ROCK, 60, 115, CANNOT_EVOLVE) \
+    SPECIES(142, "Aerodactyl", ROCK, 80, 105, CANNOT_EVOLVE) \
+    SPECIES(143, "Snorlax", NORMAL, 160, 110, CANNOT_EVOLVE) \
+    SPECIES(144, "Articuno", ICE, 90, 85, CANNOT_EVOLVE) \
+    SPECIES(145, "Zapdos", ELECTRIC, 90, 90, CANNOT_EVOLVE) \
+    SPECIES(146, "Moltres", FIRE, 90, 100, CANNOT_EVOLVE) \
+    SPECIES(147, "Dratini", DRAGON, 41, 64, CAN_EVOLVE) \
+    SPECIES(148, "Dragonair", DRAGON, 61, 84, CAN_EVOLVE) \
+    SPECIES(149, "Dragonite", DRAGON, 91, 134, CANNOT_EVOLVE) \
+    SPECIES(150, "Mewtwo", PSYCHIC, 106, 110, CANNOT_EVOLVE) \
+    SPECIES(151, "Mew", PSYCHIC, 100, 100, CANNOT_EVOLVE)
+
 // Array of Pokemon data
-static const PokemonData pokedex[] = {
-    {1, "Bulbasaur", GRASS, 45, 49, CAN_EVOLVE},
-    {2, "Ivysaur", GRASS, 60, 62, CAN_EVOLVE},
-    {3, "Venusaur", GRASS, 80, 82, CANNOT_EVOLVE},
-    {4, "Charmander", FIRE, 39, 52, CAN_EVOLVE},
-    {5, "Charmeleon", FIRE, 58, 64, CAN_EVOLVE},
-    {6, "Charizard", FIRE, 78, 84, CANNOT_EVOLVE},
-    {7, "Squirtle", WATER, 44, 48, CAN_EVOLVE},
-    {8, "Wartortle", WATER, 59, 63, CAN_EVOLVE},
-    {9, "Blastoise", WATER, 79, 83, CANNOT_EVOLVE},
-    {10, "Caterpie", BUG, 45, 30, CAN_EVOLVE},
-    {11, "Metapod", BUG, 50, 20, CAN_EVOLVE},
-    {12, "Butterfree", BUG, 60, 45, CANNOT_EVOLVE},
-    {13, "Weedle", BUG, 40, 35, CAN_EVOLVE},
-    {14, "Kakuna", BUG, 45, 25, CAN_EVOLVE},
-    {15, "Beedrill", BUG, 65, 90, CANNOT_EVOLVE},
-    {16, "Pidgey", NORMAL, 40, 45, CAN_EVOLVE},
-    {17, "Pidgeotto", NORMAL, 63, 60, CAN_EVOLVE},
-    {18, "Pidgeot", NORMAL, 83, 80, CANNOT_EVOLVE},
-    {19, "Rattata", NORMAL, 30, 56, CAN_EVOLVE},
-    {20, "Raticate", NORMAL, 55, 81, CANNOT_EVOLVE},
-    {21, "Spearow", NORMAL, 40, 60, CAN_EVOLVE},
-    {22, "Fearow", NORMAL, 65, 90, CANNOT_EVOLVE},
-    {23, "Ekans", POISON, 35, 60, CAN_EVOLVE},
-    {24, "Arbok", POISON, 60, 85, CANNOT_EVOLVE},
-    {25, "Pikachu", ELECTRIC, 35, 55, CAN_EVOLVE},
-    {26, "Raichu", ELECTRIC, 60, 90, CANNOT_EVOLVE},
-    {27, "Sandshrew", GROUND, 50, 75, CAN_EVOLVE},
-    {28, "Sandslash", GROUND, 75, 100, CANNOT_EVOLVE},
-    {29, "NidoranF", POISON, 55, 47, CAN_EVOLVE},
-    {30, "Nidorina", POISON, 70, 62, CAN_EVOLVE},
-    {31, "Nidoqueen", POISON, 90, 92, CANNOT_EVOLVE},
-    {32, "NidoranM", POISON, 46, 57, CAN_EVOLVE},
-    {33, "Nidorino", POISON, 61, 72, CAN_EVOLVE},
-    {34, "Nidoking", POISON, 81, 102, CANNOT_EVOLVE},
-    {35, "Clefairy", FAIRY, 70, 45, CAN_EVOLVE},
-    {36, "Clefable", FAIRY, 95, 70, CANNOT_EVOLVE},
-    {37, "Vulpix", FIRE, 38, 41, CAN_EVOLVE},
-    {38, "Ninetales", FIRE, 73, 76, CANNOT_EVOLVE},
-    {39, "Jigglypuff", NORMAL, 115, 45, CAN_EVOLVE},
-    {40, "Wigglytuff", NORMAL, 140, 70, CANNOT_EVOLVE},
-    {41, "Zubat", POISON, 40, 45, CAN_EVOLVE},
-    {42, "Golbat", POISON, 75, 80, CAN_EVOLVE},
-    {43, "Oddish", GRASS, 45, 50, CAN_EVOLVE},
-    {44, "Gloom", GRASS, 60, 65, CAN_EVOLVE},
-    {45, "Vileplume", GRASS, 75, 80, CANNOT_EVOLVE},
-    {46, "Paras", BUG, 35, 70, CAN_EVOLVE},
-    {47, "Parasect", BUG, 60, 95, CANNOT_EVOLVE},
-    {48, "Venonat", BUG, 60, 55, CAN_EVOLVE},
-    {49, "Venomoth", BUG, 70, 65, CANNOT_EVOLVE},
-    {50, "Diglett", GROUND, 10, 55, CAN_EVOLVE},
-    {51, "Dugtrio", GROUND, 35, 80, CANNOT_EVOLVE},
-    {52, "Meowth", NORMAL, 40, 45, CAN_EVOLVE},
-    {53, "Persian", NORMAL, 65, 70, CANNOT_EVOLVE},
-    {54, "Psyduck", WATER, 50, 52, CAN_EVOLVE},
-    {55, "Golduck", WATER, 80, 82, CANNOT_EVOLVE},
-    {56, "Mankey", FIGHTING, 40, 80, CAN_EVOLVE},
-    {57, "Primeape", FIGHTING, 65, 105, CANNOT_EVOLVE},
-    {58, "Growlithe", FIRE, 55, 70, CAN_EVOLVE},
-    {59, "Arcanine", FIRE, 90, 110, CANNOT_EVOLVE},
-    {60, "Poliwag", WATER, 40, 50, CAN_EVOLVE},
-    {61, "Poliwhirl", WATER, 65, 65, CAN_EVOLVE},
-    {62, "Poliwrath", WATER, 90, 95, CANNOT_EVOLVE},
-    {63, "Abra", PSYCHIC, 25, 20, CAN_EVOLVE},
-    {64, "Kadabra", PSYCHIC, 40, 35, CAN_EVOLVE},
-    {65, "Alakazam", PSYCHIC, 55, 50, CANNOT_EVOLVE},
-    {66, "Machop", FIGHTING, 70, 80, CAN_EVOLVE},
-    {67, "Machoke", FIGHTING, 80, 100, CAN_EVOLVE},
-    {68, "Machamp", FIGHTING, 90, 130, CANNOT_EVOLVE},
-    {69, "Bellsprout", GRASS, 50, 75, CAN_EVOLVE},
-    {70, "Weepinbell", GRASS, 65, 90, CAN_EVOLVE},
-    {71, "Victreebel", GRASS, 80, 105, CANNOT_EVOLVE},
-    {72, "Tentacool", WATER, 40, 40, CAN_EVOLVE},
-    {73, "Tentacruel", WATER, 80, 70, CANNOT_EVOLVE},
-    {74, "Geodude", ROCK, 40, 80, CAN_EVOLVE},
-    {75, "Graveler", ROCK, 55, 95, CAN_EVOLVE},
-    {76, "Golem", ROCK, 80, 120, CANNOT_EVOLVE},
-    {77, "Ponyta", FIRE, 50, 85, CAN_EVOLVE},
-    {78, "Rapidash", FIRE, 65, 100, CANNOT_EVOLVE},
-    {79, "Slowpoke", WATER, 90, 65, CAN_EVOLVE},
-    {80, "Slowbro", WATER, 95, 75, CANNOT_EVOLVE},
-    {81, "Magnemite", ELECTRIC, 25, 35, CAN_EVOLVE},
-    {82, "Magneton", ELECTRIC, 50, 60, CANNOT_EVOLVE},
-    {83, "Farfetch'd", NORMAL, 52, 65, CANNOT_EVOLVE},
-    {84, "Doduo", NORMAL, 35, 85, CAN_EVOLVE},
-    {85, "Dodrio", NORMAL, 60, 110, CANNOT_EVOLVE},
-    {86, "Seel", WATER, 65, 45, CAN_EVOLVE},
-    {87, "Dewgong", WATER, 90, 70, CANNOT_EVOLVE},
-    {88, "Grimer", POISON, 80, 80, CAN_EVOLVE},
-    {89, "Muk", POISON, 105, 105, CANNOT_EVOLVE},
-    {90, "Shellder", WATER, 30, 65, CAN_EVOLVE},
-    {91, "Cloyster", WATER, 50, 95, CANNOT_EVOLVE},
-    {92, "Gastly", GHOST, 30, 35, CAN_EVOLVE},
-    {93, "Haunter", GHOST, 45, 50, CAN_EVOLVE},
-    {94, "Gengar", GHOST, 60, 65, CANNOT_EVOLVE},
-    {95, "Onix", ROCK, 35, 45, CANNOT_EVOLVE},
-    {96, "Drowzee", PSYCHIC, 60, 48, CAN_EVOLVE},
-    {97, "Hypno", PSYCHIC, 85, 73, CANNOT_EVOLVE},
-    {98, "Krabby", WATER, 30, 105, CAN_EVOLVE},
-    {99, "Kingler", WATER, 55, 130, CANNOT_EVOLVE},
-    {100, "Voltorb", ELECTRIC, 40, 30, CAN_EVOLVE},
-    {101, "Electrode", ELECTRIC, 60, 50, CANNOT_EVOLVE},
-    {102, "Exeggcute", GRASS, 60, 40, CAN_EVOLVE},
-    {103, "Exeggutor", GRASS, 95, 95, CANNOT_EVOLVE},
-    {104, "Cubone", GROUND, 50, 50, CAN_EVOLVE},
-    {105, "Marowak", GROUND, 60, 80, CANNOT_EVOLVE},
-    {106, "Hitmonlee", FIGHTING, 50, 120, CANNOT_EVOLVE},
-    {107, "Hitmonchan", FIGHTING, 50, 105, CANNOT_EVOLVE},
-    {108, "Lickitung", NORMAL, 90, 55, CANNOT_EVOLVE},
-    {109, "Koffing", POISON, 40, 65, CAN_EVOLVE},
-    {110, "Weezing", POISON, 65, 90, CANNOT_EVOLVE},
-    {111, "Rhyhorn", GROUND, 80, 85, CAN_EVOLVE},
-    {112, "Rhydon", GROUND, 105, 130, CANNOT_EVOLVE},
-    {113, "Chansey", NORMAL, 250, 5, CANNOT_EVOLVE},
-    {114, "Tangela", GRASS, 65, 55, CANNOT_EVOLVE},
-    {115, "Kangaskhan", NORMAL, 105, 95, CANNOT_EVOLVE},
-    {116, "Horsea", WATER, 30, 40, CAN_EVOLVE},
-    {117, "Seadra", WATER, 55, 65, CANNOT_EVOLVE},
-    {118, "Goldeen", WATER, 45, 67, CAN_EVOLVE},
-    {119, "Seaking", WATER, 80, 92, CANNOT_EVOLVE},
-    {120, "Staryu", WATER, 30, 45, CAN_EVOLVE},
-    {121, "Starmie", WATER, 60, 75, CANNOT_EVOLVE},
-    {122, "Mr. Mime", PSYCHIC, 40, 45, CANNOT_EVOLVE},
-    {123, "Scyther", BUG, 70, 110, CANNOT_EVOLVE},
-    {124, "Jynx", ICE, 65, 50, CANNOT_EVOLVE},
-    {125, "Electabuzz", ELECTRIC, 65, 83, CANNOT_EVOLVE},
-    {126, "Magmar", FIRE, 65, 95, CANNOT_EVOLVE},
-    {127, "Pinsir", BUG, 65, 125, CANNOT_EVOLVE},
-    {128, "Tauros", NORMAL, 75, 100, CANNOT_EVOLVE},
-    {129, "Magikarp", WATER, 20, 10, CAN_EVOLVE},
-    {130, "Gyarados", WATER, 95, 125, CANNOT_EVOLVE},
-    {131, "Lapras", WATER, 130, 85, CANNOT_EVOLVE},
-    {132, "Ditto", NORMAL, 48, 48, CANNOT_EVOLVE},
-    {133, "Eevee", NORMAL, 55, 55, CAN_EVOLVE},
-    {134, "Vaporeon", WATER, 130, 65, CANNOT_EVOLVE},
-    {135, "Jolteon", ELECTRIC, 65, 65, CANNOT_EVOLVE},
-    {136, "Flareon", FIRE, 65, 130, CANNOT_EVOLVE},
-    {137, "Porygon", NORMAL, 65, 60, CANNOT_EVOLVE},
-    {138, "Omanyte", ROCK, 35, 40, CAN_EVOLVE},
-    {139, "Omastar", ROCK, 70, 60, CANNOT_EVOLVE},
-    {140, "Kabuto", ROCK, 30, 80, CAN_EVOLVE},
-    {141, "Kabutops", ROCK, 60, 115, CANNOT_EVOLVE},
-    {142, "Aerodactyl", ROCK, 80, 105, CANNOT_EVOLVE},
-    {143, "Snorlax", NORMAL, 160, 110, CANNOT_EVOLVE},
-    {144, "Articuno", ICE, 90, 85, CANNOT_EVOLVE},
-    {145, "Zapdos", ELECTRIC, 90, 90, CANNOT_EVOLVE},
-    {146, "Moltres", FIRE, 90, 100, CANNOT_EVOLVE},
-    {147, "Dratini", DRAGON, 41, 64, CAN_EVOLVE},
-    {148, "Dragonair", DRAGON, 61, 84, CAN_EVOLVE},
-    {149, "Dragonite", DRAGON, 91, 134, CANNOT_EVOLVE},
-    {150, "Mewtwo", PSYCHIC, 106, 110, CANNOT_EVOLVE},
-    {151, "Mew", PSYCHIC, 100, 100, CANNOT_EVOLVE}};
+#define SPECIES_RECORD(id, name, type, hp, attack, canEvolve) {id, name, type, hp, attack, canEvolve},
+static const PokemonData pokedex[] = { BUILTIN_SPECIES(SPECIES_RECORD) };
+
+// The same species as columns
+#define SPECIES_ID(id, name, type, hp, attack, canEvolve) id,
+#define SPECIES_TYPE(id, name, type, hp, attack, canEvolve) type,
+#define SPECIES_HP(id, name, type, hp, attack, canEvolve) hp,
+#define SPECIES_ATTACK(id, name, type, hp, attack, canEvolve) attack,
+#define SPECIES_CAN_EVOLVE(id, name, type, hp, attack, canEvolve) canEvolve,
+static const int32_t pokedexIds[] = { BUILTIN_SPECIES(SPECIES_ID) };
+static const uint8_t pokedexTypes[] = { BUILTIN_SPECIES(SPECIES_TYPE) };
+static const int32_t pokedexHp[] = { BUILTIN_SPECIES(SPECIES_HP) };
+static const int32_t pokedexAttack[] = { BUILTIN_SPECIES(SPECIES_ATTACK) };
+static const uint8_t pokedexCanEvolve[] = { BUILTIN_SPECIES(SPECIES_CAN_EVOLVE) };
+
+// The built-in table as a catalog: IDs 1..151 are contiguous, so it needs no index
+#define BUILTIN_SPECIES_CATALOG                                                                      \
+    { pokedexIds, pokedexTypes, pokedexHp, pokedexAttack, pokedexCanEvolve, pokedex, SPECIES_COUNT, 1, \
+      SPECIES_COUNT, NULL, NULL, 0, NULL, NULL, NULL, NULL, NULL }
+
+// The catalog every species lookup goes through (--species replaces it at startup)
+SpeciesCatalog speciesCatalog = BUILTIN_SPECIES_CATALOG;
 
 #endif // EX6_H